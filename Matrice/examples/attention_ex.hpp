@@ -0,0 +1,92 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <algs/dnn/models/_attention_kernel.hpp>
+#include "bench_helper.hpp"
+
+DGE_MATRICE_BEGIN
+namespace example {
+
+/// <summary>
+/// \brief Benchmark of multi-head attention, which compares the fused
+/// kernel dnn::attention with a reference that forms the full score
+/// matrix of each head. It also reports the score memory of the reference,
+/// which the fused kernel avoids.
+/// </summary>
+/// <typeparam name="_Ty">Value type, float or double</typeparam>
+/// <param name="'len'">: Sequence length, e.g. number of descriptors.</param>
+/// <param name="'heads', 'dim'">: Number of heads and the head dim.</param>
+template<typename _Ty>
+void bench_attention(size_t len, size_t heads = 4, size_t dim = 32, size_t nruns = 3) {
+	const auto cols = heads * dim;
+
+	Matrix<_Ty> Q(len, cols), K(len, cols), V(len, cols), O;
+	std::mt19937 rng(0);
+	std::normal_distribution<_Ty> n;
+	for (size_t i = 0; i < Q.size(); ++i) {
+		Q(i) = n(rng), K(i) = n(rng), V(i) = n(rng);
+	}
+
+	const auto t_fused = bench_best_time(nruns, [&] { O = dnn::attention(Q, K, V, heads); });
+
+	std::vector<_Ty> S(len * len), O_ref(len * cols);
+	const auto scale = _Ty(1) / sqrt(_Ty(dim));
+	const auto t_ref = bench_best_time(nruns, [&] {
+		for (size_t h = 0; h < heads; ++h) {
+			for (size_t i = 0; i < len; ++i) {
+				const auto s = S.data() + i * len;
+				auto smax = std::numeric_limits<_Ty>::lowest(), ssum = _Ty(0);
+				for (size_t j = 0; j < len; ++j) {
+					auto t = _Ty(0);
+					for (size_t d = 0; d < dim; ++d)
+						t += Q[i][h * dim + d] * K[j][h * dim + d];
+					s[j] = t * scale, smax = max(smax, s[j]);
+				}
+				for (size_t j = 0; j < len; ++j) ssum += s[j] = exp(s[j] - smax);
+				for (size_t d = 0; d < dim; ++d) {
+					auto o = _Ty(0);
+					for (size_t j = 0; j < len; ++j) o += s[j] * V[j][h * dim + d];
+					O_ref[i * cols + h * dim + d] = o / ssum;
+				}
+			}
+		}
+	});
+
+	auto maxdiff = zero<_Ty>;
+	for (size_t i = 0; i < O.size(); ++i) {
+		maxdiff = max(maxdiff, abs(O(i) - O_ref[i]));
+	}
+
+	bench_report("dense", t_ref, "fused", t_fused, maxdiff, {},
+		"scores: " + std::to_string(S.size() * sizeof(_Ty) >> 20) + "MB ");
+}
+
+/// <summary>
+/// \brief Run the attention benchmark in both precisions.
+/// </summary>
+inline void bench_attentions(size_t len = 4096) {
+	bench_attention<float>(len);
+	bench_attention<double>(len);
+}
+
+}
+DGE_MATRICE_END
@@ -18,6 +18,7 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include <valarray>
 #include <private/autograd/_ad_exps.h>
+#include <private/autograd/_ad_tape.hpp>
 
 DGE_MATRICE_BEGIN
 namespace example {
@@ -37,5 +38,35 @@ void autodiff_test() {
 	value = f();
 	df = f.deriv();
 }
+
+void autodiff_tape_test() {
+	// Record the leaves once: rotation R, point X and focal length f.
+	ade::tape<double> t;
+	const double r[] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, x[] = { 0.1, -0.2, 5. };
+	auto R = t.variable(3, 3, r);
+	auto X = t.variable(3, 1, x);
+	auto f = t.variable(1000.);
+	const auto leaves = t.checkpoint();
+
+	double J[2 * 3];
+	for (auto it = 0; it < 10; ++it) {
+		// Drop the residuals of the last iteration, the arenas are reused.
+		t.rewind(leaves);
+
+		// Projection residual u = f*Y_x/Y_z, v = f*Y_y/Y_z with Y = R*X.
+		const auto Y = R.mul(X);
+		const auto res = t.stack({ f * Y(0) / Y(2), f * Y(1) / Y(2) });
+
+		// Jacobian d(res)/dX, one backward sweep per residual.
+		t.jacobian(res, X, J);
+
+		// Gradients of the squared residual w.r.t. all leaves at once.
+		t.backward(res.sqnorm());
+		// A descent step on the focal length with its gradient.
+		f.value() -= 1e-7 * f.grad();
+
+		X(2).value() += 0.1;
+	}
+}
 }
 DGE_MATRICE_END
\ No newline at end of file
@@ -0,0 +1,67 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <util/_macros.h>
+
+DGE_MATRICE_BEGIN
+namespace example {
+
+/// <summary>
+/// \brief Best wall time of 'nruns' calls of 'op' in milliseconds.
+/// </summary>
+template<typename _Op>
+double bench_best_time(size_t nruns, _Op&& op) {
+	using clock_t = std::chrono::steady_clock;
+	auto best = std::numeric_limits<double>::max();
+	for (size_t i = 0; i < nruns; ++i) {
+		const auto start = clock_t::now();
+		op();
+		const std::chrono::duration<double, std::milli> dt = clock_t::now() - start;
+		best = (std::min)(best, dt.count());
+	}
+	return best;
+}
+
+/// <summary>
+/// \brief Print a line of a benchmark that compares an optimized path with
+/// a reference one, with their timings, the speedup and the max. error.
+/// </summary>
+/// <typeparam name="_Ty">Value type, float or double</typeparam>
+/// <param name="'ref', 'opt'">: Names of the reference and optimized paths.</param>
+/// <param name="'label'">: Optional leading column, e.g. a kernel name.</param>
+/// <param name="'extra'">: Optional text printed before the max. error.</param>
+template<typename _Ty>
+void bench_report(const std::string& ref, double t_ref, const std::string& opt,
+	double t_opt, _Ty maxdiff, const std::string& label = {}, const std::string& extra = {}) {
+	std::cout << std::setiosflags(std::ios::left);
+	if (!label.empty()) std::cout << std::setw(12) << label << " ";
+	std::cout << std::setw(8) << (sizeof(_Ty) == 4 ? "f32" : "f64")
+		<< ref << ": " << std::setw(10) << t_ref << "ms "
+		<< opt << ": " << std::setw(10) << t_opt << "ms "
+		<< "speedup: " << std::setw(8) << t_ref / t_opt << " "
+		<< extra << "max|diff|: " << maxdiff << "\n";
+}
+
+}
+DGE_MATRICE_END
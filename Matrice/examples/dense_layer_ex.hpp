@@ -0,0 +1,99 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <algs/dnn/modules.h>
+#include "bench_helper.hpp"
+
+DGE_MATRICE_BEGIN
+namespace example {
+
+/// <summary>
+/// \brief Benchmark of a two-layer MLP, tanh(X*W1+b1)*W2+b2, which times
+/// the batched forward pass with the bias and tanh fused in the GEMM
+/// epilogue against the expression path evaluated sample by sample, and
+/// a full training step (forward, MSE backward and descent update) that
+/// runs on the preallocated gradient buffers of the layers.
+/// </summary>
+/// <typeparam name="_Ty">Value type, float or double</typeparam>
+/// <param name="'batch'">: Number of samples in a batch.</param>
+/// <param name="'nruns'">: Number of timed runs of each path.</param>
+template<typename _Ty, int _In = 64, size_t _Hid = 128, size_t _Out = 10>
+void bench_dense_mlp(size_t batch = 256, size_t nruns = 20) {
+	using input_t = dnn::input_layer<Matrix_<_Ty, 1, _In>>;
+	using hidden_t = dnn::input_layer<Matrix_<_Ty, 1, int(_Hid)>>;
+	using layer1_t = dnn::linear_layer<input_t, _Hid, true>;
+	using layer2_t = dnn::linear_layer<hidden_t, _Out, true>;
+	using act_t = dnn::functional::tanh;
+
+	auto l1 = std::make_unique<layer1_t>();
+	auto l2 = std::make_unique<layer2_t>();
+
+	std::vector<_Ty> X(batch * _In), T(batch * _Out);
+	std::vector<_Ty> H(batch * _Hid), Y(batch * _Out), Y_ref(batch * _Out);
+	std::vector<_Ty> dH(batch * _Hid), dY(batch * _Out);
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<_Ty> u(-1, 1);
+	for (auto& x : X) x = u(rng);
+	for (auto& t : T) t = u(rng);
+
+	const auto t_fused = bench_best_time(nruns, [&] {
+		l1->template forward<act_t>(batch, X.data(), H.data());
+		l2->forward(batch, H.data(), Y.data());
+	});
+	const auto t_expr = bench_best_time(nruns, [&] {
+		for (size_t b = 0; b < batch; ++b) {
+			const input_t x(Matrix_<_Ty, 1, _In>(X.data() + b * _In));
+			const hidden_t h(act_t::forward(l1->forward(x)));
+			const auto y = l2->forward(h);
+			for (size_t j = 0; j < _Out; ++j) Y_ref[b * _Out + j] = y(j);
+		}
+	});
+
+	auto maxdiff = zero<_Ty>;
+	for (size_t i = 0; i < Y.size(); ++i) {
+		maxdiff = max(maxdiff, abs(Y[i] - Y_ref[i]));
+	}
+
+	const auto t_step = bench_best_time(nruns, [&] {
+		l1->template forward<act_t>(batch, X.data(), H.data());
+		l2->forward(batch, H.data(), Y.data());
+		for (size_t i = 0; i < Y.size(); ++i) dY[i] = (Y[i] - T[i]) / _Ty(batch);
+		l2->backward(batch, H.data(), Y.data(), dY.data(), dH.data());
+		l1->template backward<act_t>(batch, X.data(), H.data(), dH.data());
+		l2->update(_Ty(0.01));
+		l1->update(_Ty(0.01));
+	});
+
+	bench_report("expr fwd", t_expr, "fused fwd", t_fused, maxdiff,
+		{}, "train step: " + std::to_string(t_step) + "ms ");
+}
+
+/// <summary>
+/// \brief Run the MLP benchmark in both precisions.
+/// </summary>
+inline void bench_dense_mlps(size_t batch = 256) {
+	bench_dense_mlp<float>(batch);
+	bench_dense_mlp<double>(batch);
+}
+
+}
+DGE_MATRICE_END
@@ -43,6 +43,8 @@ try {
 	const auto path = apath.append(dfolder);
 	auto image_loader = dgelom::make_loader(path,
 		dgelom::io::tiff<raw_image_t::value_t>());
+	///\brief Decode the next frames while the current one is processed.
+	image_loader.prefetch(4);
 
 	///\brief Get reference image info.
 	const auto ref_image = image_loader.forward().front();
@@ -128,9 +130,7 @@ try {
 
 	csv.reset(path.parent_path().append("res\\disp_4pts_0.0005.csv"));
 	csv.open(dgelom::IO::app);
-	for (auto row = disp_x.rwbegin(); row != disp_x.rwend(); ++row) {
-		csv.append(row.begin(), row.end());
-	}
+	csv.write(disp_x);
 	csv.close();
 
 	std::cout << " >> [Matrice message] finish for scale " + dgelom::str(loss_scale) + "\n";
@@ -0,0 +1,89 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <random>
+#include <algs/stereovision/refractive3D/_refractive3d_funcs.h>
+#include <algs/stereovision/refractive3D/_refractive3d.h>
+#include "bench_helper.hpp"
+
+DGE_MATRICE_BEGIN
+namespace example {
+
+/// <summary>
+/// \brief Benchmark of refractive 3D reconstruction, which compares the
+/// batched path of vision::refractive_reconstruction with the function
+/// template vision::refractive_3d_reconstruction called point by point.
+/// The left camera is at the origin and the right one at '-t', as the
+/// function template assumes.
+/// </summary>
+/// <typeparam name="_Ty">Value type, float or double</typeparam>
+/// <param name="'npts'">: Number of points, e.g. 500k for a DIC frame.</param>
+/// <param name="'nruns'">: Number of timed runs of each path.</param>
+template<typename _Ty>
+void bench_refractive_reconstruction(size_t npts, size_t nruns = 5) {
+	using engine_t = vision::refractive_reconstruction<_Ty>;
+	using vec3_t = auto_vector_t<_Ty, 3>;
+	using vec4_t = auto_vector_t<_Ty, 4>;
+
+	// \interface N^T*X = D with a glass plate of thickness d
+	const _Ty nx = 0.1, ny = -0.05, nz = 1, D = 300, d = 10;
+	const vec3_t t(-200, 5, 10);
+	const auto s = sqrt(sqsum(nx, ny, nz));
+	const vec4_t plane(nx, ny, nz, -D * s);
+	const auto n1 = _Ty(vision::air2glass_tag::n1);
+	const auto n2 = _Ty(vision::air2glass_tag::n2);
+	const auto n3 = _Ty(vision::glass2water_tag::n2);
+
+	engine_t engine(typename engine_t::interface_type(nx, ny, nz, D, d));
+	engine.set_t(vec3_t(-t.x, -t.y, -t.z));
+
+	// \distorted points triangulated behind the interface
+	Matrix<_Ty> P(3, npts), Q, Q_ref(3, npts);
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<_Ty> uxy(-100, 100), uz(400, 800);
+	for (size_t i = 0; i < npts; ++i) {
+		P[0][i] = uxy(rng), P[1][i] = uxy(rng), P[2][i] = uz(rng);
+	}
+
+	const auto t_batch = bench_best_time(nruns, [&] { Q = engine.compute(P); });
+	const auto t_ref = bench_best_time(nruns, [&] {
+		for (size_t i = 0; i < npts; ++i) {
+			const auto q = vision::refractive_3d_reconstruction<_Ty>(
+				vec3_t(P[0][i], P[1][i], P[2][i]), t, plane, d, n1, n2, n3);
+			Q_ref[0][i] = q.x, Q_ref[1][i] = q.y, Q_ref[2][i] = q.z;
+		}
+	});
+
+	auto maxdiff = zero<_Ty>;
+	for (size_t i = 0; i < Q.size(); ++i) {
+		maxdiff = max(maxdiff, abs(Q(i) - Q_ref(i)));
+	}
+
+	bench_report("funcs", t_ref, "batch", t_batch, maxdiff);
+}
+
+/// <summary>
+/// \brief Run the refractive reconstruction benchmark in both precisions.
+/// </summary>
+inline void bench_refractive_reconstructions(size_t npts = 500000) {
+	bench_refractive_reconstruction<float>(npts);
+	bench_refractive_reconstruction<double>(npts);
+}
+
+}
+DGE_MATRICE_END
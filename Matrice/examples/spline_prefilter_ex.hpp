@@ -0,0 +1,81 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <memory>
+#include <typeinfo>
+#include <vector>
+#include <algs/interpolation.h>
+#include "bench_helper.hpp"
+
+DGE_MATRICE_BEGIN
+namespace example {
+
+/// <summary>
+/// \brief Benchmark of the B-spline prefilter, which times the tiled path
+/// through the public interpolation<_Ty, _Tag>(data) against the reference
+/// row/column recursion of the same kernel (_Coeff_ref). The error is the
+/// max. residual of the interpolated values at the interior nodes, which
+/// must reproduce the data for any spline kernel.
+/// </summary>
+/// <typeparam name="_Ty">Value type, float or double</typeparam>
+/// <typeparam name="_Tag">bicerp_tag, biqerp_tag or biserp_tag</typeparam>
+/// <param name="'rows, cols'">: Image size, e.g. 5120 x 5120 for 25 MP.</param>
+/// <param name="'nruns'">: Number of timed runs of each path.</param>
+template<typename _Ty, typename _Tag>
+void bench_spline_prefilter(size_t rows, size_t cols, size_t nruns = 5) {
+	using interp_t = interpolation<_Ty, _Tag>;
+	const auto data = Matrix<_Ty>::rand(rows, cols);
+
+	std::unique_ptr<interp_t> itp;
+	const auto t_tiled = bench_best_time(nruns, [&] { itp = std::make_unique<interp_t>(data); });
+	Matrix<_Ty> ref;
+	const auto t_ref = bench_best_time(nruns, [&] { ref = itp->_Coeff_ref(); });
+
+	// \interpolate at the interior nodes, away from the border.
+	constexpr size_t margin = 4;
+	std::vector<_Ty> xs, ys;
+	for (auto r = margin; r + margin < rows; ++r) {
+		for (auto c = margin; c + margin < cols; ++c) {
+			xs.push_back(_Ty(c)), ys.push_back(_Ty(r));
+		}
+	}
+	std::vector<_Ty> vals(xs.size());
+	itp->eval_batch(xs, ys, vals);
+
+	auto maxdiff = zero<_Ty>;
+	for (size_t i = 0; i < vals.size(); ++i) {
+		maxdiff = max(maxdiff, abs(vals[i] - data[size_t(ys[i])][size_t(xs[i])]));
+	}
+
+	bench_report("ref", t_ref, "tiled", t_tiled, maxdiff, typeid(_Tag).name());
+}
+
+/// <summary>
+/// \brief Run the prefilter benchmark for all spline kernels.
+/// </summary>
+inline void bench_spline_prefilters(size_t rows = 5120, size_t cols = 5120) {
+	bench_spline_prefilter<float, bicerp_tag>(rows, cols);
+	bench_spline_prefilter<float, biqerp_tag>(rows, cols);
+	bench_spline_prefilter<float, biserp_tag>(rows, cols);
+	bench_spline_prefilter<double, bicerp_tag>(rows, cols);
+	bench_spline_prefilter<double, biqerp_tag>(rows, cols);
+	bench_spline_prefilter<double, biserp_tag>(rows, cols);
+}
+
+}
+DGE_MATRICE_END
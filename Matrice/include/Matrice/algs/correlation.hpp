@@ -17,6 +17,8 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 #pragma once
 #include "correlation/_optim.h"
+#include "correlation/_rg_scheduler.h"
+#include "correlation/_optim_batch.h"
 
 DGE_MATRICE_BEGIN
 struct correlation_optimizer {
@@ -93,5 +95,23 @@ struct correlation_optimizer {
 	template<typename _Ty>
 	using icgn_bis_1 = corr::detail::_Corr_solver_impl<_Ty,
 		biserp_tag, corr::detail::_Alg_icgn<1>>;
+
+	/**
+	 *\brief Batched N-th order IC-GN algorithm, which solves many POIs per
+	 *		  call with SoA buffers vectorized across subsets.
+	 *\param <_Ty> must be a scalar type of float or double.
+	 *\param <_Order> order of the shape function, 0 or 1.
+	 */
+	template<typename _Ty, typename _Itag = bicerp_tag, uint8_t _Order = 1>
+	using icgn_batch = corr::detail::_Corr_batch_solver<_Ty,
+		_Itag, corr::detail::_Alg_icgn<_Order>>;
+
+	/**
+	 *\brief Reliability-guided propagation scheduler, which drives one of
+	 *		  the above IC-GN solvers over a regular grid of nodes.
+	 *\param <_Solver> must be an IC-GN solver type, e.g. icgn_bic_1<float>.
+	 */
+	template<typename _Solver>
+	using rg_scheduler = corr::detail::_Corr_rg_scheduler<_Solver>;
 };
 DGE_MATRICE_END
\ No newline at end of file
@@ -0,0 +1,173 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <vector>
+#include "core/matrix.h"
+#include "core/vector.h"
+#include "../transform/_fft_engine.hpp"
+
+MATRICE_ALG_BEGIN(corr)
+_DETAIL_BEGIN
+
+/// <summary>
+/// \brief CLASS TEMPLATE, search window of the current image for the FFT
+/// based initial guess. The spectrum and the integral images of the window
+/// are computed once, so that the ZNCC map of any subset lying in it costs a
+/// pair of FFTs regardless of the number of candidate positions. A window is
+/// read-only after construction and can be shared by neighbouring POIs.
+/// </summary>
+/// <typeparam name="_Ty">Scalar, primitive value type</typeparam>
+template<typename _Ty>
+class _Corr_fft_window {
+	using _Myt = _Corr_fft_window;
+public:
+	using value_type = _Ty;
+	using matrix_type = Matrix<value_type>;
+	using point_type = Vec2_<value_type>;
+	using engine_type = fft_engine<value_type>;
+
+	/**
+	 *\brief Build a window of image '_Img', which covers the pixels in
+	          [_X0, _X1) x [_Y0, _Y1). It is enlarged to fast FFT sizes
+	          as far as the image allows.
+	 */
+	_Corr_fft_window(const matrix_type& _Img, index_t _X0, index_t _Y0, index_t _X1, index_t _Y1) {
+		const auto [_Rows, _Cols] = _Img.shape().tile();
+		_Fit(_X0, _X1, index_t(_Cols), _Myx, _Mycols);
+		_Fit(_Y0, _Y1, index_t(_Rows), _Myy, _Myrows);
+
+		// \integral images of intensities and squared intensities
+		MATRICE_STD(vector)<value_type> _Data(_Myrows * _Mycols);
+		_Mysum.assign((_Myrows + 1) * (_Mycols + 1), 0.);
+		_Mysqsum.assign((_Myrows + 1) * (_Mycols + 1), 0.);
+		const auto _Ld = _Mycols + 1;
+		for (size_t r = 0; r < _Myrows; ++r) {
+			const auto _Src = _Img[_Myy + r] + _Myx;
+			auto _Rs = 0., _Rq = 0.;
+			for (size_t c = 0; c < _Mycols; ++c) {
+				const auto _Val = _Data[r * _Mycols + c] = _Src[c];
+				_Rs += _Val, _Rq += double(_Val) * _Val;
+				_Mysum[(r + 1) * _Ld + c + 1] = _Mysum[r * _Ld + c + 1] + _Rs;
+				_Mysqsum[(r + 1) * _Ld + c + 1] = _Mysqsum[r * _Ld + c + 1] + _Rq;
+			}
+		}
+
+		const auto _Bins = _Myrows * (_Mycols / 2 + 1);
+		_Myspec.resize(_Bins << 1);
+		engine_type::r2c_2d(_Data.data(), _Myspec.data(), _Myspec.data() + _Bins, _Myrows, _Mycols);
+	}
+
+	/**
+	 *\brief Check if the pixels in [_X0, _X1) x [_Y0, _Y1) lie in the window.
+	 */
+	MATRICE_HOST_INL bool contains(index_t _X0, index_t _Y0, index_t _X1, index_t _Y1) const noexcept {
+		return _X0 >= _Myx && _Y0 >= _Myy &&
+			_X1 <= _Myx + index_t(_Mycols) && _Y1 <= _Myy + index_t(_Myrows);
+	}
+
+	/**
+	 *\brief Search the ZNCC peak of a zero-mean and unit-norm template '_Tmp'
+	          with '_Size' x '_Size' pixels, whose centre runs over the integer
+	          positions in [_X0, _X1) x [_Y0, _Y1) of the image. The subsets
+	          must lie in the window.
+	 *\return [sub-pixel centre of the peak, ZNCC at the integer peak].
+	 */
+	MATRICE_HOST_INL auto match(const value_type* _Tmp, index_t _Size,
+		index_t _X0, index_t _Y0, index_t _X1, index_t _Y1) const {
+		const auto _Bins = _Myrows * (_Mycols / 2 + 1);
+		MATRICE_STD(vector)<value_type> _Corr(_Myrows * _Mycols, value_type(0));
+		for (index_t r = 0; r < _Size; ++r) {
+			MATRICE_STD(copy)(_Tmp + r * _Size, _Tmp + (r + 1) * _Size, _Corr.data() + r * _Mycols);
+		}
+
+		// \cross-power spectrum W * conj(T), then back to the correlation map
+		MATRICE_STD(vector)<value_type> _Spec(_Bins << 1);
+		const auto _Tr = _Spec.data(), _Ti = _Spec.data() + _Bins;
+		engine_type::r2c_2d(_Corr.data(), _Tr, _Ti, _Myrows, _Mycols);
+		const auto _Wr = _Myspec.data(), _Wi = _Myspec.data() + _Bins;
+		for (size_t k = 0; k < _Bins; ++k) {
+			const auto _Re = _Wr[k] * _Tr[k] + _Wi[k] * _Ti[k];
+			const auto _Im = _Wi[k] * _Tr[k] - _Wr[k] * _Ti[k];
+			_Tr[k] = _Re, _Ti[k] = _Im;
+		}
+		engine_type::c2r_2d(_Tr, _Ti, _Corr.data(), _Myrows, _Mycols);
+
+		// \ZNCC of the subset with top-left {u, v} in the window
+		const auto _Scale = 1. / double(_Myrows * _Mycols);
+		const auto _Inv_n = 1. / double(_Size * _Size);
+		const auto _Ld = _Mycols + 1;
+		const auto _Zncc = [&](index_t u, index_t v) {
+			const auto _Box = [&](const MATRICE_STD(vector)<double>& _S) {
+				return _S[(v + _Size) * _Ld + u + _Size] - _S[v * _Ld + u + _Size]
+					- _S[(v + _Size) * _Ld + u] + _S[v * _Ld + u];
+			};
+			const auto _Sum = _Box(_Mysum);
+			const auto _Var = _Box(_Mysqsum) - _Sum * _Sum * _Inv_n;
+			return _Var > MATRICE_STD(numeric_limits)<value_type>::epsilon() ?
+				value_type(_Corr[v * _Mycols + u] * _Scale / MATRICE_STD(sqrt)(_Var)) : value_type(0);
+		};
+
+		const auto _R = _Size >> 1;
+		index_t _U = _X0 - _R - _Myx, _V = _Y0 - _R - _Myy;
+		auto _Max = _Zncc(_U, _V);
+		for (auto y = _Y0; y < _Y1; ++y) {
+			for (auto x = _X0; x < _X1; ++x) {
+				const auto u = x - _R - _Myx, v = y - _R - _Myy;
+				const auto _Coeff = _Zncc(u, v);
+				if (_Coeff > _Max) {
+					_Max = _Coeff;
+					_U = u, _V = v;
+				}
+			}
+		}
+
+		// \sub-pixel peak by parabola fitting along x and y
+		const auto _Umax = index_t(_Mycols) - _Size, _Vmax = index_t(_Myrows) - _Size;
+		const auto _Peak = [&](index_t i, index_t _Imax, auto&& _Fn) {
+			if (i <= 0 || i >= _Imax) return value_type(0);
+			const auto _L = _Fn(i - 1), _H = _Fn(i + 1);
+			const auto _Den = _L - 2 * _Max + _H;
+			if (_Den >= 0) return value_type(0);
+			return (MATRICE_STD(clamp))((_L - _H) / (2 * _Den), value_type(-0.5), value_type(0.5));
+		};
+		const auto _Dx = _Peak(_U, _Umax, [&](index_t u) { return _Zncc(u, _V); });
+		const auto _Dy = _Peak(_V, _Vmax, [&](index_t v) { return _Zncc(_U, v); });
+
+		const point_type _Pos(value_type(_U + _R + _Myx) + _Dx, value_type(_V + _R + _Myy) + _Dy);
+		return tuple<point_type, value_type>(_Pos, _Max);
+	}
+
+private:
+	/**
+	 *\brief Fit the range [_Lo, _Hi) into a line of '_N' pixels with a fast size.
+	 */
+	static MATRICE_HOST_INL void _Fit(index_t _Lo, index_t _Hi, index_t _N, index_t& _Org, size_t& _Len) noexcept {
+		const auto _Need = _Hi - _Lo;
+		const auto _Good = (MATRICE_STD(min))(index_t(engine_type::good_size(_Need)), _N);
+		_Org = (MATRICE_STD(clamp))(_Lo - ((_Good - _Need) >> 1), index_t(0), _N - _Good);
+		_Len = size_t(_Good);
+	}
+
+	index_t _Myx = 0, _Myy = 0;
+	size_t  _Myrows = 0, _Mycols = 0;
+	MATRICE_STD(vector)<value_type> _Myspec;
+	MATRICE_STD(vector)<double> _Mysum, _Mysqsum;
+};
+
+_DETAIL_END
+MATRICE_ALG_END(corr)
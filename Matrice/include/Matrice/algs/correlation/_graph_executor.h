@@ -18,9 +18,12 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 **********************************************************************/
 #pragma once
 
+#include <map>
 #include <vector>
-#include "_correlation_traits.h"
-#include "core/image.h"
+#include <future>
+#include <functional>
+#include "_optim.h"
+#include "thread/_task_pool.h"
 
 MATRICE_ALG_BEGIN(corr)
 _DETAIL_BEGIN
@@ -35,21 +38,132 @@ class _Corr_layer
 	using _Myt = _Corr_layer<_Ty, _Pre>;
 public:
 	using value_type = _Ty;
+	using matrix_type = Matrix<value_type>;
+	using point_type = Vec2_<value_type>;
+	// Smooth image type, which is shared with the correlation solvers.
+	using smooth_image_t = interpolation<value_type, _Pre>;
+	using loader_type = MATRICE_STD(function)<matrix_type()>;
+	// Read-only gradient cache, built once when the layer is a reference.
+	using cache_type = _Corr_ref_cache<value_type, _Pre>;
+
 	// Define status of a correlation layer
 	struct status {
 		bool processed = false;
 		bool active = true;
 	};
 
+	_Corr_layer() noexcept = default;
+	/**
+	 * \brief CTOR, attach a deferred image loader to the layer.
+	 */
+	template<typename _Loader>
+	requires MATRICE_STD(is_invocable_v)<_Loader>
+	_Corr_layer(_Loader&& op) 
+		: _Myloader(MATRICE_STD(forward)<_Loader>(op)) {
+	}
+
 	/**
 	 * \brief METHOD, load image data.
 	 */
 	template<typename _Loader>
-	_Myt& load(_Loader op) noexcept {
-		auto _Img = op();
-		_Mydata = image_t<value_type, _Pre>(_Img);
+	_Myt& load(_Loader op) {
+		_Mydata = MATRICE_STD(make_shared)<smooth_image_t>(op());
+		_Mycache.reset();
+		return (*this);
+	}
+	/**
+	 * \brief METHOD, load image data with the attached loader. 
+	 * It does nothing if the layer has been loaded.
+	 */
+	_Myt& load() {
+		if (!_Mydata && _Myloader) {
+			_Mydata = MATRICE_STD(make_shared)<smooth_image_t>(_Myloader());
+		}
+		return (*this);
+	}
+
+	/**
+	 * \brief METHOD, attach a deferred image loader.
+	 */
+	template<typename _Loader>
+	_Myt& attach(_Loader&& op) {
+		_Myloader = MATRICE_STD(forward)<_Loader>(op);
+		return (*this);
+	}
+
+	/**
+	 * \brief METHOD, release the image data, results are kept.
+	 */
+	void release() noexcept {
+		if (_Myloader) {
+			_Mydata.reset();
+			_Mycache.reset();
+		}
+	}
+
+	/**
+	 * \brief METHOD, check if the image data is resident.
+	 */
+	bool is_loaded() const noexcept {
+		return bool(_Mydata);
+	}
+
+	/**
+	 * \brief METHOD, get the smooth image of this layer.
+	 */
+	decltype(auto) image() const noexcept {
+		return (*_Mydata);
+	}
+	shared_ptr<const smooth_image_t> image_ptr() const noexcept {
+		return _Mydata;
+	}
+
+	/**
+	 * \brief METHOD, get the gradient cache of the loaded image, it is 
+	 * built on the first call. Not thread-safe for the first call.
+	 */
+	const shared_ptr<const cache_type>& cache() {
+		if (!_Mycache && _Mydata) {
+			_Mycache = MATRICE_STD(make_shared)<const cache_type>(*_Mydata);
+		}
+		return (_Mycache);
+	}
+
+	/**
+	 * \brief METHOD, set and get nodes (POIs) of this layer.
+	 */
+	_Myt& set_nodes(const MATRICE_STD(vector)<point_type>& nodes) {
+		_Mynodes = nodes;
 		return (*this);
 	}
+	decltype(auto) nodes() const noexcept {
+		return (_Mynodes);
+	}
+	decltype(auto) nodes() noexcept {
+		return (_Mynodes);
+	}
+
+	/**
+	 * \brief METHOD, get the warp parameters of all nodes.
+	 * Each row holds the parameters of a node, which are solved 
+	 * w.r.t. the reference layer.
+	 */
+	decltype(auto) params() const noexcept {
+		return (_Mypars);
+	}
+	decltype(auto) params() noexcept {
+		return (_Mypars);
+	}
+
+	/**
+	 * \brief METHOD, get the ZNSSD coefficients of all nodes.
+	 */
+	decltype(auto) coeffs() const noexcept {
+		return (_Mycoefs);
+	}
+	decltype(auto) coeffs() noexcept {
+		return (_Mycoefs);
+	}
 
 	/**
 	 * \brief METHOD, detach this layer from the computational graph.
@@ -79,11 +193,34 @@ public:
 		return _Mystatus.processed;
 	}
 
+	/**
+	 * \brief METHOD, mark this layer as processed.
+	 */
+	void set_processed(bool val = true) noexcept {
+		_Mystatus.processed = val;
+	}
+
+	/**
+	 * \brief METHOD, index of this layer in the computational graph.
+	 */
+	size_t index() const noexcept {
+		return _Myidx;
+	}
+	size_t& index() noexcept {
+		return _Myidx;
+	}
+
 private:
 	// FIELD, smooth image data
-	image_t<value_type, _Pre> _Mydata;
+	shared_ptr<smooth_image_t> _Mydata;
+	shared_ptr<const cache_type> _Mycache;
 
-	// FIELD, operator to 
+	// FIELD, operator to load the image data
+	loader_type _Myloader;
+
+	// FIELD, nodes and the associated results
+	MATRICE_STD(vector)<point_type> _Mynodes;
+	matrix_type _Mypars, _Mycoefs;
 
 	// FIELD, status
 	status _Mystatus;
@@ -94,13 +231,19 @@ private:
 
 /// <summary>
 /// \brief CLASS, graph based correlation pipeline. 
+/// The first layer is the reference, and nodes defined on it are tracked
+/// through all subsequent layers with the IC-GN solver '_Atag'.
 /// </summary>
-template<typename _Ty>
+template<typename _Ty, typename _Itag = bicerp_tag, typename _Atag = _Alg_icgn<1>>
 class _Graph_executor {
 	using _Myt = _Graph_executor;
 public:
 	using value_type = _Ty;
-	using layer_type = _Corr_layer<value_type, bicerp_tag>;
+	using layer_type = _Corr_layer<value_type, _Itag>;
+	using solver_type = _Corr_solver_impl<value_type, _Itag, _Atag>;
+	using param_type = typename solver_type::param_type;
+	using point_type = typename layer_type::point_type;
+	using solver_options_type = typename solver_type::options_type;
 
 	enum computing_type
 	{
@@ -117,7 +260,7 @@ public:
 	enum device_type
 	{
 		cpu = 0,
-		gpu = 1
+		gpu = 1 << 4
 	};
 
 	/// <summary>
@@ -136,13 +279,39 @@ public:
 
 		// Specify to update reference layer.
 		bool adjacent = false;
+
+		// Specify number of threads for parallel modes, 0 for auto.
+		size_t num_threads = 0;
 	};
 
+	_Graph_executor(const options_type& opt = {})
+		: _Myopt(opt) {
+		_Mysopt._Radius = _Myopt.node_field;
+	}
+	_Graph_executor(const options_type& opt, const solver_options_type& sopt)
+		: _Myopt(opt), _Mysopt(sopt) {
+		_Mysopt._Radius = _Myopt.node_field;
+	}
+
+	/**
+	 * \brief METHOD, get options of the graph and the IC-GN solver.
+	 */
+	decltype(auto) options() const noexcept {
+		return (_Myopt);
+	}
+	decltype(auto) solver_options() const noexcept {
+		return (_Mysopt);
+	}
+	decltype(auto) solver_options() noexcept {
+		return (_Mysopt);
+	}
+
 	/**
 	 * \brief METHOD, add a computing layer.
 	 */
 	_Myt& add_layer(const layer_type& node) {
 		_Mylayers.push_back(node);
+		_Mylayers.back().index() = _Mylayers.size() - 1;
 		return (*this);
 	}
 
@@ -152,16 +321,200 @@ public:
 	_Myt& insert_layer(size_t pos, layer_type&& node) {
 		decltype(auto) _Where = _Mylayers.cbegin() + pos;
 		_Mylayers.insert(_Where, node);
+		for (auto _Idx = pos; _Idx < _Mylayers.size(); ++_Idx)
+			_Mylayers[_Idx].index() = _Idx;
 		return (*this);
 	}
 
-	void forward() noexcept {
+	/**
+	 * \brief METHOD, set nodes on the reference (first) layer.
+	 */
+	_Myt& set_nodes(const MATRICE_STD(vector)<point_type>& nodes) {
+		DGELOM_CHECK(!_Mylayers.empty(), "Add a reference layer before setting nodes.");
+		_Mylayers.front().set_nodes(nodes);
+		return (*this);
+	}
+
+	/**
+	 * \brief METHOD, get computing layers.
+	 */
+	decltype(auto) layers() const noexcept {
+		return (_Mylayers);
+	}
+	decltype(auto) layers() noexcept {
+		return (_Mylayers);
+	}
+
+	/**
+	 * \brief METHOD, run the graph. 
+	 * In the off-line modes all pending layers are solved, while in the 
+	 * instant mode only the latest layer is solved and the stale ones are
+	 * detached, so that it can be called each time a frame arrives.
+	 */
+	void forward() {
+		DGELOM_CHECK(!(_Myopt.exec_mode & device_type::gpu), 
+			"_Graph_executor does not support GPU computing yet.");
+		if (_Mylayers.size() < 2) return;
+
+		auto& _Ref = _Mylayers.front();
+		DGELOM_CHECK(!_Ref.nodes().empty(), "No nodes are defined on the reference layer.");
+		if (!_Ref.is_processed()) {
+			_Ref.load();
+			_Ref.params().create(_Ref.nodes().size(), solver_type::npar, 0);
+			_Ref.coeffs().create(_Ref.nodes().size(), 1, 0);
+			_Ref.set_processed();
+			_Mylast = 0;
+		}
+
+		const auto _Is_parallel = _Myopt.exec_mode & computing_type::parallel;
+		if (_Is_parallel && !_Mypool) {
+			_Mypool = MATRICE_STD(make_shared)<task_pool>(_Myopt.num_threads);
+		}
+
+		if ((_Myopt.exec_mode & computing_type::instant) == computing_type::instant) {
+			auto _Idx = _Mylayers.size() - 1;
+			for (; _Idx > _Mylast; --_Idx) {
+				if (_Mylayers[_Idx].is_active()) break;
+			}
+			if (_Idx == _Mylast || _Mylayers[_Idx].is_processed()) return;
+			for (auto _Skip = _Mylast + 1; _Skip < _Idx; ++_Skip) {
+				_Mylayers[_Skip].detach();
+				_Mylayers[_Skip].release();
+			}
+			_Forward(_Idx);
+			return;
+		}
 
+		for (auto _Idx = _Mylast + 1; _Idx < _Mylayers.size(); ++_Idx) {
+			auto& _Layer = _Mylayers[_Idx];
+			if (!_Layer.is_active() || _Layer.is_processed()) continue;
+			_Prefetch(_Idx + 1);
+			_Forward(_Idx);
+		}
+		_Mypreload.clear();
 	}
 
 private:
+	/**
+	 * \brief Asynchronously load the next 'preload_capacity' layers to 
+	 * overlap image decoding and B-spline prefiltering with solving.
+	 */
+	void _Prefetch(size_t _First) {
+		size_t _Count = 0;
+		for (auto _Idx = _First; _Idx < _Mylayers.size() && 
+			_Count < _Myopt.preload_capacity; ++_Idx) {
+			auto& _Layer = _Mylayers[_Idx];
+			if (!_Layer.is_active() || _Layer.is_processed()) continue;
+			if (!_Layer.is_loaded() && _Mypreload.count(_Idx) == 0) {
+				_Mypreload.emplace(_Idx, MATRICE_STD(async)(
+					MATRICE_STD(launch)::async, [&_Layer] { _Layer.load(); }));
+			}
+			++_Count;
+		}
+	}
+
+	/**
+	 * \brief Solve all nodes of the '_Idx'-th layer.
+	 */
+	void _Forward(size_t _Idx) {
+		auto& _Cur = _Mylayers[_Idx];
+		if (const auto _It = _Mypreload.find(_Idx); _It != _Mypreload.end()) {
+			_It->second.get();
+			_Mypreload.erase(_It);
+		}
+		_Cur.load();
+
+		auto& _Ref = _Myopt.adjacent ? _Mylayers[_Mylast] : _Mylayers.front();
+		const auto& _Prev = _Mylayers[_Mylast];
+		const auto& _Nodes = _Ref.nodes();
+		const auto _Nnodes = _Nodes.size();
+		_Cur.params().create(_Nnodes, solver_type::npar, 0);
+		_Cur.coeffs().create(_Nnodes, 1, 0);
+
+		// Kernel to solve the _Node-th node with the given solver.
+		auto _Kernel = [&](solver_type& _Solver, size_t _Node) {
+			_Solver.init(_Nodes[_Node]);
+
+			// Warm start from the latest solved layer.
+			param_type _Pars;
+			const auto _Pp = _Prev.params()[_Node];
+			for (size_t _Par = 0; _Par < solver_type::npar; ++_Par) {
+				_Pars[_Par] = _Pp[_Par];
+			}
+
+			value_type _Coef{ 0 };
+			for (size_t _It = 0; _It < _Mysopt.maxiters(); ++_It) {
+				const auto [_Znssd, _Error] = _Solver(_Pars);
+				_Coef = _Znssd;
+				if (_Error < _Mysopt.tol()) break;
+			}
+
+			auto _Dp = _Cur.params()[_Node];
+			for (size_t _Par = 0; _Par < solver_type::npar; ++_Par) {
+				_Dp[_Par] = _Pars[_Par];
+			}
+			_Cur.coeffs()(_Node) = _Coef;
+		};
+
+		// Images and the reference cache are shared by all solvers.
+		const auto _Refimg = _Ref.image_ptr(), _Curimg = _Cur.image_ptr();
+		const auto& _Cache = _Ref.cache();
+		if (_Myopt.exec_mode & computing_type::parallel) {
+			// Each worker owns a solver, since solvers hold work buffers.
+			MATRICE_STD(vector)<unique_ptr<solver_type>> _Solvers(_Mypool->size());
+			_Mypool->parallel_for(_Nnodes, 0, [&](size_t _Node, size_t _Ithr) {
+				auto& _Solver = _Solvers[_Ithr];
+				if (!_Solver) {
+					_Solver = MATRICE_STD(make_unique)<solver_type>(_Refimg, _Curimg, _Mysopt, _Cache);
+				}
+				_Kernel(*_Solver, _Node);
+			});
+		}
+		else {
+			solver_type _Solver(_Refimg, _Curimg, _Mysopt, _Cache);
+			for (size_t _Node = 0; _Node < _Nnodes; ++_Node) {
+				_Kernel(_Solver, _Node);
+			}
+		}
+
+		// Chain the reference: nodes move with the solved displacements.
+		if (_Myopt.adjacent) {
+			MATRICE_STD(vector)<point_type> _Moved(_Nnodes);
+			for (size_t _Node = 0; _Node < _Nnodes; ++_Node) {
+				const auto _Dp = _Cur.params()[_Node];
+				if constexpr (solver_type::order == 0) {
+					_Moved[_Node].x = _Nodes[_Node].x + _Dp[0];
+					_Moved[_Node].y = _Nodes[_Node].y + _Dp[1];
+				}
+				else {
+					_Moved[_Node].x = _Nodes[_Node].x + _Dp[0];
+					_Moved[_Node].y = _Nodes[_Node].y + _Dp[3];
+				}
+			}
+			_Cur.set_nodes(_Moved);
+			if (_Ref.index() != 0) _Ref.release();
+		}
+		else {
+			_Cur.set_nodes(_Nodes);
+			_Cur.release();
+		}
+
+		_Cur.set_processed();
+		_Mylast = _Idx;
+	}
+
+	options_type _Myopt;
+	solver_options_type _Mysopt;
 	MATRICE_STD(vector)<layer_type> _Mylayers;
-	
+
+	// Index of the latest processed layer
+	size_t _Mylast = 0;
+
+	// Pending asynchronous loading tasks, keyed by layer index
+	MATRICE_STD(map)<size_t, MATRICE_STD(future)<void>> _Mypreload;
+
+	// Work-stealing pool for the parallel modes
+	shared_ptr<task_pool> _Mypool;
 };
 
 _DETAIL_END
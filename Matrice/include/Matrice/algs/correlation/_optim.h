@@ -19,6 +19,8 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include <variant>
 #include "_correlation_traits.h"
 #include "../interpolation.h"
+#include "_ref_cache.h"
+#include "_fft_window.h"
 
 MATRICE_ALG_BEGIN(corr)
 _DETAIL_BEGIN
@@ -71,12 +73,16 @@ struct _Corr_solver_traits<_Corr_solver_impl<_Ty, _Itag, _Atag>> {
 /// \brief CLASS, correlation solver options
 /// </summary>
 struct _Correlation_options {
+	// \initial guess by a spatial ZNCC scan or by FFT based ZNCC
+	enum guess_mode { SPATIAL = 0, FFT = 1 };
+
 	size_t _Radius = 15;  //patch radius
 	size_t _Maxits = 50;  //maximum iterations
 	size_t _Stride = 7;  //node spacing
 	float_t _Znssd = 0.6; //correlation threshold
 	float_t _Coeff = 0.0; //damping coefficient
 	mutable float_t _Mytol = 1.0e-6;
+	guess_mode _Gmode = SPATIAL; //initial guess mode
 
 	/**
 	 * \brief Setter and geter of subset radius.
@@ -108,6 +114,16 @@ struct _Correlation_options {
 		return (_Znssd);
 	}
 
+	/**
+	 * \brief Setter and geter of initial guess mode.
+	 */
+	decltype(auto) guess() const noexcept {
+		return (_Gmode);
+	}
+	decltype(auto) guess() noexcept {
+		return (_Gmode);
+	}
+
 	/**
 	 * \brief Geter of correlation threshold with base 1E-6.
 	 */
@@ -171,6 +187,10 @@ public:
 	using smooth_image_t = interp_type;
 	using update_strategy = typename _Mytraits::update_strategy;
 	using rect_type = rect<size_t>;
+	// \brief Read-only reference cache shared by solvers.
+	using cache_type = _Corr_ref_cache<value_type, typename _Mytraits::itp_category>;
+	// \brief Search window of the current image for FFT based guess.
+	using window_type = _Corr_fft_window<value_type>;
 
 	// \brief Loss function definition.
 	struct loss_fn {
@@ -204,6 +224,27 @@ public:
 		_Myjaco(sq(_Mysize)), _Mydiff(sq(_Mysize)),
 		// for robust estimation, Dec/30/2020
 		_Myweight(sq(_Mysize)), _Myjaco_tw(sq(_Mysize)) {
+		_Myxs.resize(sq(_Mysize)), _Myys.resize(sq(_Mysize));
+	}
+
+	/**
+	 *\brief Create a solver sharing the interpolated images (and the reference 
+	          cache) with others rather than copying them.
+	 *\param _Ref, _Cur shared reference and current interpolated images;
+	 *\param _Opt options for the optimizer;
+	 *\param _Cache optional reference cache built from '_Ref'.
+	 */
+	_Corr_optim_base(
+		const shared_ptr<const smooth_image_t>& _Ref,
+		const shared_ptr<const smooth_image_t>& _Cur,
+		const options_type& _Opt,
+		const shared_ptr<const cache_type>& _Cache = nullptr
+	) : _Myopt(_Opt),
+		_Myimref(_Ref), _Myimcur(_Cur), _Mycache(_Cache),
+		_Mysize(_Opt._Radius<<1|1),
+		_Myjaco(sq(_Mysize)), _Mydiff(sq(_Mysize)),
+		_Myweight(sq(_Mysize)), _Myjaco_tw(sq(_Mysize)) {
+		_Myxs.resize(sq(_Mysize)), _Myys.resize(sq(_Mysize));
 	}
 
 	/**
@@ -223,7 +264,8 @@ public:
 	}
 
 	/**
-	 *\brief Integer pixel level search.
+	 *\brief Integer pixel level search, or sub-pixel level search if the 
+	          guess mode is options_type::FFT.
 	 *\param roi region of interest
 	 */
 	MATRICE_HOST_INL point_type guess(rect_type&& roi) {
@@ -237,7 +279,9 @@ public:
 	/**
 	 *\brief solve Gauss-Newton normal equations
 	 *\param (_pars) warp parameters.
-	 *\return [znssd, error := dot(dp, dp)]
+	 *\return [znssd, error := dot(dp, dp)], which is [4, 0] for a subset
+	          whose Hessian is not positive definite, e.g. a textureless
+	          one, and then '_pars' is left unchanged.
 	 */
 	MATRICE_HOST_INL auto operator()(param_type& _pars) {
 		return (this->_Solve(_pars));
@@ -260,6 +304,31 @@ public:
 		return _Mypos; 
 	}
 
+	/**
+	 *\brief Attach a reference cache, which must be built from the reference 
+	          image of this solver. The Jacobian of an integer-centred subset 
+	          is then gathered from the cache. Pass nullptr to detach.
+	 */
+	MATRICE_HOST_INL _Myt& set_cache(const shared_ptr<const cache_type>& _Cache) noexcept {
+		_Mycache = _Cache;
+		return (*this);
+	}
+	MATRICE_HOST_INL decltype(auto) cache() const noexcept {
+		return (_Mycache);
+	}
+
+	/**
+	 *\brief Attach a search window of the current image for the FFT based 
+	          guess, it is rebuilt by guess(...) if a ROI runs out of it.
+	 */
+	MATRICE_HOST_INL _Myt& set_window(const shared_ptr<const window_type>& _Win) noexcept {
+		_Mywindow = _Win;
+		return (*this);
+	}
+	MATRICE_HOST_INL decltype(auto) window() const noexcept {
+		return (_Mywindow);
+	}
+
 	// \brief for robust estimation, Dec/30/2020
 	MATRICE_HOST_INL void set_loss_scale(value_type s) noexcept {
 		_Myloss.scale = sq(s);
@@ -283,12 +352,38 @@ protected:
 	 */
 	MATRICE_HOST_INL auto _Guess(rect_type roi)->point_type;
 
+	/**
+	 *\brief FFT based ZNCC search over the subset centres in [_Start, _End).
+	 */
+	MATRICE_HOST_INL auto _Guess_fft(const typename rect_type::point_type& _Start, 
+		const typename rect_type::point_type& _End)->point_type;
+
 	/**
 	 *\brief Solve new parameters
 	 *\param [_Par] in: old parameters, output: new parameters
 	 */
 	MATRICE_HOST_INL auto _Solve(param_type& _Pars);
 
+	/**
+	 *\brief Check if the subset centred at '_Pos' can be gathered from the cache.
+	 */
+	MATRICE_HOST_INL bool _Is_cached(const point_type& _Pos) const noexcept {
+		if (!_Mycache) return false;
+		const auto x = floor<index_t>(_Pos.x), y = floor<index_t>(_Pos.y);
+		return x == _Pos.x && y == _Pos.y && 
+			_Mycache->contains(x, y, index_t(_Myopt._Radius));
+	}
+
+	/**
+	 *\brief Mark the '_Idx'-th pixel of the current patch as out of range.
+	 */
+	MATRICE_HOST_INL void _Mark_outside(size_t _Idx);
+
+	/**
+	 *\brief Interpolate the current patch at the warped positions in a batch.
+	 */
+	MATRICE_HOST_INL void _Interp_batch();
+
 	///</methods>
 
 	///<fields>
@@ -299,6 +394,12 @@ protected:
 	vector_type  _Mydiff;
 	jacob_type   _Myjaco;
 	matrix_fixed _Myhess;
+	// status of the Cholesky factorization of _Myhess
+	int          _Myspd = 1;
+
+	// warped positions of the current patch, and those out of range
+	MATRICE_STD(vector)<value_type> _Myxs, _Myys;
+	MATRICE_STD(vector)<size_t> _Myoutside;
 
 	// for robust estimation, Dec/30/2020
 	vector_type  _Myweight;
@@ -307,9 +408,13 @@ protected:
 	Matrix_<value_type, npar, ::dynamic> _Myjaco_tw;
 
 	// reconstructed reference image with a specified interpolator
-	shared_ptr<smooth_image_t> _Myimref;
+	shared_ptr<const smooth_image_t> _Myimref;
 	// reconstructed current image with a specified interpolator
-	shared_ptr<smooth_image_t> _Myimcur;
+	shared_ptr<const smooth_image_t> _Myimcur;
+	// gradients of the reference image at integer pixels
+	shared_ptr<const cache_type> _Mycache;
+	// search window of the current image for FFT based guess
+	shared_ptr<const window_type> _Mywindow;
 	///</fields>
 };
 
@@ -354,6 +459,7 @@ protected:
 	using _Mybase::_Mycur;
 	using _Mybase::_Myopt;
 	using _Mybase::_Mypos;
+	using _Mybase::_Mycache;
 };
 
 // \1-st order inverse compositional gauss-newton algrithom
@@ -405,6 +511,7 @@ protected:
 	using _Mybase::_Mycur;
 	using _Mybase::_Myopt;
 	using _Mybase::_Mypos;
+	using _Mybase::_Mycache;
 };
 
 _DETAIL_END
@@ -0,0 +1,422 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <array>
+#include <vector>
+#include "_optim.h"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+MATRICE_ALG_BEGIN(corr)
+_DETAIL_BEGIN
+
+/// <summary>
+/// \brief Lane-wise kernels over a SoA group of _W subsets, where the
+/// subset index runs fastest in memory. Each kernel is vectorized with
+/// simd::Packet_ if SIMD is enabled.
+/// </summary>
+template<typename _Ty, size_t _W> struct _Corr_lanes {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+	using packet_type = simd::Packet_<_Ty>;
+	static constexpr size_t step = packet_type::size;
+	static_assert(_W % step == 0, "Lane width must be a multiple of the packet size.");
+#endif
+	// \_Acc[l] += _A[l] * _B[l]
+	static MATRICE_HOST_FINL void mac(_Ty* _Acc, const _Ty* _A, const _Ty* _B) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		for (size_t l = 0; l < _W; l += step) {
+			(packet_type(_Acc + l) + packet_type(_A + l) * packet_type(_B + l)).unpack(_Acc + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) _Acc[l] += _A[l] * _B[l];
+#endif
+	}
+	// \_Acc[l] -= _A[l] * _B[l]
+	static MATRICE_HOST_FINL void msub(_Ty* _Acc, const _Ty* _A, const _Ty* _B) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		for (size_t l = 0; l < _W; l += step) {
+			(packet_type(_Acc + l) - packet_type(_A + l) * packet_type(_B + l)).unpack(_Acc + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) _Acc[l] -= _A[l] * _B[l];
+#endif
+	}
+	// \_Dst[l] = (_A[l] - _B[l]) * _S[l]
+	static MATRICE_HOST_FINL void subm(_Ty* _Dst, const _Ty* _A, const _Ty* _B, const _Ty* _S) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		for (size_t l = 0; l < _W; l += step) {
+			((packet_type(_A + l) - packet_type(_B + l)) * packet_type(_S + l)).unpack(_Dst + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) _Dst[l] = (_A[l] - _B[l]) * _S[l];
+#endif
+	}
+	// \_Dst[l] = _A[l] - _B[l]
+	static MATRICE_HOST_FINL void sub(_Ty* _Dst, const _Ty* _A, const _Ty* _B) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		for (size_t l = 0; l < _W; l += step) {
+			(packet_type(_A + l) - packet_type(_B + l)).unpack(_Dst + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) _Dst[l] = _A[l] - _B[l];
+#endif
+	}
+	// \_Dst[l] = _A[l] * _B[l]
+	static MATRICE_HOST_FINL void mul(_Ty* _Dst, const _Ty* _A, const _Ty* _B) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		for (size_t l = 0; l < _W; l += step) {
+			(packet_type(_A + l) * packet_type(_B + l)).unpack(_Dst + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) _Dst[l] = _A[l] * _B[l];
+#endif
+	}
+	// \_Dst[l] += _A[l]
+	static MATRICE_HOST_FINL void add(_Ty* _Dst, const _Ty* _A) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		for (size_t l = 0; l < _W; l += step) {
+			(packet_type(_Dst + l) + packet_type(_A + l)).unpack(_Dst + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) _Dst[l] += _A[l];
+#endif
+	}
+	static MATRICE_HOST_FINL void fill(_Ty* _Dst, _Ty _Val) noexcept {
+		for (size_t l = 0; l < _W; ++l) _Dst[l] = _Val;
+	}
+};
+
+/// <summary>
+/// \brief CLASS TEMPLATE, batched IC-GN solver. It solves many POIs per
+/// call in groups of 'lanes' subsets, with the Jacobians, Hessians and
+/// residuals of a group held in structure-of-arrays buffers, so that the
+/// J^T*r products and the Cholesky solves are vectorized across subsets.
+/// </summary>
+/// <typeparam name="_Ty">Scalar, primitive value type</typeparam>
+/// <typeparam name="_Itag">Interpolation function tag</typeparam>
+/// <typeparam name="_Atag">IC-GN solver tag, _Alg_icgn<0> or _Alg_icgn<1></typeparam>
+template<typename _Ty, typename _Itag, typename _Atag>
+class _Corr_batch_solver {
+	using _Myt = _Corr_batch_solver;
+	using _Mytraits = _Corr_solver_traits<_Corr_solver_impl<_Ty, _Itag, _Atag>>;
+public:
+	static constexpr auto order = _Mytraits::order;
+	static constexpr auto npar = conditional_size_v<order == 0, 2, order * 6>;
+	static_assert(order <= 1, "The batched IC-GN solver supports the 0th and 1st order shape functions only.");
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+	static constexpr size_t lanes = simd::Packet_<_Ty>::size;
+#else
+	static constexpr size_t lanes = 8;
+#endif
+	using value_type = typename _Mytraits::value_type;
+	using point_type = Vec2_<value_type>;
+	using param_type = Vec_<value_type, npar>;
+	using options_type = _Correlation_options;
+	using interp_type = typename _Mytraits::interpolator;
+	using smooth_image_t = interp_type;
+	using update_strategy = typename _Mytraits::update_strategy;
+	using cache_type = _Corr_ref_cache<value_type, _Itag>;
+	// \brief Lane-wise Cholesky kernels of the npar x npar Hessians.
+	using chol_kernel = dgelom::detail::_Small_batch_kernel<value_type, npar, lanes>;
+
+	// \brief Per-POI report with {znssd, error := dot(dp, dp), iterations}.
+	struct report_type {
+		value_type znssd = 0;
+		value_type error = 0;
+		size_t niters = 0;
+	};
+
+	_Corr_batch_solver(const smooth_image_t& _Ref,
+		const smooth_image_t& _Cur, const options_type& _Opt)
+		: _Myopt(_Opt), _Myimref(_Ref), _Myimcur(_Cur),
+		_Mysize(_Opt._Radius << 1 | 1) {
+		const auto _Npts = sq(_Mysize);
+		_Myjaco.resize(npar * _Npts * lanes);
+		_Myref.resize(_Npts * lanes);
+		_Mycur.resize(_Npts * lanes);
+		_Myxs.resize(_Npts * lanes), _Myys.resize(_Npts * lanes);
+		_Myval.resize(_Npts * lanes);
+		_Myhess.resize(npar * npar * lanes);
+		_Mygrad.resize(npar * lanes);
+	}
+
+	/**
+	 *\brief Solve a batch of POIs.
+	 *\param [_Pos] reference positions;
+	 *\param [_Pars] in: initial guesses, out: solved warp parameters.
+	 *\return reports of all POIs.
+	 */
+	MATRICE_HOST_INL auto operator()(const MATRICE_STD(vector)<point_type>& _Pos,
+		MATRICE_STD(vector)<param_type>& _Pars) {
+		DGELOM_CHECK(_Pos.size() == _Pars.size(),
+			"The number of POIs and initial guesses must be consistent.");
+		MATRICE_STD(vector)<report_type> _Reps(_Pos.size());
+		for (size_t _Off = 0; _Off < _Pos.size(); _Off += lanes) {
+			const auto _Cnt = (MATRICE_STD(min))(lanes, _Pos.size() - _Off);
+			_Solve_group(_Pos.data() + _Off, _Pars.data() + _Off, _Reps.data() + _Off, _Cnt);
+		}
+		return _Reps;
+	}
+
+	MATRICE_HOST_INL constexpr decltype(auto)options()const noexcept {
+		return (_Myopt);
+	}
+
+	/**
+	 *\brief Attach a reference cache built from the reference image, which
+	 *		  is shared with other solvers. Pass nullptr to detach.
+	 */
+	MATRICE_HOST_INL _Myt& set_cache(const shared_ptr<const cache_type>& _Cache) noexcept {
+		_Mycache = _Cache;
+		return (*this);
+	}
+
+private:
+	MATRICE_HOST_INL value_type* _J(size_t _Par, size_t _Pix) noexcept {
+		return _Myjaco.data() + (_Par * sq(_Mysize) + _Pix) * lanes;
+	}
+	MATRICE_HOST_INL value_type* _H(size_t _Row, size_t _Col) noexcept {
+		return _Myhess.data() + (_Row * npar + _Col) * lanes;
+	}
+
+	/**
+	 *\brief Build reference subsets, Jacobians and Cholesky factors of
+	 *		  the Hessians for a group of '_Cnt' POIs.
+	 */
+	MATRICE_HOST_INL void _Cond(const point_type* _Pos, size_t _Cnt) {
+		using lanes_t = _Corr_lanes<value_type, lanes>;
+		const auto _Npts = sq(_Mysize);
+		const auto _Radius = static_cast<diff_t>(_Myopt._Radius);
+		const auto& _Data = _Myimref.data();
+		const auto [_Rows, _Cols] = _Data.shape().tile();
+
+		// \fill reference subsets and Jacobians, inactive lanes are zero.
+		MATRICE_STD(fill)(_Myref.begin(), _Myref.end(), zero<value_type>);
+		MATRICE_STD(fill)(_Myjaco.begin(), _Myjaco.end(), zero<value_type>);
+		for (size_t l = 0; l < _Cnt; ++l) {
+			const auto& _P = _Pos[l];
+			const bool _Is_int = _P.x == floor(_P.x) && _P.y == floor(_P.y);
+			const bool _Cached = _Is_int && _Mycache && 
+				_Mycache->contains(diff_t(_P.x), diff_t(_P.y), _Radius);
+			for (diff_t j = -_Radius, r = 0; j <= _Radius; ++j, ++r) {
+				const auto dy = static_cast<value_type>(j), y = _P.y + dy;
+				for (diff_t i = -_Radius, c = 0; i <= _Radius; ++i, ++c) {
+					const auto dx = static_cast<value_type>(i), x = _P.x + dx;
+					const auto _Pix = r * _Mysize + c;
+					if (y >= 0 && y < _Rows && x >= 0 && x < _Cols) {
+						_Myref[_Pix * lanes + l] = _Is_int ?
+							_Data[diff_t(y)][diff_t(x)] : _Myimref(x, y);
+					}
+					const auto [dfdx, dfdy] = _Cached ?
+						_Mycache->grad(diff_t(x), diff_t(y)) : _Myimref.grad({ x, y });
+					if constexpr (order == 0) {
+						_J(0, _Pix)[l] = dfdx, _J(1, _Pix)[l] = dfdy;
+					}
+					else {
+						_J(0, _Pix)[l] = dfdx, _J(1, _Pix)[l] = dfdx * dx;
+						_J(2, _Pix)[l] = dfdx * dy, _J(3, _Pix)[l] = dfdy;
+						_J(4, _Pix)[l] = dfdy * dx, _J(5, _Pix)[l] = dfdy * dy;
+					}
+				}
+			}
+		}
+
+		// \zero mean normalization of reference subsets.
+		_Normalize(_Myref.data(), _Myissd.data());
+
+		// \Gauss-Newton Hessians (upper triangle), scaled by 1/sqrt(ssd).
+		MATRICE_STD(fill)(_Myhess.begin(), _Myhess.end(), zero<value_type>);
+		for (size_t _Pix = 0; _Pix < _Npts; ++_Pix) {
+			for (size_t p = 0; p < npar; ++p) {
+				for (size_t q = p; q < npar; ++q) {
+					lanes_t::mac(_H(p, q), _J(p, _Pix), _J(q, _Pix));
+				}
+			}
+		}
+		for (size_t p = 0; p < npar; ++p) {
+			for (size_t q = p; q < npar; ++q) {
+				lanes_t::mul(_H(p, q), _H(p, q), _Myissd.data());
+			}
+			for (size_t l = 0; l < lanes; ++l) {
+				_H(p, p)[l] += _Myopt._Coeff;
+			}
+		}
+
+		// \Cholesky factorization H = LL^T, L is stored in the lower
+		// triangle, and the diagonal holds the reciprocals of L(p, p).
+		chol_kernel::spd(_Myhess.data());
+	}
+
+	/**
+	 *\brief Zero mean and unit norm normalization of a SoA subset group.
+	 *\param [_Issd] output reciprocals of sqrt(ssd) of all lanes.
+	 */
+	MATRICE_HOST_INL void _Normalize(value_type* _Data, value_type* _Issd) {
+		using lanes_t = _Corr_lanes<value_type, lanes>;
+		const auto _Npts = sq(_Mysize);
+		alignas(64) value_type _Mean[lanes], _Ssd[lanes];
+		lanes_t::fill(_Mean, zero<value_type>);
+		lanes_t::fill(_Ssd, zero<value_type>);
+		for (size_t _Pix = 0; _Pix < _Npts; ++_Pix) {
+			lanes_t::add(_Mean, _Data + _Pix * lanes);
+		}
+		for (size_t l = 0; l < lanes; ++l) _Mean[l] /= _Npts;
+		for (size_t _Pix = 0; _Pix < _Npts; ++_Pix) {
+			const auto _Px = _Data + _Pix * lanes;
+			lanes_t::sub(_Px, _Px, _Mean);
+			lanes_t::mac(_Ssd, _Px, _Px);
+		}
+		for (size_t l = 0; l < lanes; ++l) {
+			_Issd[l] = _Ssd[l] > zero<value_type> ?
+				one<value_type> / sqrt(_Ssd[l]) : zero<value_type>;
+		}
+		for (size_t _Pix = 0; _Pix < _Npts; ++_Pix) {
+			const auto _Px = _Data + _Pix * lanes;
+			lanes_t::mul(_Px, _Px, _Issd);
+		}
+	}
+
+	/**
+	 *\brief Warp current subsets of the active lanes. The warped positions
+	 *		  of all active lanes are interpolated with one eval_batch(...).
+	 */
+	MATRICE_HOST_INL void _Warp(const point_type* _Pos, const param_type* _Pars,
+		const bool* _Active, size_t _Cnt) {
+		using _Border = typename _Mytraits::border_size;
+		const auto [_Rows, _Cols] = _Myimcur.data().shape().tile();
+		const auto _Radius = static_cast<diff_t>(_Myopt._Radius);
+		const auto _Npts = sq(_Mysize);
+
+		// \gather positions lane by lane, the outside ones are parked.
+		size_t _Lanes[lanes], _Nact = 0;
+		_Myoutside.clear();
+		for (size_t l = 0; l < _Cnt; ++l) {
+			if (!_Active[l]) continue;
+			const auto& _Par = _Pars[l];
+			auto _Xs = _Myxs.data() + _Nact * _Npts, _Ys = _Myys.data() + _Nact * _Npts;
+			for (diff_t j = -_Radius, r = 0; j <= _Radius; ++j, ++r) {
+				const auto dy = static_cast<value_type>(j);
+				for (diff_t i = -_Radius, c = 0; i <= _Radius; ++i, ++c) {
+					const auto dx = static_cast<value_type>(i);
+					value_type x, y;
+					if constexpr (order == 0) {
+						x = _Pos[l].x + _Par[0] + dx;
+						y = _Pos[l].y + _Par[1] + dy;
+					}
+					else {
+						x = _Pos[l].x + _Par[0] + (1 + _Par[1]) * dx + _Par[2] * dy;
+						y = _Pos[l].y + _Par[3] + _Par[4] * dx + (1 + _Par[5]) * dy;
+					}
+					const auto _Pix = r * _Mysize + c;
+					if (y - _Border::lower >= 0 && x - _Border::lower >= 0 &&
+						y + _Border::upper < _Rows && x + _Border::upper < _Cols) {
+						_Xs[_Pix] = x, _Ys[_Pix] = y;
+					}
+					else {
+						_Xs[_Pix] = _Ys[_Pix] = value_type(_Border::lower);
+						_Myoutside.push_back(_Nact * _Npts + _Pix);
+					}
+				}
+			}
+			_Lanes[_Nact++] = l;
+		}
+		if (_Nact == 0) return;
+
+		_Myimcur.eval_batch(_Myxs.data(), _Myys.data(), _Myval.data(), _Nact * _Npts);
+		for (const auto _Idx : _Myoutside) _Myval[_Idx] = zero<value_type>;
+
+		// \scatter to the SoA subsets.
+		for (size_t k = 0; k < _Nact; ++k) {
+			const auto _Src = _Myval.data() + k * _Npts;
+			for (size_t _Pix = 0; _Pix < _Npts; ++_Pix) {
+				_Mycur[_Pix * lanes + _Lanes[k]] = _Src[_Pix];
+			}
+		}
+	}
+
+	/**
+	 *\brief Solve a group of '_Cnt' POIs.
+	 */
+	MATRICE_HOST_INL void _Solve_group(const point_type* _Pos,
+		param_type* _Pars, report_type* _Reps, size_t _Cnt) {
+		using lanes_t = _Corr_lanes<value_type, lanes>;
+		const auto _Npts = sq(_Mysize);
+		this->_Cond(_Pos, _Cnt);
+
+		bool _Active[lanes] = {};
+		for (size_t l = 0; l < _Cnt; ++l) _Active[l] = true;
+
+		alignas(64) value_type _Issd[lanes], _Znssd[lanes];
+		for (size_t _It = 0; _It < _Myopt._Maxits; ++_It) {
+			// \warp current subsets and error maps r = g - f.
+			this->_Warp(_Pos, _Pars, _Active, _Cnt);
+			_Normalize(_Mycur.data(), _Issd);
+			lanes_t::fill(_Znssd, zero<value_type>);
+			MATRICE_STD(fill)(_Mygrad.begin(), _Mygrad.end(), zero<value_type>);
+			for (size_t _Pix = 0; _Pix < _Npts; ++_Pix) {
+				const auto _Px = _Mycur.data() + _Pix * lanes;
+				lanes_t::sub(_Px, _Px, _Myref.data() + _Pix * lanes);
+				lanes_t::mac(_Znssd, _Px, _Px);
+				// \steepest descent J^T*r.
+				for (size_t p = 0; p < npar; ++p) {
+					lanes_t::mac(_Mygrad.data() + p * lanes, _J(p, _Pix), _Px);
+				}
+			}
+
+			// \forward and backward substitutions with L.
+			chol_kernel::spd_bwd(_Myhess.data(), _Mygrad.data());
+
+			// \inverse composition to update the active lanes.
+			size_t _Nactive = 0;
+			for (size_t l = 0; l < _Cnt; ++l) {
+				if (!_Active[l]) continue;
+				param_type _Dp;
+				for (size_t p = 0; p < npar; ++p) {
+					_Dp[p] = _Mygrad[p * lanes + l];
+				}
+				_Pars[l] = update_strategy::eval(_Pars[l], _Dp);
+
+				auto& _Rep = _Reps[l];
+				_Rep.znssd = _Znssd[l];
+				_Rep.error = _Dp.dot(_Dp);
+				_Rep.niters = _It + 1;
+				if (_Rep.error < _Myopt.tol()) _Active[l] = false;
+				else ++_Nactive;
+			}
+			if (_Nactive == 0) break;
+		}
+	}
+
+	options_type _Myopt;
+	const smooth_image_t& _Myimref;
+	const smooth_image_t& _Myimcur;
+	shared_ptr<const cache_type> _Mycache;
+	size_t _Mysize;
+
+	// SoA buffers, the lane index runs fastest.
+	MATRICE_STD(vector)<value_type> _Myjaco, _Myref, _Mycur;
+	MATRICE_STD(vector)<value_type> _Myhess, _Mygrad;
+	// Lane-major warped positions and values for eval_batch(...).
+	MATRICE_STD(vector)<value_type> _Myxs, _Myys, _Myval;
+	MATRICE_STD(vector)<size_t> _Myoutside;
+	alignas(64) MATRICE_STD(array)<value_type, lanes> _Myissd;
+};
+
+_DETAIL_END
+MATRICE_ALG_END(corr)
@@ -0,0 +1,198 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+#include <vector>
+#include "../interpolation.h"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+MATRICE_ALG_BEGIN(corr)
+_DETAIL_BEGIN
+
+/// <summary>
+/// \brief CLASS TEMPLATE, read-only cache of a reference frame, which holds
+/// the intensities and the x/y gradients at all integer pixels. It is built
+/// once per frame and shared by all solvers, so the reference subset and the
+/// Jacobian of an integer-centred node are gathered instead of interpolated.
+/// The cached gradients are identical to interpolation::grad(...) evaluated
+/// at integer positions.
+/// </summary>
+/// <typeparam name="_Ty">Scalar, primitive value type</typeparam>
+/// <typeparam name="_Itag">Interpolation function tag</typeparam>
+template<typename _Ty, typename _Itag>
+class _Corr_ref_cache {
+	using _Myt = _Corr_ref_cache;
+public:
+	using value_type = _Ty;
+	using matrix_type = Matrix<value_type>;
+	using interp_type = interpolation<value_type, _Itag>;
+
+	/**
+	 *\brief Build the cache from a smooth reference image.
+	 */
+	explicit _Corr_ref_cache(const interp_type& _Itp)
+		: _Myvalue(_Itp.data()) {
+		_Build(_Itp);
+	}
+
+	/**
+	 *\brief Get intensities and gradients at integer pixels.
+	 */
+	MATRICE_HOST_INL decltype(auto) value() const noexcept {
+		return (_Myvalue);
+	}
+	MATRICE_HOST_INL decltype(auto) gradx() const noexcept {
+		return (_Mygradx);
+	}
+	MATRICE_HOST_INL decltype(auto) grady() const noexcept {
+		return (_Mygrady);
+	}
+
+	/**
+	 *\brief Get the gradient at the integer pixel {x, y}.
+	 */
+	MATRICE_HOST_INL auto grad(index_t x, index_t y) const noexcept {
+		return tuple<value_type, value_type>(_Mygradx[y][x], _Mygrady[y][x]);
+	}
+
+	/**
+	 *\brief Check if the subset centred at {x, y} with radius '_Radius' lies in the cache.
+	 */
+	MATRICE_HOST_INL bool contains(index_t x, index_t y, index_t _Radius) const noexcept {
+		return x >= _Radius && y >= _Radius &&
+			x + _Radius < index_t(_Myvalue.cols()) &&
+			y + _Radius < index_t(_Myvalue.rows());
+	}
+
+private:
+	MATRICE_HOST_INL void _Build(const interp_type& _Itp);
+
+	matrix_type _Myvalue, _Mygradx, _Mygrady;
+};
+
+template<typename _Ty, typename _Itag>
+MATRICE_HOST_INL void _Corr_ref_cache<_Ty, _Itag>::_Build(const interp_type& _Itp) {
+	const auto [_Rows, _Cols] = _Myvalue.shape().tile();
+	_Mygradx.create(_Rows, _Cols);
+	_Mygrady.create(_Rows, _Cols);
+	const auto _Nrows = index_t(_Rows), _Ncols = index_t(_Cols);
+
+	if constexpr (require_coeff_lut<_Itag>::value) {
+		// At an integer position the spline kernels reduce to their first
+		// columns, hence the gradients are separable filters over the coeffs:
+		// gx = K_v(y) * C * K_g(x), gy = K_g(y) * C * K_v(x).
+		constexpr auto Ldv = interp_type::Ldv;
+		constexpr index_t _Off = (Ldv >> 1) - 1;
+		const auto& _Kov = _Itp._Kernel_of_value();
+		const auto& _Kog = _Itp._Kernel_of_grad();
+		value_type _Wv[Ldv], _Wg[Ldv];
+		for (auto k = 0; k < Ldv; ++k) {
+			_Wv[k] = _Kov(k, 0), _Wg[k] = _Kog(k, 0);
+		}
+		const auto& _Coeff = _Itp();
+
+		const auto _Clamp = [](index_t i, index_t n) {
+			return i < 0 ? 0 : i < n ? i : n - 1;
+		};
+		// \_Dst[x] = sum_k _W[k] * _Src[x - _Off + k]
+		const auto _Hpass = [&](const value_type* _Src, const value_type* _W, value_type* _Dst) {
+			const auto _Lower = (MATRICE_STD(min))(_Off, _Ncols);
+			const auto _Upper = (MATRICE_STD(max))(_Lower, _Ncols - (Ldv - 1 - _Off));
+			auto x = _Lower;
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+			using packet_type = simd::Packet_<value_type>;
+			for (; x + index_t(packet_type::size) <= _Upper; x += packet_type::size) {
+				packet_type _Acc(zero<value_type>);
+				for (auto k = 0; k < Ldv; ++k) {
+					_Acc = _Acc + packet_type(_Src + x - _Off + k) * packet_type(_W[k]);
+				}
+				_Acc.unpack(_Dst + x);
+			}
+#endif
+			for (; x < _Upper; ++x) {
+				auto _Acc = zero<value_type>;
+				for (auto k = 0; k < Ldv; ++k) _Acc += _W[k] * _Src[x - _Off + k];
+				_Dst[x] = _Acc;
+			}
+			const auto _Border = [&](index_t x) {
+				auto _Acc = zero<value_type>;
+				for (auto k = 0; k < Ldv; ++k)
+					_Acc += _W[k] * _Src[_Clamp(x - _Off + k, _Ncols)];
+				_Dst[x] = _Acc;
+			};
+			for (x = 0; x < _Lower; ++x) _Border(x);
+			for (x = _Upper; x < _Ncols; ++x) _Border(x);
+		};
+
+#pragma omp parallel if(_Rows > 100)
+		{
+			MATRICE_STD(vector)<value_type> _Tv(_Cols), _Tg(_Cols);
+#pragma omp for
+			for (index_t y = 0; y < _Nrows; ++y) {
+				const value_type* _Src[Ldv];
+				for (auto k = 0; k < Ldv; ++k) {
+					_Src[k] = _Coeff[_Clamp(y - _Off + k, _Nrows)];
+				}
+
+				// \vertical pass: value and gradient weights along y
+				index_t x = 0;
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+				using packet_type = simd::Packet_<value_type>;
+				for (; x < index_t(simd::vsize<packet_type::size>(_Cols)); x += packet_type::size) {
+					packet_type _Accv(zero<value_type>), _Accg(zero<value_type>);
+					for (auto k = 0; k < Ldv; ++k) {
+						const packet_type _C(_Src[k] + x);
+						_Accv = _Accv + _C * packet_type(_Wv[k]);
+						_Accg = _Accg + _C * packet_type(_Wg[k]);
+					}
+					_Accv.unpack(_Tv.data() + x);
+					_Accg.unpack(_Tg.data() + x);
+				}
+#endif
+				for (; x < _Ncols; ++x) {
+					auto _Accv = zero<value_type>, _Accg = zero<value_type>;
+					for (auto k = 0; k < Ldv; ++k) {
+						_Accv += _Wv[k] * _Src[k][x];
+						_Accg += _Wg[k] * _Src[k][x];
+					}
+					_Tv[x] = _Accv, _Tg[x] = _Accg;
+				}
+
+				// \horizontal pass
+				_Hpass(_Tv.data(), _Wg, _Mygradx[y]);
+				_Hpass(_Tg.data(), _Wv, _Mygrady[y]);
+			}
+		}
+	}
+	else {
+		// \bilinear: forward differences, backward ones on the last row/col.
+#pragma omp parallel for if(_Rows > 100)
+		for (index_t y = 0; y < _Nrows; ++y) {
+			const auto _Gy = (MATRICE_STD(min))(y, _Nrows - 2);
+			for (index_t x = 0; x < _Ncols; ++x) {
+				const auto _Gx = (MATRICE_STD(min))(x, _Ncols - 2);
+				const auto [dfdx, dfdy] = _Itp.grad(value_type(_Gx), value_type(_Gy));
+				_Mygradx[y][x] = dfdx, _Mygrady[y][x] = dfdy;
+			}
+		}
+	}
+}
+
+_DETAIL_END
+MATRICE_ALG_END(corr)
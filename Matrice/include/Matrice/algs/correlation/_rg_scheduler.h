@@ -0,0 +1,363 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library for
+3D vision & photo-mechanics.
+Copyright(C) 2018-2021, Zhilong (Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**********************************************************************/
+#pragma once
+
+#include <queue>
+#include <vector>
+#include "_optim.h"
+#include "thread/_task_pool.h"
+
+MATRICE_ALG_BEGIN(corr)
+_DETAIL_BEGIN
+
+/// <summary>
+/// \brief CLASS TEMPLATE, reliability-guided (RG) propagation scheduler.
+/// The integer search is only performed on a few seeds, then the nodes
+/// of a regular grid are processed in the descending order of their ZNCC,
+/// each initialized from the best solved neighbor. The grid spacing is
+/// given by _Correlation_options::_Stride.
+/// </summary>
+/// <typeparam name="_Solver">IC-GN solver, e.g. _Corr_solver_impl</typeparam>
+template<typename _Solver>
+class _Corr_rg_scheduler {
+	using _Myt = _Corr_rg_scheduler;
+public:
+	using solver_type = _Solver;
+	using value_type = typename solver_type::value_type;
+	using param_type = typename solver_type::param_type;
+	using point_type = typename solver_type::point_type;
+	using matrix_type = Matrix<value_type>;
+	using options_type = typename solver_type::options_type;
+	using smooth_image_t = typename solver_type::smooth_image_t;
+	using cache_type = typename solver_type::cache_type;
+	using rect_type = typename solver_type::rect_type;
+	// \brief Grid index with {row, col}.
+	using index_type = tuple<size_t, size_t>;
+	static constexpr auto npar = solver_type::npar;
+
+	// \brief Solved state of a node.
+	struct node_type {
+		param_type pars;
+		value_type zncc = -1;
+		size_t niters = 0;
+		bool solved = false;
+	};
+
+	/**
+	 *\brief CTOR
+	 *\param _Ref, _Cur smooth reference and current images;
+	 *\param _Opt options, the node spacing is given by _Opt._Stride.
+	 */
+	_Corr_rg_scheduler(const smooth_image_t& _Ref,
+		const smooth_image_t& _Cur, const options_type& _Opt)
+		: _Myref(_Ref), _Mycur(_Cur), _Myopt(_Opt) {
+	}
+
+	/**
+	 *\brief Define a regular grid of nodes.
+	 *\param [_Origin] position of the top-left node;
+	 *\param [_Rows, _Cols] number of nodes along y and x.
+	 */
+	_Myt& set_grid(const point_type& _Origin, size_t _Rows, size_t _Cols) {
+		_Myorigin = _Origin;
+		_Myrows = _Rows, _Mycols = _Cols;
+		_Mynodes.assign(_Rows * _Cols, node_type{});
+		return (*this);
+	}
+
+	/**
+	 *\brief Half size of the integer search window around each seed.
+	 */
+	_Myt& set_search_radius(size_t _Radius) noexcept {
+		_Mysearch = _Radius;
+		return (*this);
+	}
+
+	/**
+	 *\brief Position of the node at {_Row, _Col}.
+	 */
+	MATRICE_HOST_INL point_type position(size_t _Row, size_t _Col) const noexcept {
+		const auto _Stride = static_cast<value_type>(_Myopt._Stride);
+		return point_type(_Myorigin.x + _Col * _Stride, _Myorigin.y + _Row * _Stride);
+	}
+
+	/**
+	 *\brief Run RG propagation from the given seeds on the calling thread.
+	 *\param [_Seeds] grid indices of the seeds, the center node is used if empty.
+	 */
+	_Myt& forward(const MATRICE_STD(vector)<index_type>& _Seeds = {}) {
+		_Check(_Seeds);
+		_Reset();
+		solver_type _Solver(_Myref, _Mycur, _Myopt);
+		_Solver.set_cache(_Mycache);
+		_Propagate(_Solver, _Seeds.empty() ? _Center() : _Seeds, {}, 0, _Myrows);
+		return (*this);
+	}
+
+	/**
+	 *\brief Multi-threaded RG propagation. The grid is partitioned into
+	         horizontal bands of node rows, which are propagated by the
+	         workers in rounds. A band starts from the seeds in it, and in
+	         later rounds from the reliable nodes of its neighbor bands next
+	         to its unsolved border nodes, so a seed is propagated over the
+	         whole grid as in the serial forward(...). The center node is 
+	         the only seed if none is given, so seeds spread over the bands
+	         are needed to run all workers from the first round.
+	 *\param [_Pool] task pool; [_Seeds] grid indices of the seeds.
+	 */
+	_Myt& forward(task_pool& _Pool, const MATRICE_STD(vector)<index_type>& _Seeds = {}) {
+		const auto _Nbands = (MATRICE_STD(min))(_Pool.size(), _Myrows);
+		if (_Nbands < 2) return forward(_Seeds);
+		_Check(_Seeds);
+		_Reset();
+
+		const auto _Band_rows = (_Myrows + _Nbands - 1) / _Nbands;
+		MATRICE_STD(vector)<MATRICE_STD(vector)<index_type>> _Band_seeds(_Nbands);
+		MATRICE_STD(vector)<MATRICE_STD(vector)<_Guess>> _Band_guesses(_Nbands);
+		for (const auto& _Seed : _Seeds.empty() ? _Center() : _Seeds) {
+			_Band_seeds[get<0>(_Seed) / _Band_rows].push_back(_Seed);
+		}
+
+		for (bool _Active = true; _Active; ) {
+			_Pool.parallel_for(_Nbands, 1, [&](size_t _Band, size_t) {
+				const auto _Lower = _Band * _Band_rows;
+				const auto _Upper = (MATRICE_STD(min))(_Lower + _Band_rows, _Myrows);
+				if (_Band_seeds[_Band].empty() && _Band_guesses[_Band].empty()) return;
+				solver_type _Solver(_Myref, _Mycur, _Myopt);
+				_Solver.set_cache(_Mycache);
+				_Propagate(_Solver, _Band_seeds[_Band], _Band_guesses[_Band], _Lower, _Upper);
+			});
+
+			// \hand-offs across the band borders for the next round
+			_Active = false;
+			for (size_t _Band = 0; _Band < _Nbands; ++_Band) {
+				const auto _Lower = _Band * _Band_rows;
+				const auto _Upper = (MATRICE_STD(min))(_Lower + _Band_rows, _Myrows);
+				_Band_seeds[_Band].clear(), _Band_guesses[_Band].clear();
+				if (_Lower >= _Upper) continue;
+				if (_Lower > 0) 
+					_Handoff(_Lower, _Lower - 1, _Band_guesses[_Band]);
+				if (_Upper < _Myrows)
+					_Handoff(_Upper - 1, _Upper, _Band_guesses[_Band]);
+				_Active |= !_Band_guesses[_Band].empty();
+			}
+		}
+		return (*this);
+	}
+
+	/**
+	 *\brief Get the solved state of the node at {_Row, _Col}.
+	 */
+	MATRICE_HOST_INL decltype(auto) node(size_t _Row, size_t _Col) const noexcept {
+		return (_Mynodes[_Row * _Mycols + _Col]);
+	}
+
+	/**
+	 *\brief Get solved parameters of all nodes in row-major order.
+	 */
+	MATRICE_HOST_INL matrix_type params() const {
+		matrix_type _Ret(_Mynodes.size(), npar);
+		for (size_t _Idx = 0; _Idx < _Mynodes.size(); ++_Idx) {
+			auto _Row = _Ret[_Idx];
+			for (size_t _Par = 0; _Par < npar; ++_Par)
+				_Row[_Par] = _Mynodes[_Idx].pars[_Par];
+		}
+		return _Ret;
+	}
+
+	/**
+	 *\brief Get ZNCC coefficients of all nodes in row-major order.
+	 */
+	MATRICE_HOST_INL matrix_type coeffs() const {
+		matrix_type _Ret(_Myrows, _Mycols);
+		for (size_t _Idx = 0; _Idx < _Mynodes.size(); ++_Idx) {
+			_Ret(_Idx) = _Mynodes[_Idx].zncc;
+		}
+		return _Ret;
+	}
+
+	/**
+	 *\brief Mean number of IC-GN iterations over the solved nodes.
+	 */
+	MATRICE_HOST_INL value_type mean_iters() const noexcept {
+		size_t _Sum = 0, _Cnt = 0;
+		for (const auto& _Node : _Mynodes) {
+			if (_Node.solved) _Sum += _Node.niters, ++_Cnt;
+		}
+		return _Cnt ? value_type(_Sum) / _Cnt : value_type(0);
+	}
+
+private:
+	// \brief Queue item with {zncc, linear node index}.
+	using _Qitem = MATRICE_STD(pair)<value_type, size_t>;
+	// \brief Initial guess of a node with {linear node index, parameters}.
+	using _Guess = MATRICE_STD(pair)<size_t, param_type>;
+
+	MATRICE_HOST_INL MATRICE_STD(vector)<index_type> _Center() const {
+		return { index_type{ _Myrows >> 1, _Mycols >> 1 } };
+	}
+	void _Check(const MATRICE_STD(vector)<index_type>& _Seeds) const {
+		for (const auto& [_Row, _Col] : _Seeds) {
+			DGELOM_CHECK(_Row < _Myrows && _Col < _Mycols,
+				"The seed {" + MATRICE_STD(to_string)(_Row) + ", " + 
+				MATRICE_STD(to_string)(_Col) + "} is out of the grid.");
+		}
+	}
+
+	/**
+	 *\brief Nodes with ZNSSD over the threshold are kept, but not propagated.
+	 */
+	MATRICE_HOST_INL bool _Reliable(const node_type& _Node) const noexcept {
+		return _Node.solved &&
+			_Node.zncc >= one<value_type> - value_type(_Myopt.threshold()) / 2;
+	}
+
+	/**
+	 *\brief Collect guesses for the unsolved nodes on the node row '_Row'
+	          from the reliable nodes on the adjacent row '_From'.
+	 */
+	void _Handoff(size_t _Row, size_t _From, MATRICE_STD(vector)<_Guess>& _Guesses) const {
+		const auto _Dy = diff_t(_Row) - diff_t(_From);
+		for (size_t _Col = 0; _Col < _Mycols; ++_Col) {
+			const auto& _Src = _Mynodes[_From * _Mycols + _Col];
+			if (_Mynodes[_Row * _Mycols + _Col].solved || !_Reliable(_Src)) continue;
+			_Guesses.emplace_back(_Row * _Mycols + _Col, _Transfer(_Src.pars, 0, _Dy));
+		}
+	}
+
+	void _Reset() {
+		for (auto& _Node : _Mynodes) _Node = node_type{};
+		if (!_Mycache) {
+			_Mycache = MATRICE_STD(make_shared)<const cache_type>(_Myref);
+		}
+	}
+
+	/**
+	 *\brief Solve the node _Idx with IC-GN from the initial guess _Pars.
+	 */
+	void _Solve(solver_type& _Solver, size_t _Idx, param_type _Pars) {
+		const auto _Pos = position(_Idx / _Mycols, _Idx % _Mycols);
+		_Solver.init(_Pos);
+
+		value_type _Znssd{ 4 };
+		size_t _It = 0;
+		while (_It < _Myopt.maxiters()) {
+			const auto [_Coef, _Error] = _Solver(_Pars);
+			_Znssd = _Coef, ++_It;
+			if (_Error < _Myopt.tol()) break;
+		}
+
+		auto& _Node = _Mynodes[_Idx];
+		_Node.pars = _Pars;
+		_Node.niters = _It;
+		// \For zero-mean unit-norm subsets, ZNSSD = 2(1 - ZNCC).
+		_Node.zncc = one<value_type> - _Znssd / 2;
+		_Node.solved = true;
+	}
+
+	/**
+	 *\brief Integer search on a seed to get the initial guess.
+	 */
+	param_type _Seed(solver_type& _Solver, size_t _Idx) {
+		const auto _Pos = position(_Idx / _Mycols, _Idx % _Mycols);
+		_Solver.init(_Pos);
+
+		const auto _Radius = static_cast<value_type>(_Mysearch);
+		const auto _X = (MATRICE_STD(max))(_Pos.x - _Radius, value_type(0));
+		const auto _Y = (MATRICE_STD(max))(_Pos.y - _Radius, value_type(0));
+		const auto _Match = _Solver.guess(rect_type(size_t(_X), size_t(_Y),
+			(_Mysearch << 1) | 1, (_Mysearch << 1) | 1));
+
+		param_type _Pars;
+		if constexpr (npar == 2) {
+			_Pars[0] = _Match.x - _Pos.x, _Pars[1] = _Match.y - _Pos.y;
+		}
+		else {
+			_Pars[0] = _Match.x - _Pos.x, _Pars[3] = _Match.y - _Pos.y;
+		}
+		return _Pars;
+	}
+
+	/**
+	 *\brief Transfer parameters of a solved node to its neighbor at the
+	         grid offset {_Dx, _Dy}, with the first-order shape function.
+	 */
+	param_type _Transfer(const param_type& _Pars, diff_t _Dx, diff_t _Dy) const noexcept {
+		auto _Ret = _Pars;
+		if constexpr (npar == 6) {
+			const auto _Stride = static_cast<value_type>(_Myopt._Stride);
+			const auto dx = _Dx * _Stride, dy = _Dy * _Stride;
+			_Ret[0] += _Pars[1] * dx + _Pars[2] * dy;
+			_Ret[3] += _Pars[4] * dx + _Pars[5] * dy;
+		}
+		return _Ret;
+	}
+
+	/**
+	 *\brief RG propagation restricted to node rows [_Lower, _Upper), from
+	          the seeds, which are searched, and the nodes of given guesses.
+	 */
+	void _Propagate(solver_type& _Solver, const MATRICE_STD(vector)<index_type>& _Seeds,
+		const MATRICE_STD(vector)<_Guess>& _Guesses, size_t _Lower, size_t _Upper) {
+		MATRICE_STD(priority_queue)<_Qitem> _Queue;
+		for (const auto& [_Row, _Col] : _Seeds) {
+			if (_Row < _Lower || _Row >= _Upper || _Col >= _Mycols) continue;
+			const auto _Idx = _Row * _Mycols + _Col;
+			if (_Mynodes[_Idx].solved) continue;
+			_Solve(_Solver, _Idx, _Seed(_Solver, _Idx));
+			_Queue.emplace(_Mynodes[_Idx].zncc, _Idx);
+		}
+		for (const auto& [_Idx, _Pars] : _Guesses) {
+			if (_Mynodes[_Idx].solved) continue;
+			_Solve(_Solver, _Idx, _Pars);
+			_Queue.emplace(_Mynodes[_Idx].zncc, _Idx);
+		}
+
+		constexpr diff_t _Offs[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+		while (!_Queue.empty()) {
+			const auto [_Zncc, _Idx] = _Queue.top();
+			_Queue.pop();
+			if (!_Reliable(_Mynodes[_Idx])) continue;
+
+			const auto _Row = diff_t(_Idx / _Mycols), _Col = diff_t(_Idx % _Mycols);
+			for (const auto& _Off : _Offs) {
+				const auto _Nr = _Row + _Off[1], _Nc = _Col + _Off[0];
+				if (_Nr < diff_t(_Lower) || _Nr >= diff_t(_Upper) ||
+					_Nc < 0 || _Nc >= diff_t(_Mycols)) continue;
+				const auto _Nidx = size_t(_Nr) * _Mycols + size_t(_Nc);
+				if (_Mynodes[_Nidx].solved) continue;
+
+				_Solve(_Solver, _Nidx, _Transfer(_Mynodes[_Idx].pars, _Off[0], _Off[1]));
+				_Queue.emplace(_Mynodes[_Nidx].zncc, _Nidx);
+			}
+		}
+	}
+
+	const smooth_image_t& _Myref;
+	const smooth_image_t& _Mycur;
+	shared_ptr<const cache_type> _Mycache;
+	options_type _Myopt;
+	point_type _Myorigin;
+	size_t _Myrows = 0, _Mycols = 0;
+	size_t _Mysearch = 20;
+	MATRICE_STD(vector)<node_type> _Mynodes;
+};
+
+_DETAIL_END
+MATRICE_ALG_END(corr)
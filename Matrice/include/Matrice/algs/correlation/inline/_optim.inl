@@ -76,6 +76,8 @@ template<> struct _Param_update_strategy<_Alg_icgn<1>> {
 #pragma region <-- base class implementation -->
 template<typename _Derived> MATRICE_HOST_INL 
 auto _Corr_optim_base<_Derived>::_Cond()->matrix_type& {
+	memory_pool::scope _Pooled;
+
 	// \create buf.s to hold reference and current patchs
 	_Myref.create(_Mysize, _Mysize);
 	_Mycur.create(_Mysize, _Mysize);
@@ -123,7 +125,7 @@ auto _Corr_optim_base<_Derived>::_Cond()->matrix_type& {
 	
 	_Myhess = _Myhess * _Issd;
 	_Myhess = _Myhess + matrix_fixed::diag(_Myopt._Coeff);
-	internal::_Lak_adapter<spt>(_Myhess.view());
+	_Myspd = dgelom::detail::_Small_linear_kernel<value_type, npar>::spd(_Myhess.data());
 	
 	// ad hoc for robust eval.
 	_Myissd = _Issd;
@@ -144,6 +146,10 @@ auto _Corr_optim_base<_Derived>::_Guess(rect_type roi)->point_type {
 	_Clamp._Myupper = _Data.rows() - _Off;
 	_Start[1] = _Clamp(_Start.y), _End[1] = _Clamp(_End.y);
 
+	if (_Myopt._Gmode == options_type::FFT) {
+		return this->_Guess_fft(_Start, _End);
+	}
+
 	zncc_metric_t<value_type> zncc(_Myref.data(), _Myopt._Radius);
 
 	point_type _Pos;
@@ -172,8 +178,41 @@ auto _Corr_optim_base<_Derived>::_Guess(rect_type roi)->point_type {
 	return _Pos;
 }
 
+template<typename _Derived> MATRICE_HOST_INL
+auto _Corr_optim_base<_Derived>::_Guess_fft(const typename rect_type::point_type& _Start,
+	const typename rect_type::point_type& _End)->point_type {
+	const auto _X0 = index_t(_Start.x), _X1 = index_t(_End.x);
+	const auto _Y0 = index_t(_Start.y), _Y1 = index_t(_End.y);
+	if (_X1 <= _X0 || _Y1 <= _Y0) return point_type(_X0, _Y0);
+
+	// \pixels covered by the subsets centred in the ROI
+	const auto _Radius = index_t(_Myopt._Radius);
+	const auto _L = _X0 - _Radius, _R = _X1 + _Radius;
+	const auto _U = _Y0 - _Radius, _D = _Y1 + _Radius;
+	if (!_Mywindow || !_Mywindow->contains(_L, _U, _R, _D)) {
+		// \enlarge the window by the node spacing to share it with neighbours
+		const auto& _Data = _Myimcur->data();
+		const auto [_Rows, _Cols] = _Data.shape().tile();
+		const auto _Margin = index_t(_Myopt._Stride);
+		_Mywindow = MATRICE_STD(make_shared)<const window_type>(_Data,
+			(MATRICE_STD(max))(_L - _Margin, index_t(0)), (MATRICE_STD(max))(_U - _Margin, index_t(0)),
+			(MATRICE_STD(min))(_R + _Margin, index_t(_Cols)), (MATRICE_STD(min))(_D + _Margin, index_t(_Rows)));
+	}
+
+	const auto [_Pos, _Coeff] = _Mywindow->match(_Myref.data(), _Mysize, _X0, _Y0, _X1, _Y1);
+	return _Pos;
+}
+
 template<typename _Derived> MATRICE_HOST_INL
 auto _Corr_optim_base<_Derived>::_Solve(param_type& Par) {
+	// \a degenerate subset fails without touching the parameters.
+	if (_Myspd != 1) {
+		return std::make_tuple(value_type(4), zero<value_type>);
+	}
+
+	// \recycle the temporaries of the expressions below
+	memory_pool::scope _Pooled;
+
 	// \warp current image patch.
 	_Mycur = static_cast<_Derived*>(this)->_Warp(Par);
 
@@ -191,7 +230,7 @@ auto _Corr_optim_base<_Derived>::_Solve(param_type& Par) {
 #endif
 
 	// \solve update to the warp parameter vector.
-	internal::_Bwd_adapter<spt>(_Myhess.view(), _Sdp.view());
+	dgelom::detail::_Small_linear_kernel<value_type, npar>::spd_bwd(_Myhess.data(), _Sdp.data());
 
 	// \inverse composition to update param.
 	Par = update_strategy::eval(Par, _Sdp);
@@ -242,16 +281,32 @@ auto _Corr_optim_base<_Derived>::robust_sol(param_type& Par)
 	// \report least square correlation coeff., param. error, and loss.
 	return std::make_tuple(sq(_Mydiff).sum(), _Loss, _Dp.dot(_Dp));
 }
+template<typename _Derived> MATRICE_HOST_INL
+void _Corr_optim_base<_Derived>::_Mark_outside(size_t _Idx) {
+	// \park at a valid position, it is zeroed in _Interp_batch().
+	using border_size = typename _Mytraits::border_size;
+	_Myxs[_Idx] = _Myys[_Idx] = value_type(border_size::lower);
+	_Myoutside.push_back(_Idx);
+}
+
+template<typename _Derived> MATRICE_HOST_INL
+void _Corr_optim_base<_Derived>::_Interp_batch() {
+	_Myimcur->eval_batch(_Myxs.data(), _Myys.data(), _Mycur.data(), _Myxs.size());
+	for (const auto _Idx : _Myoutside) {
+		_Mycur(_Idx) = zero<value_type>;
+	}
+}
 #pragma endregion
 
 #pragma region <-- derived class implementation -->
+// \positions out of range are marked, and zeroed after interpolation.
 #define _IF_WITHIN_RANGE(_OP) \
 	if (y-_Mytraits::border_size::lower>=0 && \
 		 x-_Mytraits::border_size::lower>=0 && \
 		 y+_Mytraits::border_size::upper<_Rows && \
 		 x+_Mytraits::border_size::upper<_Cols) \
 		_OP; \
-   else _Mycur(r,c) = zero<value_type>;
+   else _Mybase::_Mark_outside(r*_Size+c);
 
 // \specialization of warp. to eval. current patch.
 template<typename _Ty, typename _Itag> MATRICE_HOST_INL
@@ -263,17 +318,19 @@ auto& _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<0>>::_Warp(const param_type& _Par)
 	const auto _Cur_x = _Mypos[0] + _Par[0];
 	const auto _Cur_y = _Mypos[1] + _Par[1];
 
-	auto _Mean = zero<value_type>;
+	const auto _Size = _Mybase::_Mysize;
+	auto _Xs = _Mybase::_Myxs.data(), _Ys = _Mybase::_Myys.data();
+	_Mybase::_Myoutside.clear();
 	for (diff_t j = -_Radius, r = 0; j <= _Radius; ++j, ++r) {
 		const auto y = _Cur_y + static_cast<value_type>(j);
-		auto _Rc = _Mycur[r];
 		for (diff_t i = -_Radius, c = 0; i <= _Radius; ++i, ++c) {
 			const auto x = static_cast<value_type>(i) + _Cur_x;
-			_IF_WITHIN_RANGE(_Mean += _Rc[c] = (*_Myimcur)(x, y));
+			_IF_WITHIN_RANGE((_Xs[r*_Size+c] = x, _Ys[r*_Size+c] = y));
 		}
 	}
+	_Mybase::_Interp_batch();
 
-	_Mycur = _Mycur - (_Mean /= sq(_Mybase::_Mysize));
+	_Mycur = _Mycur - (_Mycur.sum() / sq(_Size));
 	const auto _Issd = one<value_type>/sqrt(sq(_Mycur).sum());
 	_Mycur = _Mycur * _Issd;
 	return (_Mycur);
@@ -287,21 +344,23 @@ auto& _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<1>>::_Warp(const param_type& _Par)
 	const auto v = _Par[3], dvdx = _Par[4], dvdy = _Par[5];
 	const auto _Cur_x = _Mypos[0] + u, _Cur_y = _Mypos[1] + v;
 
-	auto _Mean = zero<value_type>;
+	const auto _Size = _Mybase::_Mysize;
+	auto _Xs = _Mybase::_Myxs.data(), _Ys = _Mybase::_Myys.data();
+	_Mybase::_Myoutside.clear();
 	for (diff_t j = -_Radius, r = 0; j <= _Radius; ++j, ++r) {
 		const auto dy = static_cast<value_type>(j);
 		const auto tx = _Cur_x + dudy * dy;
 		const auto ty = _Cur_y + (1 + dvdy) * dy;
-		auto _Rc = _Mycur[r];
 		for (diff_t i = -_Radius, c = 0; i <= _Radius; ++i, ++c) {
 			const auto dx = static_cast<value_type>(i);
 			const auto x = (1 + dudx)* dx + tx;
 			const auto y = dvdx * dx + ty;
-			_IF_WITHIN_RANGE(_Mean += _Rc[c] = (*_Myimcur)(x, y));
+			_IF_WITHIN_RANGE((_Xs[r*_Size+c] = x, _Ys[r*_Size+c] = y));
 		}
 	}
+	_Mybase::_Interp_batch();
 
-	_Mycur = _Mycur - (_Mean /= sq(_Mybase::_Mysize));
+	_Mycur = _Mycur - (_Mycur.sum() / sq(_Size));
 	const auto _Issd = one<value_type> / sqrt(sq(_Mycur).sum());
 	_Mycur = _Mycur * _Issd;
 
@@ -314,12 +373,14 @@ auto& _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<0>>::_Diff() {
 	const auto _Size = _Mybase::_Mysize;
 	const auto[_L, _R, _U, _D] = _Myopt.range<true>(_Mypos);
 	const auto _Off = -static_cast<value_type>(_Myopt._Radius);
+	const auto _Cached = _Mybase::_Is_cached(_Mypos);
 
 	for (index_t iy = _U, j = 0; iy < _D; ++iy, ++j) {
 		const auto y = _Mypos.y + _Off + j;
 		for (index_t ix = _L, i = 0; ix < _R; ++ix, ++i) {
 			const auto x = _Mypos.x + _Off + i;
-			const auto[dfdx, dfdy] = _Myimref->grad({ x, y });
+			const auto[dfdx, dfdy] = _Cached ? 
+				_Mycache->grad(ix, iy) : _Myimref->grad({ x, y });
 
 			auto q = _Mybase::_Myjaco[j * _Size + i];
 			q[0] = dfdx, q[1] = dfdy;
@@ -333,6 +394,7 @@ auto& _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<1>>::_Diff() {
 	const auto _Size = _Mybase::_Mysize;
 	const auto[_L, _R, _U, _D] = _Myopt.range<true>(_Mypos);
 	const auto _Off = -static_cast<value_type>(_Myopt._Radius);
+	const auto _Cached = _Mybase::_Is_cached(_Mypos);
 
 	for (index_t iy = _U, j = 0; iy < _D; ++iy, ++j) {
 		const auto dy = _Off + j;
@@ -340,7 +402,8 @@ auto& _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<1>>::_Diff() {
 		for (index_t ix = _L, i = 0; ix < _R; ++ix, ++i) {
 			const auto dx = _Off + i;
 			const auto x = _Mypos.x + dx;
-			const auto[dfdx, dfdy] = _Myimref->grad({ x, y });
+			const auto[dfdx, dfdy] = _Cached ? 
+				_Mycache->grad(ix, iy) : _Myimref->grad({ x, y });
 
 			auto q = _Mybase::_Myjaco[j * _Size + i];
 			q[0] = dfdx, q[1] = dfdx * dx, q[2] = dfdx * dy;
@@ -357,6 +420,7 @@ auto _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<1>>::_Diff(value_type cx, value_typ
 	const size_t _Size = _Mybase::_Mysize;
 	const auto [_L, _R, _U, _D] = _Myopt.range<true>(point_type{ cx,cy });
 	const auto _Off = -static_cast<value_type>(_Myopt._Radius);
+	const auto _Cached = _Mybase::_Is_cached(point_type{ cx,cy });
 
 	typename _Mybase::jacob_type _Jacobian(sq(_Size));
 	for (index_t iy = _U, j = 0; iy < _D; ++iy, ++j) {
@@ -365,7 +429,8 @@ auto _Corr_solver_impl<_Ty, _Itag, _Alg_icgn<1>>::_Diff(value_type cx, value_typ
 		for (index_t ix = _L, i = 0; ix < _R; ++ix, ++i) {
 			const auto dx = _Off + i;
 			const auto x = cx + dx;
-			const auto [dfdx, dfdy] = _Myimref->grad({ x, y });
+			const auto [dfdx, dfdy] = _Cached ? 
+				_Mycache->grad(ix, iy) : _Myimref->grad({ x, y });
 
 			auto q = _Jacobian[j * _Size + i];
 			q[0] = dfdx, q[1] = dfdx * dx, q[2] = dfdx * dy;
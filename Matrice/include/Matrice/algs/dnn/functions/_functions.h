@@ -18,13 +18,91 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include <core/matrix.h>
 #include <core/scalar.h>
 #include <internal/expr_base.hpp>
+#ifdef MATRICE_SIMD_ARCH
+#include <arch/simd.h>
+#endif
 
 DGE_MATRICE_BEGIN
 namespace dnn {
+namespace detail {
+/**
+ *\brief Scalar type of a scalar or a SIMD packet '_Pty'.
+ */
+template<typename _Pty, bool = is_scalar_v<_Pty>>
+struct _Scalar_of { using type = _Pty; };
+template<typename _Pty>
+struct _Scalar_of<_Pty, false> { using type = typename _Pty::value_t; };
+
+/**
+ *\brief Rational approximation of tanh(x) for a scalar or a SIMD packet,
+  which is a (13, 6)-degree minimax fit on the clamped range [-7.9, 7.9]
+  with the absolute error below 4e-7.
+ */
+template<typename _Pty>
+MATRICE_HOST_FINL _Pty _Tanh_approx(const _Pty& x) noexcept {
+	using value_t = typename _Scalar_of<_Pty>::type;
+	constexpr auto _Clip = value_t(7.90531110763549805);
+	_Pty _Tmp;
+	if constexpr (is_scalar_v<_Pty>) {
+		_Tmp = (MATRICE_STD(min))((MATRICE_STD(max))(x, -_Clip), _Clip);
+	}
+#ifdef MATRICE_SIMD_ARCH
+	else {
+		_Tmp = simd::min(simd::max(x, _Pty(-_Clip)), _Pty(_Clip));
+	}
+#endif
+	const _Pty _X = _Tmp;
+	const _Pty _X2 = _X * _X;
+	const _Pty _P = _X * (value_t(4.89352455891786e-03) + _X2 * (value_t(6.37261928875436e-04) +
+		_X2 * (value_t(1.48572235717979e-05) + _X2 * (value_t(5.12229709037114e-08) +
+		_X2 * (value_t(-8.60467152213735e-11) + _X2 * (value_t(2.00018790482477e-13) +
+		_X2 * value_t(-2.76076847742355e-16)))))));
+	const _Pty _Q = value_t(4.89352518554385e-03) + _X2 * (value_t(2.26843463243900e-03) +
+		_X2 * (value_t(1.18534705686654e-04) + _X2 * value_t(1.19825839466702e-06)));
+	return _P / _Q;
+}
+
+/**
+ *\brief Evaluate _Dst[i] = _Op(_Srcs[i]...) for i in [0, n), over SIMD
+  packets with a scalar tail. '_Op' is called with either packets or
+  scalars, and '_Dst' may alias any of the sources.
+ */
+template<typename _Ty, typename _Op, typename... _Ptrs>
+MATRICE_HOST_INL void _Ewise_apply(size_t n, _Ty* _Dst, _Op&& _Fn, const _Ptrs... _Srcs) noexcept {
+	size_t i = 0;
+#ifdef MATRICE_SIMD_ARCH
+	using packet_type = simd::Packet_<_Ty>;
+	constexpr auto _Step = size_t(packet_type::size);
+	for (; i + _Step <= n; i += _Step) {
+		_Fn(packet_type(const_cast<_Ty*>(_Srcs + i))...).unpack(_Dst + i);
+	}
+#endif
+	for (; i < n; ++i) _Dst[i] = _Fn(_Srcs[i]...);
+}
+}
 
 ///<functional> implementations for DNNs </functional>
 struct functional {
 
+/* Identity activation function, for plain linear layers */
+struct identity {
+	template<typename _Ty>
+	MATRICE_GLOBAL_INL static _Ty forward(const _Ty& x) {
+		return (x);
+	}
+	template<typename _Pty>
+	MATRICE_HOST_FINL static _Pty kernel(const _Pty& x) noexcept {
+		return (x);
+	}
+	template<typename _Ty>
+	MATRICE_HOST_INL static void forward(size_t n, const _Ty* x, _Ty* y) noexcept {
+		if (x != y) MATRICE_STD(copy)(x, x + n, y);
+	}
+	template<typename _Ty>
+	MATRICE_HOST_INL static void backward(size_t, _Ty*, const _Ty*) noexcept {
+	}
+};
+
 /* Sigmoid activation function */
 struct sigmoid {
 	/**
@@ -57,9 +135,36 @@ struct sigmoid {
 	 */
 	template<typename _Ty>
 	MATRICE_GLOBAL_INL static _Ty& backward(_Ty& g, const _Ty& y) {
-		const auto jac = sigmoid::grad(y);
+		g = g * sigmoid::grad(y);
 		return (g);
 	}
+	/**
+	 *\brief for executing nodal activation of a scalar or a SIMD packet:
+	  //tex:
+	  //$$\sigma(x) = \dfrac{1}{2}+\dfrac{1}{2}\tanh(\dfrac{x}{2})$$
+	  where tanh is evaluated with a rational approximation.
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_FINL static _Pty kernel(const _Pty& x) noexcept {
+		using value_t = typename detail::_Scalar_of<_Pty>::type;
+		return value_t(0.5) + value_t(0.5) * detail::_Tanh_approx<_Pty>(value_t(0.5) * x);
+	}
+	/**
+	 *\brief for executing nodal activations of 'n' elements, 'y' may alias 'x'.
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL static void forward(size_t n, const _Ty* x, _Ty* y) noexcept {
+		detail::_Ewise_apply(n, y, [](const auto& _X) { return kernel(_X); }, x);
+	}
+	/**
+	 *\brief backward update 'n' gradients 'g' in-place, with the data 'y'
+	  produced by forward().
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL static void backward(size_t n, _Ty* g, const _Ty* y) noexcept {
+		detail::_Ewise_apply(n, g, [](const auto& _G, const auto& _Y) {
+			return _G * (_Y * (_Ty(1) - _Y)); }, g, y);
+	}
 };
 
 /* Tanh activation function */
@@ -94,9 +199,33 @@ struct tanh {
 	 */
 	template<typename _Ty>
 	MATRICE_GLOBAL_INL static _Ty& backward(_Ty& g, const _Ty& y) {
-		const auto jac = tanh::grad(y);
+		g = g * tanh::grad(y);
 		return (g);
 	}
+	/**
+	 *\brief for executing nodal activation of a scalar or a SIMD packet
+	  with a rational approximation.
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_FINL static _Pty kernel(const _Pty& x) noexcept {
+		return detail::_Tanh_approx<_Pty>(x);
+	}
+	/**
+	 *\brief for executing nodal activations of 'n' elements, 'y' may alias 'x'.
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL static void forward(size_t n, const _Ty* x, _Ty* y) noexcept {
+		detail::_Ewise_apply(n, y, [](const auto& _X) { return kernel(_X); }, x);
+	}
+	/**
+	 *\brief backward update 'n' gradients 'g' in-place, with the data 'y'
+	  produced by forward().
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL static void backward(size_t n, _Ty* g, const _Ty* y) noexcept {
+		detail::_Ewise_apply(n, g, [](const auto& _G, const auto& _Y) {
+			return _G * (_Ty(1) - _Y * _Y); }, g, y);
+	}
 };
 
 /* Rectified Linear Unit activation function */
@@ -137,9 +266,38 @@ struct relu {
 	 */
 	template<typename _Ty>
 	MATRICE_GLOBAL_INL static _Ty& backward(_Ty& g, const _Ty& y) {
-		const auto jac = relu::grad(y);
+		g = g * relu::grad(y);
 		return (g);
 	}
+	/**
+	 *\brief for executing nodal activation of a scalar or a SIMD packet.
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_FINL static _Pty kernel(const _Pty& x) noexcept {
+		if constexpr (is_scalar_v<_Pty>) {
+			return (MATRICE_STD(max))(x, _Pty(0));
+		}
+#ifdef MATRICE_SIMD_ARCH
+		else {
+			return simd::max(x, _Pty(typename _Pty::value_t(0)));
+		}
+#endif
+	}
+	/**
+	 *\brief for executing nodal activations of 'n' elements, 'y' may alias 'x'.
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL static void forward(size_t n, const _Ty* x, _Ty* y) noexcept {
+		detail::_Ewise_apply(n, y, [](const auto& _X) { return kernel(_X); }, x);
+	}
+	/**
+	 *\brief backward update 'n' gradients 'g' in-place, with the data 'y'
+	  produced by forward().
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL static void backward(size_t n, _Ty* g, const _Ty* y) noexcept {
+		for (size_t i = 0; i < n; ++i) g[i] = y[i] > 0 ? g[i] : _Ty(0);
+	}
 };
 
 /// <summary>
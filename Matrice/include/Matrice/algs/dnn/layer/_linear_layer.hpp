@@ -18,6 +18,8 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include "_layer_base.hpp"
 #include "_input_layer.hpp"
+#include "../functions/_functions.h"
+#include "private/math/_gemm_kernel.hpp"
 
 MATRICE_NAMESPACE_BEGIN(dnn)
 namespace detail {
@@ -38,19 +40,147 @@ struct _Layer_traits<_Linear_layer<_Input, _Out, _HasBias>> {
 };
 
 /// <summary>
-/// \brief Specialize to the input with type of 1-row and fixed-column matrix.
+/// \brief GEMM epilogue of linear layers, which adds the bias and applies
+/// the activation '_Act' to a row segment of the output.
+/// </summary>
+template<typename _Ty, typename _Act, bool _HasBias>
+struct _Linear_epilogue {
+	MATRICE_HOST_FINL void operator()(_Ty* _Y, size_t, size_t _Col, size_t _Len) const noexcept {
+		if constexpr (_HasBias) {
+			_Ewise_apply(_Len, _Y, [](const auto& _Z, const auto& _B) {
+				return _Act::kernel(_Z + _B); }, _Y, _Mybias + _Col);
+		}
+		else {
+			_Act::forward(_Len, _Y, _Y);
+		}
+	}
+	const _Ty* _Mybias = nullptr;
+};
+
+/// <summary>
+/// \brief Parameters of a linear layer and the batched kernels on them.
+/// A batch of row features X ('_Batch' x _N) is mapped to Y = act(X*W+b)
+/// by the native GEMM kernel, with the bias and the activation fused in
+/// its epilogue. The gradient buffers have fixed sizes and are owned by
+/// the layer, so a training step does not allocate.
+/// </summary>
+template<typename _Ty, size_t _N, size_t _Out, bool _HasBias>
+class _Linear_params {
+	using _Mykernel = dgelom::detail::_Gemm_kernel<_Ty>;
+public:
+	using value_type = _Ty;
+	using weight_type = Matrix_<value_type, _N, _Out>;
+	using bias_type = Matrix_<value_type, 1, _Out>;
+
+	_Linear_params() noexcept
+		: _Myweights(weight_type::randn()), _Mybias(bias_type::zeros()) {
+	}
+
+	MATRICE_HOST_INL decltype(auto) weights() const noexcept {
+		return (_Myweights);
+	}
+	MATRICE_HOST_INL decltype(auto) weights() noexcept {
+		return (_Myweights);
+	}
+	MATRICE_HOST_INL decltype(auto) bias() const noexcept {
+		return (_Mybias);
+	}
+	MATRICE_HOST_INL decltype(auto) bias() noexcept {
+		return (_Mybias);
+	}
+	/**
+	 * \brief Gradients w.r.t. the weights and the bias, which are
+	          produced by the last call of the batched backward().
+	 */
+	MATRICE_HOST_INL decltype(auto) grad_weights() const noexcept {
+		return (_Mygradw);
+	}
+	MATRICE_HOST_INL decltype(auto) grad_bias() const noexcept {
+		return (_Mygradb);
+	}
+
+	/**
+	 * \brief Batched forward evaluation, Y = act(X*W+b).
+	 * \param '_X' row-major input of '_Batch' x _N.
+	 * \param '_Y' row-major output of '_Batch' x _Out.
+	 */
+	template<typename _Act = functional::identity>
+	MATRICE_HOST_INL void forward(size_t _Batch, const value_type* _X, value_type* _Y) const {
+		if constexpr (!_HasBias && is_same_v<_Act, functional::identity>) {
+			_Mykernel::eval(_Batch, _Out, _N, _X, _N, _Myweights.data(), _Out, _Y, _Out);
+		}
+		else {
+			const _Linear_epilogue<value_type, _Act, _HasBias> _Epilogue{ _Mybias.data() };
+			_Mykernel::eval(_Batch, _Out, _N, _X, _N, _Myweights.data(), _Out, _Y, _Out, _Epilogue);
+		}
+	}
+
+	/**
+	 * \brief Batched backward evaluation, which overwrites the gradients
+	          w.r.t. the weights and the bias with those of the batch.
+	 * \param '_X' the input batch, and '_Y' the output of forward<_Act>().
+	 * \param '_Dy' gradients w.r.t. '_Y', which are overwritten with the
+	          gradients w.r.t. the pre-activations X*W+b.
+	 * \param '_Dx' optional output of the gradients w.r.t. '_X'.
+	 */
+	template<typename _Act = functional::identity>
+	MATRICE_HOST_INL void backward(size_t _Batch, const value_type* _X, const value_type* _Y,
+		value_type* _Dy, value_type* _Dx = nullptr) {
+		_Act::backward(_Batch * _Out, _Dy, _Y);
+
+		// \dW = X^T*dZ, db = sum of the rows of dZ
+		_Mykernel::template eval<true, false>(_N, _Out, _Batch, _X, _N, _Dy, _Out, _Mygradw.data(), _Out);
+		if constexpr (_HasBias) {
+			const auto _Db = _Mygradb.data();
+			MATRICE_STD(fill)(_Db, _Db + _Out, value_type(0));
+			for (size_t i = 0; i < _Batch; ++i) {
+				_Ewise_apply(_Out, _Db, [](const auto& _B, const auto& _G) {
+					return _B + _G; }, _Db, _Dy + i * _Out);
+			}
+		}
+
+		// \dX = dZ*W^T
+		if (_Dx) {
+			_Mykernel::template eval<false, true>(_Batch, _N, _Out, _Dy, _Out, _Myweights.data(), _Out, _Dx, _N);
+		}
+	}
+
+	/**
+	 * \brief Update the parameters with the gradients by a descent step,
+	          W = W - _Lr*dW and b = b - _Lr*db.
+	 */
+	MATRICE_HOST_INL void update(value_type _Lr) noexcept {
+		const auto _Step = [_Lr](const auto& _P, const auto& _G) {
+			return _P - _Lr * _G; };
+		_Ewise_apply(_Myweights.size(), _Myweights.data(), _Step, _Myweights.data(), _Mygradw.data());
+		if constexpr (_HasBias) {
+			_Ewise_apply(_Mybias.size(), _Mybias.data(), _Step, _Mybias.data(), _Mygradb.data());
+		}
+	}
+
+protected:
+	weight_type _Myweights, _Mygradw;
+	bias_type _Mybias, _Mygradb;
+};
+
+/// <summary>
+/// \brief Specialize to the input with type of fixed-size matrix.
 /// </summary>
 /// <typeparam name="_Ty"></typeparam>
-template<typename _Ty, int _M, int _N, size_t _Out>
-class _Linear_layer<_Input_layer<Matrix_<_Ty, _M, _N>>, _Out, false> 
-	: public _Layer<_Linear_layer<_Input_layer<Matrix_<_Ty, _M, _N>>, _Out, false>> {
+template<typename _Ty, int _M, int _N, size_t _Out, bool _HasBias>
+class _Linear_layer<_Input_layer<Matrix_<_Ty, _M, _N>>, _Out, _HasBias> 
+	: public _Layer<_Linear_layer<_Input_layer<Matrix_<_Ty, _M, _N>>, _Out, _HasBias>>,
+	public _Linear_params<_Ty, _N, _Out, _HasBias> {
+	using _Myparams = _Linear_params<_Ty, _N, _Out, _HasBias>;
 public:
 	using category = _Layer_tag::linear;
 	using input_t = _Input_layer<Matrix_<_Ty, _M, _N>>;
 	using value_t = _Ty;
+	using typename _Myparams::value_type;
+	using _Myparams::forward;
+	using _Myparams::backward;
 
 	_Linear_layer() noexcept {
-		_Myweights = decltype(_Myweights)::randn();
 	}
 	
 	MATRICE_GLOBAL_INL constexpr auto insize() const noexcept {
@@ -67,33 +197,43 @@ public:
 	 * \brief Forward computation with lazy evaluation.
 	 * \return Expression of $matmul(X,W)$, and requires
 	           to call the method 'eval()' to collect the
-			   output feature vector.
+			   output feature vector. The bias is not included.
 	 */
 	MATRICE_GLOBAL_INL auto operator()(const input_t& _X) const noexcept {
-		return _X.data().mul(_Myweights);
+		return _X.data().mul(this->_Myweights);
 	}
 	/**
 	 * \brief Inplace forward evaluation.
 	 * \return The resulted feature vector. 
 	 */
 	MATRICE_GLOBAL_INL auto forward(const input_t& _X) const {
-		return this->operator()(_X).eval();
+		auto _Y = this->operator()(_X).eval();
+		if constexpr (_HasBias) {
+			for (auto r = 0; r < _M; ++r)
+				for (auto c = 0; c < int(_Out); ++c) _Y[r][c] += this->_Mybias(c);
+		}
+		return _Y;
 	}
-
-protected:
-	Matrix_<value_t, _N, _Out> _Myweights;
 };
 
-template<typename _Ty, int _N, size_t _Out>
-class _Linear_layer<_Input_layer<Matrix_<_Ty, 1, _N>>, _Out, false>
-	: public _Layer<_Linear_layer<_Input_layer<Matrix_<_Ty, 1, _N>>, _Out, false>> {
+/// <summary>
+/// \brief Specialize to the input with type of 1-row and fixed-column matrix.
+/// </summary>
+/// <typeparam name="_Ty"></typeparam>
+template<typename _Ty, int _N, size_t _Out, bool _HasBias>
+class _Linear_layer<_Input_layer<Matrix_<_Ty, 1, _N>>, _Out, _HasBias>
+	: public _Layer<_Linear_layer<_Input_layer<Matrix_<_Ty, 1, _N>>, _Out, _HasBias>>,
+	public _Linear_params<_Ty, _N, _Out, _HasBias> {
+	using _Myparams = _Linear_params<_Ty, _N, _Out, _HasBias>;
 public:
 	using category = _Layer_tag::linear;
 	using input_t = _Input_layer<Matrix_<_Ty, 1, _N>>;
 	using value_t = _Ty;
+	using typename _Myparams::value_type;
+	using _Myparams::forward;
+	using _Myparams::backward;
 
 	_Linear_layer() noexcept {
-		_Myweights = decltype(_Myweights)::randn();
 	}
 
 	MATRICE_GLOBAL_INL constexpr auto insize() const noexcept {
@@ -110,32 +250,33 @@ public:
 	 * \brief Forward computation with lazy evaluation.
 	 * \return Expression of $matmul(X,W)$, and requires
 			   to call the method 'eval()' to collect the
-			   output feature vector.
+			   output feature vector. The bias is not included.
 	 */
 	MATRICE_GLOBAL_INL auto operator()(const input_t& _X) const noexcept {
-		return _X.data().mul(_Myweights);
+		return _X.data().mul(this->_Myweights);
 	}
 	/**
 	 * \brief Inplace forward evaluation.
 	 * \return The resulted feature vector.
 	 */
 	MATRICE_GLOBAL_INL auto forward(const input_t& _X) const {
-		return this->operator()(_X).eval();
+		auto _Y = this->operator()(_X).eval();
+		if constexpr (_HasBias) {
+			for (auto c = 0; c < int(_Out); ++c) _Y(c) += this->_Mybias(c);
+		}
+		return _Y;
 	}
-
-protected:
-	Matrix_<value_t, _N, _Out> _Myweights;
 };
 
 /// <summary>
 /// \brief Specialize to the input with type of fixed vector.
 /// </summary>
-template<typename _Ty, int _N, size_t _Out>
-class _Linear_layer<_Input_layer<Vec_<_Ty, _N>>, _Out, false> :
-	public _Linear_layer<_Input_layer<Matrix_<_Ty, 1, _N>>, _Out, false> {
+template<typename _Ty, int _N, size_t _Out, bool _HasBias>
+class _Linear_layer<_Input_layer<Vec_<_Ty, _N>>, _Out, _HasBias> :
+	public _Linear_layer<_Input_layer<Matrix_<_Ty, 1, _N>>, _Out, _HasBias> {
 };
 
 }
 template<typename _Input, size_t _Out, bool _HasBias=false>
 using linear_layer = detail::_Linear_layer<_Input, _Out, _HasBias>;
-MATRICE_NAMESPACE_END(dnn)
+MATRICE_NAMESPACE_END(dnn)
\ No newline at end of file
@@ -0,0 +1,167 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "core/matrix.h"
+#include "private/math/_gemm_kernel.hpp"
+
+// \brief Number of query rows of an attention tile.
+#ifndef MATRICE_ATTENTION_BQ
+#define MATRICE_ATTENTION_BQ 32
+#endif
+// \brief Number of key rows streamed into an attention tile at a time.
+#ifndef MATRICE_ATTENTION_BK
+#define MATRICE_ATTENTION_BK 128
+#endif
+
+MATRICE_NAMESPACE_BEGIN(dnn)
+namespace detail {
+/// <summary>
+/// \brief Fused attention kernel, O = softmax(s*Q*K^T)*V with row-major
+/// operands. Queries are split into tiles of BQ rows. Each tile streams
+/// the keys and values in blocks of BK rows and keeps a running max and
+/// a running sum for every query (online softmax). The score matrix is
+/// therefore never formed: a thread only holds a BQ x BK block of scores
+/// and a BQ x Dv block of partial outputs, and the memory is linear in the
+/// sequence length. The tiles of all heads run in parallel.
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+template<typename _Ty> class _Attention_kernel {
+	using _Mygemm = dgelom::detail::_Gemm_kernel<_Ty>;
+public:
+	using value_type = _Ty;
+	static constexpr size_t BQ = MATRICE_ATTENTION_BQ;
+	static constexpr size_t BK = MATRICE_ATTENTION_BK;
+
+	/**
+	 *\brief Evaluate '_Heads' heads of attention over 'Lq' queries and
+	         'Lk' keys. The h-th head reads the columns [h*D, (h+1)*D) of
+	         Q and K and the columns [h*Dv, (h+1)*Dv) of V, and writes the
+	         columns [h*Dv, (h+1)*Dv) of O.
+	 *\param '_Ldq', '_Ldk', '_Ldv' and '_Ldo' are the leading dimensions.
+	 *\param '_Scale' factor of the scores, usually 1/sqrt(D).
+	 */
+	static MATRICE_HOST_INL void eval(size_t _Heads, size_t Lq, size_t Lk, size_t D, size_t Dv,
+		const value_type* Q, size_t _Ldq, const value_type* K, size_t _Ldk,
+		const value_type* V, size_t _Ldv, value_type* O, size_t _Ldo, value_type _Scale) {
+		const auto _Ntiles = (Lq + BQ - 1) / BQ;
+		const auto _Ntasks = index_t(_Heads * _Ntiles);
+#pragma omp parallel for schedule(dynamic) if(_Ntasks > 1)
+		for (index_t _Task = 0; _Task < _Ntasks; ++_Task) {
+			const auto h = size_t(_Task) / _Ntiles;
+			const auto i = size_t(_Task) % _Ntiles * BQ;
+			_Tile((MATRICE_STD(min))(BQ, Lq - i), Lk, D, Dv,
+				Q + i * _Ldq + h * D, _Ldq, K + h * D, _Ldk, V + h * Dv, _Ldv,
+				O + i * _Ldo + h * Dv, _Ldo, _Scale);
+		}
+	}
+
+private:
+	template<size_t _Idx>
+	static MATRICE_HOST_INL auto& _Buffer(size_t _Size) {
+		static thread_local MATRICE_STD(vector)<value_type> _Buf;
+		if (_Buf.size() < _Size) _Buf.resize(_Size);
+		return (_Buf);
+	}
+
+	/**
+	 *\brief Evaluate the attention of a tile of '_Bq' queries.
+	 */
+	static MATRICE_HOST_INL void _Tile(size_t _Bq, size_t Lk, size_t D, size_t Dv,
+		const value_type* Q, size_t _Ldq, const value_type* K, size_t _Ldk,
+		const value_type* V, size_t _Ldv, value_type* O, size_t _Ldo, value_type _Scale) {
+		const auto _S = _Buffer<0>(BQ * BK).data();
+		const auto _Pv = _Buffer<1>(BQ * Dv).data();
+		// \running max, running sum and rescaling factor of each query
+		const auto _Max = _Buffer<2>(3 * BQ).data();
+		const auto _Sum = _Max + BQ, _Alpha = _Sum + BQ;
+
+		for (size_t r = 0; r < _Bq; ++r) {
+			_Max[r] = -MATRICE_STD(numeric_limits)<value_type>::infinity();
+			_Sum[r] = value_type(0);
+			MATRICE_STD(fill)(O + r * _Ldo, O + r * _Ldo + Dv, value_type(0));
+		}
+
+		for (size_t j = 0; j < Lk; j += BK) {
+			const auto _Bk = (MATRICE_STD(min))(BK, Lk - j);
+
+			// \scores of the block, S = Q*K_j^T
+			_Mygemm::template eval<false, true>(_Bq, _Bk, D, Q, _Ldq, K + j * _Ldk, _Ldk, _S, BK);
+
+			// \online softmax, S is overwritten with exp(s*S - max)
+			for (size_t r = 0; r < _Bq; ++r) {
+				const auto _Sr = _S + r * BK;
+				auto _Mr = _Max[r];
+				for (size_t c = 0; c < _Bk; ++c) {
+					_Sr[c] *= _Scale;
+					_Mr = (MATRICE_STD(max))(_Mr, _Sr[c]);
+				}
+				auto _Lr = value_type(0);
+				for (size_t c = 0; c < _Bk; ++c) {
+					_Sr[c] = MATRICE_STD(exp)(_Sr[c] - _Mr);
+					_Lr += _Sr[c];
+				}
+				_Alpha[r] = MATRICE_STD(exp)(_Max[r] - _Mr);
+				_Sum[r] = _Sum[r] * _Alpha[r] + _Lr;
+				_Max[r] = _Mr;
+			}
+
+			// \partial outputs of the block, O = alpha*O + S*V_j
+			_Mygemm::eval(_Bq, Dv, _Bk, _S, BK, V + j * _Ldv, _Ldv, _Pv, Dv);
+			for (size_t r = 0; r < _Bq; ++r) {
+				const auto _Or = O + r * _Ldo, _Pr = _Pv + r * Dv;
+				const auto _Ar = _Alpha[r];
+				for (size_t c = 0; c < Dv; ++c) _Or[c] = _Or[c] * _Ar + _Pr[c];
+			}
+		}
+
+		if (Lk == 0) return;
+		for (size_t r = 0; r < _Bq; ++r) {
+			const auto _Or = O + r * _Ldo;
+			const auto _Inv = value_type(1) / _Sum[r];
+			for (size_t c = 0; c < Dv; ++c) _Or[c] *= _Inv;
+		}
+	}
+};
+}
+
+/// <summary>
+/// \brief FUNCTION, multi-head attention softmax(Q*K^T/sqrt(D))*V, where
+/// Q is Lq x (heads*D), K is Lk x (heads*D) and V is Lk x (heads*Dv).
+/// The memory footprint is linear in the sequence lengths.
+/// \sa detail::_Attention_kernel
+/// </summary>
+/// <returns>Lq x (heads*Dv) matrix of the attended values.</returns>
+template<typename _Ty>
+MATRICE_HOST_INL Matrix<_Ty> attention(const Matrix<_Ty>& Q,
+	const Matrix<_Ty>& K, const Matrix<_Ty>& V, size_t heads = 1) {
+	DGELOM_CHECK(Q.cols() == K.cols(), "Q and K must have the same number of columns.");
+	DGELOM_CHECK(K.rows() == V.rows(), "K and V must have the same number of rows.");
+	DGELOM_CHECK(heads > 0 && Q.cols() % heads == 0 && V.cols() % heads == 0,
+		"The columns of Q and V must be divisible by the number of heads.");
+
+	const auto D = size_t(Q.cols()) / heads, Dv = size_t(V.cols()) / heads;
+	Matrix<_Ty> O(Q.rows(), V.cols());
+	detail::_Attention_kernel<_Ty>::eval(heads, Q.rows(), K.rows(), D, Dv,
+		Q.data(), Q.cols(), K.data(), K.cols(), V.data(), V.cols(),
+		O.data(), O.cols(), _Ty(1) / MATRICE_STD(sqrt)(_Ty(D)));
+	return O;
+}
+MATRICE_NAMESPACE_END(dnn)
@@ -20,6 +20,7 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include "core/vector.h"
 #include "algs/dnn/functions.h"
 #include "algs/dnn/modules.h"
+#include "_attention_kernel.hpp"
 
 MATRICE_NAMESPACE_BEGIN(dnn)
 namespace detail {
@@ -49,23 +50,16 @@ public:
 		_MyV = _Myproj_v(_Myinput);
 	}
 
+	/**
+	 * \brief Evaluate the self-attention softmax(Q*K^T)*V with the fused
+	   kernel, which streams K and V and never forms the score matrix.
+	 * \sa detail::_Attention_kernel
+	 */
 	MATRICE_GLOBAL_INL auto forward() const {
 		Matrix_<value_t, depth, _Embed> _Out;
-		for (auto d = 0; d < depth; ++d) {
-			// compute 'self' scores
-			const auto Q = _MyQ.rview(d).eval();;
-			auto _Scores = _MyK.mul(Q.t()).eval();
-
-			// softmax weights
-			using softmax = functional::softmax<decltype(_Scores)>;
-			_Scores = softmax::forward(_Scores);
-
-			// averaging
-			auto V = _Scores.spreadmul(_MyV).eval();
-
-			// sum over all averaged values
-			_Out.rview(d) = V.reduce<0>();
-		}
+		_Attention_kernel<value_t>::eval(1, depth, depth, _Embed, _Embed,
+			_MyQ.data(), _Embed, _MyK.data(), _Embed, _MyV.data(), _Embed,
+			_Out.data(), _Embed, value_t(1));
 		return _Out;
 	}
 
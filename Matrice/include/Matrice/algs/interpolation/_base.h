@@ -179,10 +179,38 @@ public:
 			return (this)->_Grady_at(_Pos);
 	}
 
+	/**
+	 * \brief Eval values at '_N' positions {_Xs[i], _Ys[i]} into '_Out'. 
+	 * For B-spline kernels the weights are evaluated for a packet of 
+	 * positions at once, and each sample is then a separable dot with 
+	 * the coeff. LUT. The positions must be inside the image as for 
+	 * operator()(x, y).
+	 */
+	MATRICE_HOST_INL void eval_batch(const value_type* _Xs, const value_type* _Ys, value_type* _Out, size_t _N) const;
+	template<typename _Cont>
+	MATRICE_HOST_INL void eval_batch(const _Cont& _Xs, const _Cont& _Ys, _Cont& _Out) const {
+		DGELOM_CHECK(_Xs.size() == _Ys.size() && _Out.size() >= _Xs.size(),
+			"Inconsistent sizes of positions and outputs in eval_batch(...).");
+		this->eval_batch(_Xs.data(), _Ys.data(), _Out.data(), _Xs.size());
+	}
+
+	/**
+	 * \brief Eval gradients at '_N' positions {_Xs[i], _Ys[i]} into '_Gx' and '_Gy'.
+	 */
+	MATRICE_HOST_INL void grad_batch(const value_type* _Xs, const value_type* _Ys, value_type* _Gx, value_type* _Gy, size_t _N) const;
+	template<typename _Cont>
+	MATRICE_HOST_INL void grad_batch(const _Cont& _Xs, const _Cont& _Ys, _Cont& _Gx, _Cont& _Gy) const {
+		DGELOM_CHECK(_Xs.size() == _Ys.size() && _Gx.size() >= _Xs.size() && _Gy.size() >= _Xs.size(),
+			"Inconsistent sizes of positions and outputs in grad_batch(...).");
+		this->grad_batch(_Xs.data(), _Ys.data(), _Gx.data(), _Gy.data(), _Xs.size());
+	}
+
 protected:
 	MATRICE_HOST_INL auto _Value_at(const point_type& _Pos) const;
 	MATRICE_HOST_INL auto _Gradx_at(const point_type& _Pos) const;
 	MATRICE_HOST_INL auto _Grady_at(const point_type& _Pos) const;
+	template<bool _Is_grad>
+	MATRICE_HOST_INL void _Spline_batch(const value_type* _Xs, const value_type* _Ys, value_type* _O0, value_type* _O1, size_t _N) const;
 
 	std::add_pointer_t<_Mydt> _Mydt_this = static_cast<_Mydt*>(this);
 	const value_type _Myeps{ value_type(1.0e-7) };
@@ -17,6 +17,9 @@ You should have received a copy of the GNU General Public License
 along with this program.If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 #pragma once
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
 
 MATRICE_ALGS_BEGIN
 
@@ -75,4 +78,150 @@ auto _Interpolation_base<_Derived>::_Grady_at(const point_type& _Pos) const {
 
 	return (_Diff_y_n.mul(_Temp.mul(_Diff_x_n).eval()))(0);
 }
+
+// \brief Polynomial weights of a spline kernel '_K' for a block of '_W'
+// positions: _Out[k*_W+l] = sum_m _K(k, m) * _D[l]^m, evaluated with Horner.
+template<size_t _W, size_t _Rows, size_t _Cols, typename _Kty, typename _Ty>
+MATRICE_HOST_FINL void _Spline_weights(const _Kty& _K, const _Ty* _D, _Ty* _Out) noexcept {
+	for (size_t k = 0; k < _Rows; ++k) {
+		const auto _Wk = _Out + k * _W;
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX || MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX512
+		using packet_type = simd::Packet_<_Ty>;
+		static_assert(_W % packet_type::size == 0, "_W must be a multiple of the packet size.");
+		for (size_t l = 0; l < _W; l += packet_type::size) {
+			const packet_type _Pd(_D + l);
+			packet_type _Acc(_K(k, _Cols - 1));
+			for (auto m = _Cols - 1; m-- > 0;) {
+				_Acc = _Acc * _Pd + packet_type(_K(k, m));
+			}
+			_Acc.unpack(_Wk + l);
+		}
+#else
+		for (size_t l = 0; l < _W; ++l) {
+			auto _Acc = _K(k, _Cols - 1);
+			for (auto m = _Cols - 1; m-- > 0;) {
+				_Acc = _Acc * _D[l] + _K(k, m);
+			}
+			_Wk[l] = _Acc;
+		}
+#endif
+	}
+}
+
+// \brief Accumulate the j-th coeff. row of the separable dot for a block of
+// '_W' positions, where _C[i*_W+l] holds the i-th coeff. of the row of the
+// l-th position: _S0[l] += _Vy[l] * sum_i _C[i*_W+l] * _Vx[i*_W+l], and for
+// gradients, _S0 takes the x-grad. weights _Gx, and _S1[l] += _Gy[l] * ...
+template<size_t _W, size_t _N, bool _Is_grad, typename _Ty>
+MATRICE_HOST_FINL void _Spline_dot(const _Ty* _C, const _Ty* _Vx, const _Ty* _Gx,
+	const _Ty* _Vy, const _Ty* _Gy, _Ty* _S0, _Ty* _S1) noexcept {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX || MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX512
+	using packet_type = simd::Packet_<_Ty>;
+	static_assert(_W % packet_type::size == 0, "_W must be a multiple of the packet size.");
+	for (size_t l = 0; l < _W; l += packet_type::size) {
+		packet_type _Rv(zero<_Ty>), _Rg(zero<_Ty>);
+		for (size_t i = 0; i < _N; ++i) {
+			const packet_type _Pc(_C + i * _W + l);
+			_Rv = _Rv + _Pc * packet_type(_Vx + i * _W + l);
+			if constexpr (_Is_grad) _Rg = _Rg + _Pc * packet_type(_Gx + i * _W + l);
+		}
+		if constexpr (_Is_grad) {
+			(packet_type(_S0 + l) + packet_type(_Vy + l) * _Rg).unpack(_S0 + l);
+			(packet_type(_S1 + l) + packet_type(_Gy + l) * _Rv).unpack(_S1 + l);
+		}
+		else {
+			(packet_type(_S0 + l) + packet_type(_Vy + l) * _Rv).unpack(_S0 + l);
+		}
+	}
+#else
+	for (size_t l = 0; l < _W; ++l) {
+		auto _Rv = zero<_Ty>, _Rg = zero<_Ty>;
+		for (size_t i = 0; i < _N; ++i) {
+			_Rv += _C[i * _W + l] * _Vx[i * _W + l];
+			if constexpr (_Is_grad) _Rg += _C[i * _W + l] * _Gx[i * _W + l];
+		}
+		if constexpr (_Is_grad) {
+			_S0[l] += _Vy[l] * _Rg, _S1[l] += _Gy[l] * _Rv;
+		}
+		else _S0[l] += _Vy[l] * _Rv;
+	}
+#endif
+}
+
+template<typename _Derived> template<bool _Is_grad> MATRICE_HOST_INL
+void _Interpolation_base<_Derived>::_Spline_batch(const value_type* _Xs, const value_type* _Ys, value_type* _O0, value_type* _O1, size_t _N) const {
+	constexpr auto Ldv = _Mydt::Ldv, Ldg = _Mydt::Ldg;
+	constexpr auto _L = ~-(Ldv >> 1);
+	constexpr size_t _W = 16;
+	const auto& _Kov = _Mydt_this->_Kernel_of_value();
+	const auto& _Kog = _Mydt_this->_Kernel_of_grad();
+
+	alignas(64) value_type _Dx[_W], _Dy[_W];
+	alignas(64) value_type _Vx[Ldv * _W], _Vy[Ldv * _W];
+	alignas(64) value_type _Gx[Ldv * _W], _Gy[Ldv * _W];
+	alignas(64) value_type _C[Ldv * _W], _S0[_W], _S1[_W];
+	int _Ix[_W], _Iy[_W];
+	for (size_t _Off = 0; _Off < _N; _Off += _W) {
+		const auto _Cnt = min(_W, _N - _Off);
+		for (size_t l = 0; l < _W; ++l) {
+			if (l < _Cnt) {
+				_Ix[l] = floor<int>(_Xs[_Off + l]), _Iy[l] = floor<int>(_Ys[_Off + l]);
+				_Dx[l] = _Xs[_Off + l] - _Ix[l], _Dy[l] = _Ys[_Off + l] - _Iy[l];
+			}
+			else _Dx[l] = _Dy[l] = zero<value_type>;
+		}
+
+		// \weights of all positions in the block.
+		_Spline_weights<_W, Ldv, Ldv>(_Kov, _Dx, _Vx);
+		_Spline_weights<_W, Ldv, Ldv>(_Kov, _Dy, _Vy);
+		if constexpr (_Is_grad) {
+			_Spline_weights<_W, Ldv, Ldg>(_Kog, _Dx, _Gx);
+			_Spline_weights<_W, Ldv, Ldg>(_Kog, _Dy, _Gy);
+		}
+
+		// \separable dot with the coeff. LUT, the rows of all positions
+		// are gathered into _C, so that the dot runs across the block.
+		for (size_t l = 0; l < _W; ++l) _S0[l] = _S1[l] = zero<value_type>;
+		for (auto j = 0; j < Ldv; ++j) {
+			for (size_t l = 0; l < _W; ++l) {
+				if (l < _Cnt) {
+					const auto _Row = _Mycoeff[_Iy[l] - _L + j] + (_Ix[l] - _L);
+					for (auto i = 0; i < Ldv; ++i) _C[i * _W + l] = _Row[i];
+				}
+				else for (auto i = 0; i < Ldv; ++i) _C[i * _W + l] = zero<value_type>;
+			}
+			_Spline_dot<_W, Ldv, _Is_grad>(_C, _Vx, _Gx, _Vy + j * _W, _Gy + j * _W, _S0, _S1);
+		}
+		for (size_t l = 0; l < _Cnt; ++l) {
+			_O0[_Off + l] = _S0[l];
+			if constexpr (_Is_grad) _O1[_Off + l] = _S1[l];
+		}
+	}
+}
+
+template<typename _Derived> MATRICE_HOST_INL
+void _Interpolation_base<_Derived>::eval_batch(const value_type* _Xs, const value_type* _Ys, value_type* _Out, size_t _N) const {
+	if constexpr (require_coeff_lut<category>::value) {
+		this->template _Spline_batch<false>(_Xs, _Ys, _Out, nullptr, _N);
+	}
+	else {
+		const auto _This = static_cast<const _Mydt*>(this);
+		for (size_t i = 0; i < _N; ++i) {
+			_Out[i] = (*_This)(point_type(_Xs[i], _Ys[i]));
+		}
+	}
+}
+template<typename _Derived> MATRICE_HOST_INL
+void _Interpolation_base<_Derived>::grad_batch(const value_type* _Xs, const value_type* _Ys, value_type* _Gx, value_type* _Gy, size_t _N) const {
+	if constexpr (require_coeff_lut<category>::value) {
+		this->template _Spline_batch<true>(_Xs, _Ys, _Gx, _Gy, _N);
+	}
+	else {
+		const auto _This = static_cast<const _Mydt*>(this);
+		for (size_t i = 0; i < _N; ++i) {
+			const auto [dfdx, dfdy] = _This->grad(point_type(_Xs[i], _Ys[i]));
+			_Gx[i] = dfdx, _Gy[i] = dfdy;
+		}
+	}
+}
 MATRICE_ALGS_END
\ No newline at end of file
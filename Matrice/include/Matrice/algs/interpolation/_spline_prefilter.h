@@ -0,0 +1,186 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library for
+3D vision and photo-mechanics.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "util/_macros.h"
+#include "util/_type_defs.h"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+// \brief Set to 1 to compute the B-spline coefficients of double images
+// in single precision, which halves the memory traffic of the prefilter.
+#ifndef MATRICE_SPLINE_PREFILTER_F32
+#define MATRICE_SPLINE_PREFILTER_F32 0
+#endif
+
+MATRICE_ALGS_BEGIN
+_DETAIL_BEGIN
+
+/// <summary>
+/// \brief Line kernels of the recursive B-spline filters, each of them
+/// updates '_N' independent lines stored contiguously.
+/// </summary>
+template<typename _Ty> struct _Bspline_lines {
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+	using packet_type = simd::Packet_<_Ty>;
+	static constexpr size_t step = packet_type::size;
+#else
+	static constexpr size_t step = 8;
+#endif
+
+	// \_Acc[i] += _W * _X[i]
+	static MATRICE_HOST_FINL void mac(_Ty* _Acc, const _Ty* _X, _Ty _W, size_t _N) noexcept {
+		size_t i = 0;
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		const packet_type _Pw(_W);
+		for (; i < simd::vsize<step>(_N); i += step) {
+			(packet_type(_Acc + i) + packet_type(_X + i) * _Pw).unpack(_Acc + i);
+		}
+#endif
+		for (; i < _N; ++i) _Acc[i] += _W * _X[i];
+	}
+	// \causal step: _X[i] += _Z * _Prev[i]
+	static MATRICE_HOST_FINL void causal(_Ty* _X, const _Ty* _Prev, _Ty _Z, size_t _N) noexcept {
+		mac(_X, _Prev, _Z, _N);
+	}
+	// \anti-causal step: _X[i] = _Z * (_Next[i] - _X[i])
+	static MATRICE_HOST_FINL void anticausal(_Ty* _X, const _Ty* _Next, _Ty _Z, size_t _N) noexcept {
+		size_t i = 0;
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		const packet_type _Pz(_Z);
+		for (; i < simd::vsize<step>(_N); i += step) {
+			((packet_type(_Next + i) - packet_type(_X + i)) * _Pz).unpack(_X + i);
+		}
+#endif
+		for (; i < _N; ++i) _X[i] = _Z * (_Next[i] - _X[i]);
+	}
+	// \anti-causal initialization: _X[i] = _A * (_X[i] + _Z * _Prev[i])
+	static MATRICE_HOST_FINL void init(_Ty* _X, const _Ty* _Prev, _Ty _A, _Ty _Z, size_t _N) noexcept {
+		size_t i = 0;
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+		const packet_type _Pa(_A), _Pz(_Z);
+		for (; i < simd::vsize<step>(_N); i += step) {
+			((packet_type(_X + i) + packet_type(_Prev + i) * _Pz) * _Pa).unpack(_X + i);
+		}
+#endif
+		for (; i < _N; ++i) _X[i] = _A * (_X[i] + _Z * _Prev[i]);
+	}
+
+	/**
+	 *\brief Apply the causal and anti-causal filters of pole '_Z' along
+	         '_Len' samples, where the k-th sample of all '_N' lines starts
+	         at _X + k*_Ld. '_Acc' is a work buffer with '_N' elements.
+	 */
+	static MATRICE_HOST_INL void filter(_Ty* _X, size_t _Ld, size_t _Len, size_t _N, double _Z, _Ty* _Acc) noexcept {
+		const auto _Zt = static_cast<_Ty>(_Z);
+		const auto _At = static_cast<_Ty>(_Z / (_Z * _Z - 1));
+		const auto _K = (MATRICE_STD(min))(_Len, size_t(
+			MATRICE_STD(log)(MATRICE_STD(numeric_limits)<_Ty>::epsilon()) / MATRICE_STD(log)(MATRICE_STD(abs)(_Z))) + 2);
+
+		// \causal initialization with the truncated sum of the first _K samples
+		MATRICE_STD(fill)(_Acc, _Acc + _N, _Ty(0));
+		auto _Zk = 1.;
+		for (size_t k = 0; k < _K; ++k, _Zk *= _Z) {
+			mac(_Acc, _X + k * _Ld, static_cast<_Ty>(_Zk), _N);
+		}
+		MATRICE_STD(copy)(_Acc, _Acc + _N, _X);
+
+		for (size_t k = 1; k < _Len; ++k) {
+			causal(_X + k * _Ld, _X + (k - 1) * _Ld, _Zt, _N);
+		}
+		init(_X + (_Len - 1) * _Ld, _X + (_Len - 2) * _Ld, _At, _Zt, _N);
+		for (auto k = _Len - 1; k-- > 0;) {
+			anticausal(_X + k * _Ld, _X + (k + 1) * _Ld, _Zt, _N);
+		}
+	}
+};
+
+/// <summary>
+/// \brief Cache-blocked B-spline prefilter with a cascade of poles '_Poles'.
+/// The samples are not scaled by the filter gain, which is absorbed in the
+/// interpolation kernels of _Spline_interpolation.
+/// Rows are processed in blocks of 'step' rows, which are transposed into a
+/// thread-local tile so that the recursion along x runs across rows with SIMD.
+/// Columns are processed in strips of contiguous columns, so the recursion
+/// along y runs across columns with SIMD. Both passes share a parallel region.
+/// </summary>
+/// <typeparam name="_Cty">Compute and output type, e.g. float for the 32-bit mode</typeparam>
+/// <param name="_Src">Source image with '_Rows' x '_Cols' samples in row-major</param>
+/// <param name="_Dst">Output coefficients with the same shape as the source</param>
+template<typename _Cty, typename _Ty, size_t _Np>
+MATRICE_HOST_INL void _Bspline_prefilter(const _Ty* _Src, _Cty* _Dst,
+	size_t _Rows, size_t _Cols, const MATRICE_STD(array)<double, _Np>& _Poles) {
+	using _Lines = _Bspline_lines<_Cty>;
+	constexpr size_t _Blk = _Lines::step;
+	constexpr size_t _Strip = _Blk << 3;
+
+	if (_Rows < 2 || _Cols < 2) {
+		MATRICE_STD(transform)(_Src, _Src + _Rows * _Cols, _Dst,
+			[](const auto& _Val) { return static_cast<_Cty>(_Val); });
+		return;
+	}
+
+	const auto _Nblks = index_t((_Rows + _Blk - 1) / _Blk);
+	const auto _Nstrips = index_t((_Cols + _Strip - 1) / _Strip);
+#pragma omp parallel if(_Rows * _Cols > 65536)
+	{
+		MATRICE_STD(vector)<_Cty> _Tile(_Cols * _Blk), _Acc(_Strip);
+
+		// \pass along x: transposed tiles of '_Blk' rows.
+#pragma omp for schedule(static)
+		for (index_t _B = 0; _B < _Nblks; ++_B) {
+			const auto _R0 = _B * _Blk;
+			const auto _Cnt = (MATRICE_STD(min))(_Blk, _Rows - _R0);
+			for (size_t p = 0; p < _Blk; ++p) {
+				if (p < _Cnt) {
+					const auto _Line = _Src + (_R0 + p) * _Cols;
+					for (size_t x = 0; x < _Cols; ++x)
+						_Tile[x * _Blk + p] = static_cast<_Cty>(_Line[x]);
+				}
+				else for (size_t x = 0; x < _Cols; ++x) _Tile[x * _Blk + p] = _Cty(0);
+			}
+			for (const auto _Z : _Poles) {
+				_Lines::filter(_Tile.data(), _Blk, _Cols, _Blk, _Z, _Acc.data());
+			}
+			for (size_t p = 0; p < _Cnt; ++p) {
+				const auto _Line = _Dst + (_R0 + p) * _Cols;
+				for (size_t x = 0; x < _Cols; ++x)
+					_Line[x] = _Tile[x * _Blk + p];
+			}
+		}
+
+		// \pass along y: strips of '_Strip' contiguous columns.
+#pragma omp for schedule(static)
+		for (index_t _S = 0; _S < _Nstrips; ++_S) {
+			const auto _C0 = _S * _Strip;
+			const auto _Cnt = (MATRICE_STD(min))(_Strip, _Cols - _C0);
+			for (const auto _Z : _Poles) {
+				_Lines::filter(_Dst + _C0, _Cols, _Rows, _Cnt, _Z, _Acc.data());
+			}
+		}
+	}
+}
+
+_DETAIL_END
+MATRICE_ALGS_END
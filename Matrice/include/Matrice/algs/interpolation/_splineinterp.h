@@ -53,6 +53,8 @@ public:
 	}
 
 	MATRICE_HOST_INL matrix_type _Coeff_impl() const;
+	// \reference row/column recursion, kept for validation and benchmark
+	MATRICE_HOST_INL matrix_type _Coeff_ref() const;
 	MATRICE_HOST_INL auto _Val_dx_n(const value_type& _) const {
 		return Matrix_<value_type, Ldv, 1>{1, _, _*_, _*_*_};
 	}
@@ -98,6 +100,8 @@ public:
 	_Spline_interpolation(_Myt&& _Other) noexcept : _Mybase(move(_Other)) {}
 
 	MATRICE_HOST_INL matrix_type _Coeff_impl() const;
+	// \reference row/column recursion, kept for validation and benchmark
+	MATRICE_HOST_INL matrix_type _Coeff_ref() const;
 	MATRICE_HOST_INL auto _Val_dx_n(const value_type& _) const {
 		return Matrix_<value_type, Ldv, 1>{1, _, _*_, _*_*_, _*_*_*_, _*_*_*_*_};
 	}
@@ -144,6 +148,8 @@ public:
 	_Spline_interpolation(_Myt&& _Other) noexcept : _Mybase(move(_Other)) {}
 
 	MATRICE_HOST_INL matrix_type _Coeff_impl() const;
+	// \reference row/column recursion, kept for validation and benchmark
+	MATRICE_HOST_INL matrix_type _Coeff_ref() const;
 	MATRICE_HOST_INL auto _Val_dx_n(const value_type& _) const {
 		return Matrix_<value_type, Ldv, 1>{1, _, _*_, _*_*_, _*_*_*_, _*_*_*_*_, _*_*_*_*_*_, _*_*_*_*_*_*_};
 	}
@@ -19,6 +19,7 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 
 #include <core.hpp>
 #include "_camera_pose.hpp"
+#include "_rectify_map.hpp"
 
 MATRICE_ALG_BEGIN(vision)
 /// <summary>
@@ -87,6 +88,7 @@ public:
 	template<size_t N> using vector = auto_vector_t<value_type, N>;
 	template<size_t N> using point = vector<N>;
 	using pose_type = camera_pose<value_type>;
+	using rectify_map_type = vision::rectify_map<value_type>;
 
 	_Camera() = default;
 	/**
@@ -133,6 +135,33 @@ public:
 		const auto _X = _R.mul(X) + _Mypose.t();
 		return _X.eval<point<3>>();
 	}
+
+	/**
+	 * \brief Attach a point undistortion map, which is looked up by
+	   _Remove_distortion(...). Pass nullptr to detach.
+	 * \return Reference of the specified camera object.
+	 */
+	MATRICE_HOST_INL _Derived& set_rectify_map(shared_ptr<const rectify_map_type> _Map) noexcept {
+		_Mymap = _Map;
+		return *static_cast<_Derived*>(this);
+	}
+	MATRICE_HOST_INL decltype(auto) rectify_map() const noexcept {
+		return (_Mymap);
+	}
+	/**
+	 * \brief Build the point undistortion map for images of 'rows' x 'cols'
+	   from the intrinsics and the backward distortion model 'd', and attach it.
+	 * \param 'compact' set to true to add the fixed-point map for remapping.
+	 * \return Reference of the specified camera object.
+	 */
+	template<typename _Uy>
+	MATRICE_HOST_INL _Derived& make_rectify_map(const distortion<_Uy, bwd>& d, size_t rows, size_t cols, bool compact = false) {
+		const Vec4_<value_type> K(_Mypars(0), _Mypars(1), _Mypars(2), _Mypars(3));
+		auto _Map = MATRICE_STD(make_shared)<rectify_map_type>(
+			rectify_map_type::undistort_points(K, d, rows, cols));
+		if (compact) _Map->compact();
+		return this->set_rectify_map(_Map);
+	}
 protected:
 	static constexpr auto _Size = _Mytraits::_Size;
 
@@ -142,6 +171,8 @@ protected:
 	// Camera pose with $r_x, r_y, r_z, t_x, t_y, t_z$
 	pose_type _Mypose;
 
+	// Point undistortion map, shared by copies of the camera
+	shared_ptr<const rectify_map_type> _Mymap;
 };
 
 /// <summary>
@@ -172,6 +203,20 @@ public:
 	}
 };
 
+/// <summary>
+/// \brief Remove the distortion of an observed pixel (u, v) with the map
+/// attached to the camera 'cam', the pixel is returned as is if none is.
+/// </summary>
+template<class _Cam, typename _Ty>
+MATRICE_HOST_INL auto _Remove_distortion(const _Cam& cam, _Ty u, _Ty v) noexcept {
+	using value_type = typename traits<_Cam>::value_type;
+	if (const auto& _Map = cam.rectify_map(); _Map) {
+		const auto [x, y] = (*_Map)(value_type(u), value_type(v));
+		return MATRICE_STD(make_tuple)(_Ty(x), _Ty(y));
+	}
+	return MATRICE_STD(make_tuple)(u, v);
+}
+
 _DETAIL_END
 
 /// <summary>
@@ -16,10 +16,14 @@ You should have received a copy of the GNU General Public License
 along with this program.If not, see <http://www.gnu.org/licenses/>.
 ***********************************************************************/
 #pragma once
+#include <queue>
+#include <vector>
 #include "algs/correlation/_optim.h"
 #include "algs/interpolation/_cubic_conv_interp.hpp"
 #include "_projection.hpp"
 #include "_spatial_transform.hpp"
+#include "private/math/_small_linear_kernel.hpp"
+#include "thread/_task_pool.h"
 
 MATRICE_ALGS_BEGIN
 _DETAIL_BEGIN
@@ -58,6 +62,16 @@ public:
 		return (m_projection);
 	}
 
+	/**
+	 *\brief getter to the reference and matching images.
+	 */
+	MATRICE_HOST_INL decltype(auto)reference() const noexcept {
+		return (m_reference);
+	}
+	MATRICE_HOST_INL decltype(auto)matching() const noexcept {
+		return (m_matching);
+	}
+
 	/// <summary>
 	/// Set to output verbose information or not.
 	/// </summary>
@@ -96,23 +110,47 @@ public:
 	static constexpr auto order = 1;
 	// Define the size of the subsets
 	static constexpr auto size = 41;
+	// Number of unknowns, the depth and the shape parameters
+	static constexpr auto npar = (order << 2) + 1;
 	using typename _Mybase::value_t;
 	using typename _Mybase::point_t;
 	using typename _Mybase::image_t;
+
+	/**
+	 *\brief Working buffers of the solver. Threads calling the method
+	         ::compute(ws, x, y, depth) concurrently must own one each.
+	 */
+	struct workspace_type {
+		workspace_type()
+			:ref(size, size), cur(size, size), jacob(sq<size_t>(size)) {
+		}
+		// ref for the reference subset in the left image f 
+		// cur is the moving subset in the right image g
+		Matrix_<value_t, ::dynamic> ref, cur;
+		/**
+		 *\brief data arrangement:
+		 //tex: $[\frac{\partial\varepsilon}{\partial d}, f_x\times dx, f_x\times dy, f_y\times dx, f_y\times dy]$
+		 */
+		Matrix_<value_t, ::dynamic, npar> jacob;
+	};
+
+	/**
+	 *\brief Solution of a point.
+	 */
+	struct solution_type {
+		value_t depth = zero<value_t>;
+		// \Norm of the last update
+		value_t error = zero<value_t>;
+		// \ZNCC between the reference and the warped subsets
+		value_t zncc = -one<value_t>;
+		size_t niters = 0;
+	};
 	
 	_GCC_estimator(const point_t& r, const point_t& t)
-		:_Mybase{ r, t }, 
-		m_jacob(sq<size_t>(size)), 
-		m_resid(sq<size_t>(size)), 
-		_Myle(size, size), 
-		_Myri(size, size){
+		:_Mybase{ r, t } {
 	}
 	_GCC_estimator(const initlist<value_t> rt)
-		:_Mybase{ rt }, 
-		m_jacob(sq<size_t>(size)), 
-		m_resid(sq<size_t>(size)), 
-		_Myle(size, size), 
-		_Myri(size, size){
+		:_Mybase{ rt } {
 	}
 
 	/**
@@ -127,66 +165,93 @@ public:
 		return (*this);
 	}
 
+	/**
+	 *\brief getter/setter to the max. number of iterations [50 by default]
+	 */
+	MATRICE_HOST_FINL decltype(auto)maxiters()const noexcept {
+		return (m_maxits);
+	}
+	MATRICE_HOST_FINL decltype(auto)maxiters() noexcept {
+		return (m_maxits);
+	}
+
+	/**
+	 *\brief getter/setter to the tolerance of the update norm [1.E-6 by default]
+	 */
+	MATRICE_HOST_FINL decltype(auto)tol()const noexcept {
+		return (m_tol);
+	}
+	MATRICE_HOST_FINL decltype(auto)tol() noexcept {
+		return (m_tol);
+	}
+
 	/**
 	 *\brief Compute the depth for a given image point
 	 *\param [x, y]: the coords of the image point in the left part of the stereo pair
 	 */
 	auto compute(value_t x, value_t y, value_t init_depth) {
+		return compute(m_workspace, x, y, init_depth).depth;
+	}
+
+	/**
+	 *\brief Compute the depth for a given image point with the buffers 
+	         in 'ws'. The iteration stops once the norm of the update is 
+	         not greater than ::tol().
+	 *\param [ws]: workspace owned by the calling thread;
+	 *\param [x, y]: the coords of the image point in the left part of the stereo pair
+	 *\returns solution with the depth, iteration count and ZNCC.
+	 */
+	solution_type compute(workspace_type& ws, value_t x, value_t y, value_t init_depth) const {
 #ifdef MATRICE_DEBUG
 	    DGELOM_CHECK(!_Mybase::m_reference.empty, 
 	    "_GCC_estimator<_Ty, _Altag> requires a valid stereo pair\n\
         be set with the method ::set_stereo_pair(l,r)\n\
         before computing the depth with ::compute(x, y, depth).");
 #endif
+		using _Kernel = dgelom::detail::_Small_linear_kernel<value_t, npar>;
+		const auto& _Proj = _Mybase::m_projection;
 
-		auto depth{ init_depth };
+		solution_type _Ret;
+		_Ret.depth = init_depth;
+		_Ret.error = MATRICE_STD(numeric_limits)<value_t>::max();
 		_Mystfer T{ _Mypart::zeros() };
-		
+
 		//construct ref. subset surrounds (x, y)
-		_Myle = _Mybase::m_reference.block(diff_t(x), diff_t(y), size/2);
-
-		//compute the matching subset first time
-		auto xp = _Mybase::m_projection.first(x, y, depth);
-		_Myri = _Warp(T, xp.x, xp.y);
-		array_n<value_t, ::dynamic> _Errmap(m_jacob.rows());
-		_Errmap = _Myle - _Myri;
-
-		//eval Jacobian and Hessian matrices
-		m_jacob = _Diff<_Mytask::INIT_JACOB>(x, y, depth);
-		auto hess = m_jacob.t().mul(m_jacob).eval();
-		auto ihess = hess.spd().inv();
-
-		//solve and update
-		auto b = m_jacob.t().mul(_Errmap).eval();
-		auto dp = ihess.mul(b).eval();
-		dp = -1 * dp;
-		auto residual = dp.norm<2>();
-		depth += dp(0);
-		T.update(dp.data() + 1);
-
-		for (size_t k = 1; k < 50; ++k) {
-			if (residual > 1.E-6) {
-				xp = _Mybase::m_projection.update(depth);
-#ifdef MATRICE_DEBUG
-				print(xp);
-#endif
-				_Myri = _Warp(T, xp.x, xp.y);
-				_Errmap = _Myle - _Myri;
-
-				m_jacob = _Diff<_Mytask::UPDATE_JACOB>(x, y, depth);
-				hess = m_jacob.t().mul(m_jacob);
-				ihess = hess.spd().inv();
-				
-				b = m_jacob.t().mul(_Errmap);
-				dp = ihess.mul(b);
-				dp = -1 * dp;
-				depth += dp(0);
-				T.update(dp.data() + 1);
-				residual = dp.norm<2>();
+		ws.ref = _Mybase::m_reference.block(diff_t(x), diff_t(y), size/2);
+
+		value_t _Hess[npar * npar], dp[npar];
+		for (; _Ret.niters < m_maxits && _Ret.error > m_tol; ++_Ret.niters) {
+			//warp the matching subset with current depth and shape
+			const auto xp = _Proj.reproj(_Proj.backproj(x, y, _Ret.depth));
+			_Warp(ws, T, xp.x, xp.y);
+
+			//eval Jacobian, only its depth column varies after the first run
+			if (_Ret.niters == 0)
+				_Diff<_Mytask::INIT_JACOB>(ws, x, y, _Ret.depth);
+			else
+				_Diff<_Mytask::UPDATE_JACOB>(ws, x, y, _Ret.depth);
+
+			//solve and update
+			_Normal_eqs(ws, _Hess, dp);
+			if (_Kernel::spd(_Hess) != 1) break;
+			_Kernel::spd_bwd(_Hess, dp);
+
+			value_t _Norm = 0;
+			for (auto i = 0; i < npar; ++i) {
+				dp[i] = -dp[i];
+				_Norm += sq(dp[i]);
 			}
+			_Ret.depth += dp[0];
+			T.update(dp + 1);
+			_Ret.error = MATRICE_STD(sqrt)(_Norm);
 		}
 
-		return (depth);
+		//eval the reliability with the final warp
+		const auto xp = _Proj.reproj(_Proj.backproj(x, y, _Ret.depth));
+		_Warp(ws, T, xp.x, xp.y);
+		_Ret.zncc = _Zncc(ws);
+
+		return (_Ret);
 	}
 
 private:
@@ -197,7 +262,7 @@ private:
 	 *\param depth: the updated depth of (cx, cy).
 	 */
 	template<_Mytask _Task = _Mytask::INIT_JACOB>
-	decltype(auto) _Diff(value_t cx, value_t cy, value_t depth) noexcept {
+	decltype(auto) _Diff(workspace_type& ws, value_t cx, value_t cy, value_t depth) const noexcept {
 		const auto dxdp = _Mybase::m_projection.grad(cx, cy, depth);
 
 		constexpr auto radius = size >> 1;
@@ -206,7 +271,7 @@ private:
 			for (diff_t dx = -radius; dx <= radius; ++dx) {
 				const auto x = cx + dx;
 				const auto lidx = (dy + radius)*size + (dx + radius);
-				auto J = m_jacob[lidx];
+				auto J = ws.jacob[lidx];
 				if constexpr (_Task == _Mytask::UPDATE_JACOB) {
 					const auto [dgdx, dgdy] = _Diff_g(x, y, depth);
 					J[0] = -(dgdx * dxdp.x + dgdy * dxdp.y);
@@ -224,8 +289,53 @@ private:
 				}
 			}
 		}
-		return (m_jacob);
+		return (ws.jacob);
 	}
+
+	/**
+	 *\brief Accumulate the normal equations from the Jacobian and the 
+	         residual of the subsets in 'ws':
+	 //tex: $\mathbf{H}=\mathbf{J}^T\mathbf{J}, \mathbf{b}=\mathbf{J}^T(f-g)$
+	 *\note Only the upper triangle of 'H' is filled.
+	 */
+	static MATRICE_HOST_INL void _Normal_eqs(const workspace_type& ws, value_t* H, value_t* b) noexcept {
+		for (auto i = 0; i < npar * npar; ++i) H[i] = zero<value_t>;
+		for (auto i = 0; i < npar; ++i) b[i] = zero<value_t>;
+
+		const auto _Ref = ws.ref.data(), _Cur = ws.cur.data();
+		for (size_t n = 0; n < sq<size_t>(size); ++n) {
+			const auto J = ws.jacob[n];
+			const auto e = _Ref[n] - _Cur[n];
+			for (auto i = 0; i < npar; ++i) {
+				b[i] += J[i] * e;
+				for (auto j = i; j < npar; ++j) {
+					H[i * npar + j] += J[i] * J[j];
+				}
+			}
+		}
+	}
+
+	/**
+	 *\brief ZNCC coefficient between the subsets in 'ws'.
+	 */
+	static MATRICE_HOST_INL value_t _Zncc(const workspace_type& ws) noexcept {
+		constexpr auto _N = sq<size_t>(size);
+		const auto _Ref = ws.ref.data(), _Cur = ws.cur.data();
+
+		value_t _Mf = 0, _Mg = 0;
+		for (size_t n = 0; n < _N; ++n) {
+			_Mf += _Ref[n], _Mg += _Cur[n];
+		}
+		_Mf /= _N, _Mg /= _N;
+
+		value_t _Sfg = 0, _Sff = 0, _Sgg = 0;
+		for (size_t n = 0; n < _N; ++n) {
+			const auto f = _Ref[n] - _Mf, g = _Cur[n] - _Mg;
+			_Sfg += f * g, _Sff += f * f, _Sgg += g * g;
+		}
+		return safe_div(_Sfg, MATRICE_STD(sqrt)(_Sff * _Sgg));
+	}
+
 	/**
 	 *\brief Compute derivative of the residual w.r.t. the depth, e.g. 
 	 //tex:$\dfrac{\partial\varepsilon}{\partial d}$
@@ -251,31 +361,26 @@ private:
 	 *\brief Warp the subset:
 	 //tex:$\Omega(\mathbf{x}'(d))$
 	 */
-	decltype(auto)_Warp(const _Mystfer& t, value_t xp, value_t yp)noexcept {
-		const diff_t _Radius = _Myle.rows() >> 1;
+	decltype(auto)_Warp(workspace_type& ws, const _Mystfer& t, value_t xp, value_t yp)const noexcept {
+		const diff_t _Radius = ws.ref.rows() >> 1;
 		for (auto j = -_Radius; j <= _Radius; ++j) {
-			auto ptr = _Myri[j + _Radius];
+			auto ptr = ws.cur[j + _Radius];
 			for (auto i = -_Radius; i <= _Radius; ++i) {
 				const auto [dx, dy] = t(i, j);
 				ptr[i + _Radius] = _Mybase::m_materp(xp+dx, yp+dy);
 			}
 		}
 
-		return (_Myri);
+		return (ws.cur);
 	}
 
 private:
-	// _Myle for the reference subset in the left image f 
-	// _Myri is the moving subset in the right image g
-	Matrix_<value_t, ::dynamic> _Myle, _Myri;
-	/**
-	 *\brief data arrangement:
-	 //tex: $[\frac{\partial\varepsilon}{\partial d}, f_x\times dx, f_x\times dy, f_y\times dx, f_y\times dy]$
-	 */
-	Matrix_<value_t, ::dynamic, (order<<2) + 1> m_jacob;
-	Matrix_<value_t, ::dynamic, 1> m_resid;
+	// Buffers for the single point method ::compute(x, y, depth)
+	workspace_type m_workspace;
 	point_t m_refpt, m_reppt;
 	value_t m_depth = zero<value_t>;
+	value_t m_tol = value_t(1.E-6);
+	size_t m_maxits = 50;
 };
 template<typename _Ty, class _Altag>
 struct _Estimator_traits<_GCC_estimator<_Ty, _Altag>> {
@@ -284,7 +389,294 @@ struct _Estimator_traits<_GCC_estimator<_Ty, _Altag>> {
 	using projection_type = _Aligned_projection<value_type, alignment_tag>;
 };
 
+/// <summary>
+/// \brief CLASS TEMPLATE, dense depth estimation over a regular grid of the
+/// reference image. Only a few seeds start from the given initial depth, 
+/// the other nodes are solved in the descending order of their ZNCC, each
+/// initialized with the depth of its best solved neighbor. The estimator is
+/// copied, and the copy is shared by all workers, each of which owns a 
+/// reused workspace.
+/// </summary>
+/// <typeparam name="_Est">Depth estimator, e.g. _GCC_estimator</typeparam>
+template<typename _Est>
+class _Dense_depth_estimator {
+	using _Myt = _Dense_depth_estimator;
+public:
+	using estimator_type = _Est;
+	using value_type = typename estimator_type::value_t;
+	using workspace_type = typename estimator_type::workspace_type;
+	using solution_type = typename estimator_type::solution_type;
+	using point_type = Vec2_<value_type>;
+	using matrix_type = Matrix<value_type>;
+	// \brief Grid index with {row, col}.
+	using index_type = tuple<size_t, size_t>;
+
+	// \brief Solved state of a node.
+	struct node_type : solution_type {
+		bool solved = false;
+	};
+
+	/**
+	 *\brief CTOR
+	 *\param _Est depth estimator with a stereo pair set, which is copied.
+	 */
+	_Dense_depth_estimator(const estimator_type& _Est)
+		: _Myest(_Est) {
+	}
+
+	/**
+	 *\brief Get the copy of the depth estimator used by the propagation.
+	 */
+	MATRICE_HOST_INL decltype(auto) estimator() const noexcept {
+		return (_Myest);
+	}
+	MATRICE_HOST_INL decltype(auto) estimator() noexcept {
+		return (_Myest);
+	}
+
+	/**
+	 *\brief Define a regular grid of nodes.
+	 *\param [_X0, _Y0] position of the top-left node;
+	 *\param [_Stride] node spacing in pixels;
+	 *\param [_Rows, _Cols] number of nodes along y and x.
+	 */
+	_Myt& set_grid(size_t _X0, size_t _Y0, size_t _Stride, size_t _Rows, size_t _Cols) {
+		_Myx0 = _X0, _Myy0 = _Y0, _Mystride = _Stride;
+		_Myrows = _Rows, _Mycols = _Cols;
+		_Mynodes.assign(_Rows * _Cols, node_type{});
+		return (*this);
+	}
+	/**
+	 *\brief Define a grid with spacing '_Stride' over the whole reference
+	         image, where a margin of the subset radius is reserved.
+	 */
+	_Myt& set_grid(size_t _Stride) {
+		const auto& _Ref = _Myest.reference();
+		const auto _Margin = size_t(estimator_type::size >> 1) + 1;
+		const auto _H = size_t(_Ref.rows()), _W = size_t(_Ref.cols());
+		DGELOM_CHECK(_Stride > 0 && _H > _Margin << 1 && _W > _Margin << 1,
+			"The reference image is too small for the dense depth estimation.");
+		return set_grid(_Margin, _Margin, _Stride,
+			(_H - (_Margin << 1) - 1) / _Stride + 1,
+			(_W - (_Margin << 1) - 1) / _Stride + 1);
+	}
+
+	/**
+	 *\brief Solved nodes with ZNCC below '_Thresh' are kept, but not 
+	         propagated to their neighbors [0.8 by default].
+	 */
+	_Myt& set_threshold(value_type _Thresh) noexcept {
+		_Mythresh = _Thresh;
+		return (*this);
+	}
+
+	/**
+	 *\brief Position of the node at {_Row, _Col}.
+	 */
+	MATRICE_HOST_INL point_type position(size_t _Row, size_t _Col) const noexcept {
+		return point_type(value_type(_Myx0 + _Col * _Mystride), 
+			value_type(_Myy0 + _Row * _Mystride));
+	}
+
+	/**
+	 *\brief Run the propagation on the calling thread.
+	 *\param [_Init] initial depth of the seeds; 
+	 *\param [_Seeds] grid indices of the seeds, the center node is used if empty.
+	 */
+	_Myt& forward(value_type _Init, const MATRICE_STD(vector)<index_type>& _Seeds = {}) {
+		_Check(_Seeds);
+		_Reset(1);
+		_Propagate(_Myws[0], _Init, _Seeds.empty() ? _Center() : _Seeds, {}, 0, _Myrows);
+		return (*this);
+	}
+
+	/**
+	 *\brief Multi-threaded propagation. The grid is partitioned into 
+	         horizontal bands of node rows, which are propagated by the
+	         workers in rounds. A band starts from the seeds in it, and in
+	         later rounds from the depths of the reliable nodes of its 
+	         neighbor bands next to its unsolved border nodes, so a seed is
+	         propagated over the whole grid as in the serial forward(...).
+	         The center node is the only seed if none is given, so seeds 
+	         spread over the bands are needed to run all workers from the
+	         first round.
+	 *\param [_Pool] task pool; [_Init] initial depth of the seeds;
+	 *\param [_Seeds] grid indices of the seeds.
+	 */
+	_Myt& forward(task_pool& _Pool, value_type _Init, const MATRICE_STD(vector)<index_type>& _Seeds = {}) {
+		const auto _Nbands = (MATRICE_STD(min))(_Pool.size(), _Myrows);
+		if (_Nbands < 2) return forward(_Init, _Seeds);
+		_Check(_Seeds);
+		_Reset(_Pool.size());
+
+		const auto _Band_rows = (_Myrows + _Nbands - 1) / _Nbands;
+		MATRICE_STD(vector)<MATRICE_STD(vector)<index_type>> _Band_seeds(_Nbands);
+		MATRICE_STD(vector)<MATRICE_STD(vector)<_Guess>> _Band_guesses(_Nbands);
+		for (const auto& _Seed : _Seeds.empty() ? _Center() : _Seeds) {
+			_Band_seeds[get<0>(_Seed) / _Band_rows].push_back(_Seed);
+		}
+
+		for (bool _Active = true; _Active; ) {
+			_Pool.parallel_for(_Nbands, 1, [&](size_t _Band, size_t _Ithr) {
+				const auto _Lower = _Band * _Band_rows;
+				const auto _Upper = (MATRICE_STD(min))(_Lower + _Band_rows, _Myrows);
+				if (_Band_seeds[_Band].empty() && _Band_guesses[_Band].empty()) return;
+				_Propagate(_Myws[_Ithr], _Init, _Band_seeds[_Band], _Band_guesses[_Band], _Lower, _Upper);
+			});
+
+			// \hand-offs across the band borders for the next round
+			_Active = false;
+			for (size_t _Band = 0; _Band < _Nbands; ++_Band) {
+				const auto _Lower = _Band * _Band_rows;
+				const auto _Upper = (MATRICE_STD(min))(_Lower + _Band_rows, _Myrows);
+				_Band_seeds[_Band].clear(), _Band_guesses[_Band].clear();
+				if (_Lower >= _Upper) continue;
+				if (_Lower > 0)
+					_Handoff(_Lower, _Lower - 1, _Band_guesses[_Band]);
+				if (_Upper < _Myrows)
+					_Handoff(_Upper - 1, _Upper, _Band_guesses[_Band]);
+				_Active |= !_Band_guesses[_Band].empty();
+			}
+		}
+		return (*this);
+	}
+
+	/**
+	 *\brief Get the solved state of the node at {_Row, _Col}.
+	 */
+	MATRICE_HOST_INL decltype(auto) node(size_t _Row, size_t _Col) const noexcept {
+		return (_Mynodes[_Row * _Mycols + _Col]);
+	}
+
+	/**
+	 *\brief Get the depth map over the grid, unsolved nodes are zeros.
+	 */
+	MATRICE_HOST_INL matrix_type depths() const {
+		matrix_type _Ret(_Myrows, _Mycols);
+		for (size_t _Idx = 0; _Idx < _Mynodes.size(); ++_Idx) {
+			_Ret(_Idx) = _Mynodes[_Idx].solved ? _Mynodes[_Idx].depth : zero<value_type>;
+		}
+		return _Ret;
+	}
+
+	/**
+	 *\brief Get ZNCC coefficients of all nodes over the grid.
+	 */
+	MATRICE_HOST_INL matrix_type coeffs() const {
+		matrix_type _Ret(_Myrows, _Mycols);
+		for (size_t _Idx = 0; _Idx < _Mynodes.size(); ++_Idx) {
+			_Ret(_Idx) = _Mynodes[_Idx].zncc;
+		}
+		return _Ret;
+	}
+
+	/**
+	 *\brief Mean number of iterations over the solved nodes.
+	 */
+	MATRICE_HOST_INL value_type mean_iters() const noexcept {
+		size_t _Sum = 0, _Cnt = 0;
+		for (const auto& _Node : _Mynodes) {
+			if (_Node.solved) _Sum += _Node.niters, ++_Cnt;
+		}
+		return _Cnt ? value_type(_Sum) / _Cnt : value_type(0);
+	}
+
+private:
+	// \brief Queue item with {zncc, linear node index}.
+	using _Qitem = MATRICE_STD(pair)<value_type, size_t>;
+	// \brief Initial depth of a node with {linear node index, depth}.
+	using _Guess = MATRICE_STD(pair)<size_t, value_type>;
+
+	MATRICE_HOST_INL MATRICE_STD(vector)<index_type> _Center() const {
+		return { index_type{ _Myrows >> 1, _Mycols >> 1 } };
+	}
+	void _Check(const MATRICE_STD(vector)<index_type>& _Seeds) const {
+		for (const auto& [_Row, _Col] : _Seeds) {
+			DGELOM_CHECK(_Row < _Myrows && _Col < _Mycols,
+				"The seed {" + MATRICE_STD(to_string)(_Row) + ", " +
+				MATRICE_STD(to_string)(_Col) + "} is out of the grid.");
+		}
+	}
+	MATRICE_HOST_INL bool _Reliable(const node_type& _Node) const noexcept {
+		return _Node.solved && _Node.zncc >= _Mythresh;
+	}
+
+	/**
+	 *\brief Collect guesses for the unsolved nodes on the node row '_Row'
+	          from the reliable nodes on the adjacent row '_From'.
+	 */
+	void _Handoff(size_t _Row, size_t _From, MATRICE_STD(vector)<_Guess>& _Guesses) const {
+		for (size_t _Col = 0; _Col < _Mycols; ++_Col) {
+			const auto& _Src = _Mynodes[_From * _Mycols + _Col];
+			if (_Mynodes[_Row * _Mycols + _Col].solved || !_Reliable(_Src)) continue;
+			_Guesses.emplace_back(_Row * _Mycols + _Col, _Src.depth);
+		}
+	}
+
+	void _Reset(size_t _Nthr) {
+		for (auto& _Node : _Mynodes) _Node = node_type{};
+		// \Workspaces are kept over calls, only the missing ones are created.
+		if (_Myws.size() < _Nthr) _Myws.resize(_Nthr);
+	}
+
+	void _Solve(workspace_type& _Ws, size_t _Idx, value_type _Depth) {
+		const auto _Pos = position(_Idx / _Mycols, _Idx % _Mycols);
+		auto& _Node = _Mynodes[_Idx];
+		static_cast<solution_type&>(_Node) = _Myest.compute(_Ws, _Pos.x, _Pos.y, _Depth);
+		_Node.solved = true;
+	}
+
+	/**
+	 *\brief Propagation restricted to node rows [_Lower, _Upper), from the
+	          seeds with the initial depth, and the nodes of given guesses.
+	 */
+	void _Propagate(workspace_type& _Ws, value_type _Init, const MATRICE_STD(vector)<index_type>& _Seeds,
+		const MATRICE_STD(vector)<_Guess>& _Guesses, size_t _Lower, size_t _Upper) {
+		MATRICE_STD(priority_queue)<_Qitem> _Queue;
+		for (const auto& [_Row, _Col] : _Seeds) {
+			if (_Row < _Lower || _Row >= _Upper || _Col >= _Mycols) continue;
+			const auto _Idx = _Row * _Mycols + _Col;
+			if (_Mynodes[_Idx].solved) continue;
+			_Solve(_Ws, _Idx, _Init);
+			_Queue.emplace(_Mynodes[_Idx].zncc, _Idx);
+		}
+		for (const auto& [_Idx, _Depth] : _Guesses) {
+			if (_Mynodes[_Idx].solved) continue;
+			_Solve(_Ws, _Idx, _Depth);
+			_Queue.emplace(_Mynodes[_Idx].zncc, _Idx);
+		}
+
+		constexpr diff_t _Offs[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+		while (!_Queue.empty()) {
+			const auto [_Zncc, _Idx] = _Queue.top();
+			_Queue.pop();
+			if (_Zncc < _Mythresh) continue;
+
+			const auto _Row = diff_t(_Idx / _Mycols), _Col = diff_t(_Idx % _Mycols);
+			for (const auto& _Off : _Offs) {
+				const auto _Nr = _Row + _Off[1], _Nc = _Col + _Off[0];
+				if (_Nr < diff_t(_Lower) || _Nr >= diff_t(_Upper) ||
+					_Nc < 0 || _Nc >= diff_t(_Mycols)) continue;
+				const auto _Nidx = size_t(_Nr) * _Mycols + size_t(_Nc);
+				if (_Mynodes[_Nidx].solved) continue;
+
+				_Solve(_Ws, _Nidx, _Mynodes[_Idx].depth);
+				_Queue.emplace(_Mynodes[_Nidx].zncc, _Nidx);
+			}
+		}
+	}
+
+	estimator_type _Myest;
+	size_t _Myx0 = 0, _Myy0 = 0, _Mystride = 1;
+	size_t _Myrows = 0, _Mycols = 0;
+	value_type _Mythresh = value_type(0.8);
+	MATRICE_STD(vector)<node_type> _Mynodes;
+	MATRICE_STD(vector)<workspace_type> _Myws;
+};
+
 _DETAIL_END
 template<typename _Ty>
 using left_aligned_gcc_t = detail::_GCC_estimator<_Ty, cs_alignment_tag::left>;
+template<typename _Ty>
+using left_aligned_dense_gcc_t = detail::_Dense_depth_estimator<left_aligned_gcc_t<_Ty>>;
 MATRICE_ALGS_END
@@ -68,7 +68,29 @@ class distortion<_Ty, bwd> : public distortion<_Ty, void> {
 	using _Mydt = Vec4_<_Ty>;
 public:
 	using value_t = _Mydt::value_type;
+	using _Mybase::_Mybase;
 
+	/// <summary>
+	/// \brief Remove distortion from distorted image coordinates (x_d, y_d),
+	/// the forward model is inverted with fixed-point iterations. Use a
+	/// 'rectify_map' to look up many points of a camera instead.
+	/// </summary>
+	/// <returns> Ideal coordinates in the normalized image domain.</returns> 
+	MATRICE_GLOBAL_FINL auto apply(value_t x_d, value_t y_d) const noexcept {
+		constexpr auto _Epsi = MATRICE_STD(numeric_limits)<value_t>::epsilon();
+		auto x = x_d, y = y_d;
+		for (size_t _It = 0; _It < _Maxits; ++_It) {
+			const auto [_Xd, _Yd] = _Mybase::apply(x, y);
+			const auto ex = x_d - _Xd, ey = y_d - _Yd;
+			x += ex, y += ey;
+			if (sqsum(ex, ey) < sq(_Epsi)) break;
+		}
+		MATRICE_USE_STD(make_tuple);
+		return make_tuple(x, y);
+	}
+
+private:
+	static constexpr size_t _Maxits = 20;
 };
 
 template<typename _Ty>
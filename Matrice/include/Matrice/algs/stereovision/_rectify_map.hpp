@@ -0,0 +1,366 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2022, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+#include <cmath>
+#include <vector>
+#include <array>
+#include "core.hpp"
+#include "_distortion.hpp"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+// \brief Number of fractional bits of the compact (fixed-point) maps.
+#ifndef MATRICE_RECTIFY_FRAC_BITS
+#define MATRICE_RECTIFY_FRAC_BITS 5
+#endif
+
+MATRICE_NAMESPACE_BEGIN(vision)
+
+/// <summary>
+/// \brief CLASS TEMPLATE, dense look-up table for image rectification.
+/// The map stores for each pixel (u, v) of the destination domain the
+/// position (x, y) in the source domain, so that a remapped image is given
+/// by dst(u, v) = src(x, y) and a point (u, v) is mapped to (x, y). Both are
+/// evaluated with bilinear look-ups, hence undistortion costs the same as a
+/// table look-up once the map is built.
+/// The map is held in single precision, and 'compact()' adds the compact
+/// fixed-point format for remapping images, where integer positions are
+/// stored as int16 and fractions with MATRICE_RECTIFY_FRAC_BITS bits.
+/// </summary>
+/// <typeparam name="_Ty">Type of the parameters and the point coordinates</typeparam>
+template<typename _Ty = float>
+	requires is_floating_point_v<_Ty>
+class rectify_map {
+	using _Myt = rectify_map;
+public:
+	using value_type = _Ty;
+	using map_type = float;
+	static constexpr auto frac_bits = MATRICE_RECTIFY_FRAC_BITS;
+	static constexpr auto frac_size = 1 << frac_bits;
+
+	rectify_map() noexcept = default;
+	rectify_map(size_t rows, size_t cols) noexcept
+		:_Myrows(rows), _Mycols(cols) {
+	}
+
+	/**
+	 *\brief Build the map in parallel with '_Fn(u, v) -> (x, y)', which maps
+	         a pixel of the destination to its source position.
+	 */
+	template<typename _Fn>
+	MATRICE_HOST_INL _Myt& build(_Fn&& _Func) {
+		const auto _Size = _Myrows * _Mycols;
+		_Mymapx.resize(_Size), _Mymapy.resize(_Size);
+		_Myidx.clear(), _Myfrac.clear();
+		const auto _Rows = index_t(_Myrows);
+#pragma omp parallel for schedule(static)
+		for (index_t v = 0; v < _Rows; ++v) {
+			const auto _Off = size_t(v) * _Mycols;
+			for (size_t u = 0; u < _Mycols; ++u) {
+				const auto [x, y] = _Func(value_type(u), value_type(v));
+				_Mymapx[_Off + u] = map_type(x);
+				_Mymapy[_Off + u] = map_type(y);
+			}
+		}
+		return (*this);
+	}
+
+	/**
+	 *\brief Convert the map into the compact fixed-point format, which is
+	         used by remap(...). The single precision map is kept for point
+	         look-ups unless '_Keep_float' is false, then points are looked
+	         up in the fixed-point map with a precision of 1/frac_size px.
+	 */
+	MATRICE_HOST_INL _Myt& compact(bool _Keep_float = true) {
+		if (is_compact()) return (*this);
+		const auto _Size = _Mymapx.size();
+		_Myidx.resize(_Size << 1), _Myfrac.resize(_Size);
+		const auto _Lower = map_type(MATRICE_STD(numeric_limits)<int16_t>::min());
+		const auto _Upper = map_type(MATRICE_STD(numeric_limits)<int16_t>::max() - 1);
+#pragma omp parallel for schedule(static)
+		for (index_t i = 0; i < index_t(_Size); ++i) {
+			const auto x = (MATRICE_STD(min))((MATRICE_STD(max))(_Mymapx[i], _Lower), _Upper);
+			const auto y = (MATRICE_STD(min))((MATRICE_STD(max))(_Mymapy[i], _Lower), _Upper);
+			const auto ix = int(MATRICE_STD(lround)(x * frac_size));
+			const auto iy = int(MATRICE_STD(lround)(y * frac_size));
+			_Myidx[i << 1] = int16_t(ix >> frac_bits);
+			_Myidx[i << 1 | 1] = int16_t(iy >> frac_bits);
+			_Myfrac[i] = uint16_t((iy & (frac_size - 1)) << frac_bits | (ix & (frac_size - 1)));
+		}
+		if (!_Keep_float) _Mymapx = {}, _Mymapy = {};
+		return (*this);
+	}
+
+	MATRICE_HOST_INL bool is_compact() const noexcept {
+		return !_Myfrac.empty();
+	}
+	MATRICE_HOST_INL bool empty() const noexcept {
+		return _Mymapx.empty() && _Myfrac.empty();
+	}
+	MATRICE_HOST_INL size_t rows() const noexcept {
+		return (_Myrows);
+	}
+	MATRICE_HOST_INL size_t cols() const noexcept {
+		return (_Mycols);
+	}
+
+	/**
+	 *\brief Look up the source position of a single point (u, v).
+	 */
+	MATRICE_HOST_INL auto operator()(value_type u, value_type v) const noexcept {
+		value_type x, y;
+		this->apply(&u, &v, &x, &y, 1);
+		return MATRICE_STD(make_tuple)(x, y);
+	}
+
+	/**
+	 *\brief Map 'n' points (us[i], vs[i]) to (xs[i], ys[i]) with bilinear
+	         look-ups of the map, the outputs may alias the inputs. Points
+	         out of the map are clamped to its border. The 2x2 nodes of a
+	         block of points are gathered into SoA buffers, and blended
+	         with SIMD packets.
+	 */
+	MATRICE_HOST_INL void apply(const value_type* us, const value_type* vs,
+		value_type* xs, value_type* ys, size_t n) const noexcept {
+		if (_Mymapx.empty()) {
+			for (size_t i = 0; i < n; ++i) {
+				const auto [x, y] = _Lookup_fixed(us[i], vs[i]);
+				xs[i] = value_type(x), ys[i] = value_type(y);
+			}
+			return;
+		}
+		constexpr size_t _W = 64;
+		alignas(64) map_type _X00[_W], _X01[_W], _X10[_W], _X11[_W];
+		alignas(64) map_type _Y00[_W], _Y01[_W], _Y10[_W], _Y11[_W], _Wx[_W], _Wy[_W];
+		const size_t _Dx = _Mycols > 1 ? 1 : 0, _Dy = _Myrows > 1 ? _Mycols : 0;
+		for (size_t _Beg = 0; _Beg < n; _Beg += _W) {
+			const auto _Cnt = (MATRICE_STD(min))(_W, n - _Beg);
+			for (size_t l = 0; l < _Cnt; ++l) {
+				const auto [_Off, wx, wy] = _Locate(us[_Beg + l], vs[_Beg + l]);
+				const auto _Px = _Mymapx.data() + _Off, _Py = _Mymapy.data() + _Off;
+				_X00[l] = _Px[0], _X01[l] = _Px[_Dx], _X10[l] = _Px[_Dy], _X11[l] = _Px[_Dy + _Dx];
+				_Y00[l] = _Py[0], _Y01[l] = _Py[_Dx], _Y10[l] = _Py[_Dy], _Y11[l] = _Py[_Dy + _Dx];
+				_Wx[l] = wx, _Wy[l] = wy;
+			}
+			_Blend(_X00, _X01, _X10, _X11, _Wx, _Wy, _Cnt);
+			_Blend(_Y00, _Y01, _Y10, _Y11, _Wx, _Wy, _Cnt);
+			for (size_t l = 0; l < _Cnt; ++l) {
+				xs[_Beg + l] = value_type(_X00[l]), ys[_Beg + l] = value_type(_Y00[l]);
+			}
+		}
+	}
+
+	/**
+	 *\brief Remap an image with 'dst(u, v) = src(map(u, v))' using bilinear
+	         interpolation, where pixels mapped outside 'src' are set to '_Border'.
+	 *\param [_Src] a matrix type with methods 'rows()', 'cols()' and 'data()'.
+	 */
+	template<typename _Mty>
+	MATRICE_HOST_INL _Mty remap(const _Mty& _Src, typename _Mty::value_type _Border = 0) const {
+		_Mty _Dst(_Myrows, _Mycols);
+		this->remap(_Src.data(), _Src.rows(), _Src.cols(), _Dst.data(), _Border);
+		return _Dst;
+	}
+	template<typename _Pty>
+	MATRICE_HOST_INL void remap(const _Pty* _Src, size_t _Rows, size_t _Cols, _Pty* _Dst, _Pty _Border = 0) const {
+		const auto _Nrows = index_t(_Myrows);
+#pragma omp parallel for schedule(static)
+		for (index_t v = 0; v < _Nrows; ++v) {
+			const auto _Off = size_t(v) * _Mycols;
+			if (is_compact())
+				_Remap_row_fixed(_Src, _Rows, _Cols, _Off, _Dst + _Off, _Border);
+			else
+				_Remap_row(_Src, _Rows, _Cols, _Off, _Dst + _Off, _Border);
+		}
+	}
+
+	/**
+	 *\brief Build the map to undistort images of a camera with intrinsics
+	         'K' = {fx, fy, cx, cy}, which maps an ideal pixel to its
+	         distorted position with the forward model 'd'.
+	 */
+	template<typename _Dty>
+	static MATRICE_HOST_INL _Myt undistort_image(const Vec4_<value_type>& K, const _Dty& d, size_t rows, size_t cols) {
+		const auto fx = K(0), fy = K(1), cx = K(2), cy = K(3);
+		return _Myt(rows, cols).build([&](value_type u, value_type v) {
+			const auto [x, y] = d.apply((u - cx) / fx, (v - cy) / fy);
+			return MATRICE_STD(make_tuple)(x * fx + cx, y * fy + cy);
+			});
+	}
+
+	/**
+	 *\brief Build the map to undistort points observed by a camera with
+	         intrinsics 'K' = {fx, fy, cx, cy}, which maps a distorted pixel
+	         to its ideal position with the backward model 'd', so that the
+	         iterative inversion of 'd' runs once per pixel at building time.
+	 */
+	template<typename _Uy>
+	static MATRICE_HOST_INL _Myt undistort_points(const Vec4_<value_type>& K, const distortion<_Uy, bwd>& d, size_t rows, size_t cols) {
+		const auto fx = K(0), fy = K(1), cx = K(2), cy = K(3);
+		return _Myt(rows, cols).build([&](value_type u, value_type v) {
+			const auto [x, y] = d.apply(_Uy((u - cx) / fx), _Uy((v - cy) / fy));
+			return MATRICE_STD(make_tuple)(value_type(x) * fx + cx, value_type(y) * fy + cy);
+			});
+	}
+
+private:
+	/**
+	 *\brief Locate (u, v) in the map, returns the offset of the top-left
+	         node and the bilinear weights, clamped to the map border.
+	 */
+	MATRICE_HOST_FINL auto _Locate(value_type u, value_type v) const noexcept {
+		const auto _Xmax = map_type(_Mycols - 1), _Ymax = map_type(_Myrows - 1);
+		const auto x = (MATRICE_STD(min))((MATRICE_STD(max))(map_type(u), map_type(0)), _Xmax);
+		const auto y = (MATRICE_STD(min))((MATRICE_STD(max))(map_type(v), map_type(0)), _Ymax);
+		const auto x0 = (MATRICE_STD(min))(size_t(x), _Mycols > 1 ? _Mycols - 2 : 0);
+		const auto y0 = (MATRICE_STD(min))(size_t(y), _Myrows > 1 ? _Myrows - 2 : 0);
+		return MATRICE_STD(make_tuple)(y0 * _Mycols + x0, x - map_type(x0), y - map_type(y0));
+	}
+	/**
+	 *\brief Blend '_Cnt' SoA quadruples of nodes with the bilinear weights
+	         '_Wx' and '_Wy', the results are written to '_V00'.
+	 */
+	static MATRICE_HOST_FINL void _Blend(map_type* _V00, const map_type* _V01, const map_type* _V10,
+		const map_type* _V11, const map_type* _Wx, const map_type* _Wy, size_t _Cnt) noexcept {
+		size_t l = 0;
+#ifdef MATRICE_SIMD_ARCH
+		using packet_type = simd::Packet_<map_type>;
+		for (; l + packet_type::size <= _Cnt; l += packet_type::size) {
+			const packet_type v00(_V00 + l), v01(_V01 + l), v10(_V10 + l), v11(_V11 + l);
+			const packet_type wx(_Wx + l), wy(_Wy + l);
+			const packet_type _Top = v00 + wx * (v01 - v00);
+			const packet_type _Bot = v10 + wx * (v11 - v10);
+			(_Top + wy * (_Bot - _Top)).unpack(_V00 + l);
+		}
+#endif
+		for (; l < _Cnt; ++l) {
+			const auto _Top = _V00[l] + _Wx[l] * (_V01[l] - _V00[l]);
+			const auto _Bot = _V10[l] + _Wx[l] * (_V11[l] - _V10[l]);
+			_V00[l] = _Top + _Wy[l] * (_Bot - _Top);
+		}
+	}
+	MATRICE_HOST_FINL auto _Fixed_at(size_t i) const noexcept {
+		constexpr auto _Scale = map_type(1) / frac_size;
+		const auto _Frac = _Myfrac[i];
+		return MATRICE_STD(make_tuple)(
+			map_type(_Myidx[i << 1]) + map_type(_Frac & (frac_size - 1)) * _Scale,
+			map_type(_Myidx[i << 1 | 1]) + map_type(_Frac >> frac_bits) * _Scale);
+	}
+	MATRICE_HOST_FINL auto _Lookup_fixed(value_type u, value_type v) const noexcept {
+		const auto [_Off, wx, wy] = _Locate(u, v);
+		const size_t _Dx = _Mycols > 1 ? 1 : 0, _Dy = _Myrows > 1 ? _Mycols : 0;
+		const auto [x00, y00] = _Fixed_at(_Off);
+		const auto [x01, y01] = _Fixed_at(_Off + _Dx);
+		const auto [x10, y10] = _Fixed_at(_Off + _Dy);
+		const auto [x11, y11] = _Fixed_at(_Off + _Dy + _Dx);
+		const auto _Tx = x00 + wx * (x01 - x00), _Bx = x10 + wx * (x11 - x10);
+		const auto _Ry = y00 + wx * (y01 - y00), _By = y10 + wx * (y11 - y10);
+		return MATRICE_STD(make_tuple)(_Tx + wy * (_Bx - _Tx), _Ry + wy * (_By - _Ry));
+	}
+
+	template<typename _Pty>
+	static MATRICE_HOST_FINL _Pty _Cast(map_type _Val) noexcept {
+		if constexpr (is_floating_point_v<_Pty>) {
+			return _Pty(_Val);
+		}
+		else {
+			constexpr auto _Lo = map_type(MATRICE_STD(numeric_limits)<_Pty>::lowest());
+			constexpr auto _Hi = map_type(MATRICE_STD(numeric_limits)<_Pty>::max());
+			return _Pty(MATRICE_STD(lround)((MATRICE_STD(min))((MATRICE_STD(max))(_Val, _Lo), _Hi)));
+		}
+	}
+
+	/**
+	 *\brief Gather the 2x2 neighbours of the source positions of a row
+	         segment into SoA buffers, and blend them with _Blend(...).
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_INL void _Remap_row(const _Pty* _Src, size_t _Rows, size_t _Cols, size_t _Off, _Pty* _Dst, _Pty _Border) const noexcept {
+		constexpr size_t _W = 64;
+		alignas(64) map_type _V00[_W], _V01[_W], _V10[_W], _V11[_W], _Wx[_W], _Wy[_W];
+		bool _Inside[_W];
+		const auto _Xmax = map_type(_Cols - 1), _Ymax = map_type(_Rows - 1);
+		for (size_t _Beg = 0; _Beg < _Mycols; _Beg += _W) {
+			const auto _Cnt = (MATRICE_STD(min))(_W, _Mycols - _Beg);
+			for (size_t l = 0; l < _Cnt; ++l) {
+				const auto x = _Mymapx[_Off + _Beg + l], y = _Mymapy[_Off + _Beg + l];
+				_Inside[l] = x >= 0 && y >= 0 && x <= _Xmax && y <= _Ymax;
+				if (!_Inside[l]) {
+					_V00[l] = _V01[l] = _V10[l] = _V11[l] = _Wx[l] = _Wy[l] = 0;
+					continue;
+				}
+				const auto x0 = size_t(x), y0 = size_t(y);
+				const auto x1 = (MATRICE_STD(min))(x0 + 1, _Cols - 1);
+				const auto y1 = (MATRICE_STD(min))(y0 + 1, _Rows - 1);
+				_V00[l] = map_type(_Src[y0 * _Cols + x0]), _V01[l] = map_type(_Src[y0 * _Cols + x1]);
+				_V10[l] = map_type(_Src[y1 * _Cols + x0]), _V11[l] = map_type(_Src[y1 * _Cols + x1]);
+				_Wx[l] = x - map_type(x0), _Wy[l] = y - map_type(y0);
+			}
+			_Blend(_V00, _V01, _V10, _V11, _Wx, _Wy, _Cnt);
+			for (size_t l = 0; l < _Cnt; ++l) {
+				_Dst[_Beg + l] = _Inside[l] ? _Cast<_Pty>(_V00[l]) : _Border;
+			}
+		}
+	}
+
+	/**
+	 *\brief Remap a row segment with the compact map, where the bilinear
+	         weights are read from a table indexed by the fractions.
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_INL void _Remap_row_fixed(const _Pty* _Src, size_t _Rows, size_t _Cols, size_t _Off, _Pty* _Dst, _Pty _Border) const noexcept {
+		const auto& _Wtab = _Weight_table();
+		for (size_t u = 0; u < _Mycols; ++u) {
+			const auto i = _Off + u;
+			const auto x0 = _Myidx[i << 1], y0 = _Myidx[i << 1 | 1];
+			if (x0 < 0 || y0 < 0 || size_t(x0) >= _Cols || size_t(y0) >= _Rows) {
+				_Dst[u] = _Border;
+				continue;
+			}
+			const auto x1 = (MATRICE_STD(min))(size_t(x0) + 1, _Cols - 1);
+			const auto y1 = (MATRICE_STD(min))(size_t(y0) + 1, _Rows - 1);
+			const auto& w = _Wtab[_Myfrac[i]];
+			_Dst[u] = _Cast<_Pty>(
+				w[0] * map_type(_Src[y0 * _Cols + x0]) + w[1] * map_type(_Src[y0 * _Cols + x1]) +
+				w[2] * map_type(_Src[y1 * _Cols + x0]) + w[3] * map_type(_Src[y1 * _Cols + x1]));
+		}
+	}
+	static MATRICE_HOST_INL const auto& _Weight_table() noexcept {
+		static const auto _Table = [] {
+			MATRICE_STD(vector)<MATRICE_STD(array)<map_type, 4>> _Ret(frac_size * frac_size);
+			for (int fy = 0; fy < frac_size; ++fy) {
+				for (int fx = 0; fx < frac_size; ++fx) {
+					const auto wx = map_type(fx) / frac_size, wy = map_type(fy) / frac_size;
+					_Ret[fy << frac_bits | fx] = { (1 - wx) * (1 - wy), wx * (1 - wy), (1 - wx) * wy, wx * wy };
+				}
+			}
+			return _Ret;
+		}();
+		return (_Table);
+	}
+
+	size_t _Myrows = 0, _Mycols = 0;
+	// single precision map
+	MATRICE_STD(vector)<map_type> _Mymapx, _Mymapy;
+	// compact map: interleaved integer positions and packed fractions
+	MATRICE_STD(vector)<int16_t> _Myidx;
+	MATRICE_STD(vector)<uint16_t> _Myfrac;
+};
+
+MATRICE_NAMESPACE_END(vision)
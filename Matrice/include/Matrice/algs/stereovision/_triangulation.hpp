@@ -19,6 +19,15 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include "core.hpp"
 #include "solver.hpp"
 #include "../geometry/transform.h"
+#include "_rectify_map.hpp"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+// \brief Number of correspondences triangulated by a thread at a time.
+#ifndef MATRICE_TRIG_BATCH_CHUNK
+#define MATRICE_TRIG_BATCH_CHUNK 4096
+#endif
 
 MATRICE_ALGS_BEGIN
 _DETAIL_BEGIN
@@ -32,6 +41,7 @@ public:
 	using vector_type = Vec3_<value_type>;
 	using matrix_2x8t = Matrix_<value_type, 2, 8>;
 	using matrix_3x3t = Matrix_<value_type, 3, 3>;
+	using rectify_map_type = vision::rectify_map<value_type>;
 
 	/**
 	 * \brief Set relative geometry between two cameras.
@@ -96,7 +106,43 @@ public:
 #ifdef MATRICE_DEBUG
 		DGELOM_CHECK(i < m_inpars.rows(), "The index parameter 'i' overs the row range.");
 #endif 
+		if (m_maps[i]) {
+			MATRICE_STD(tie)(u, v) = (*m_maps[i])(u, v);
+			return;
+		}
+		_Undistort(m_inpars[i], u, v);
+	}
+
+	/**
+	 * \brief Attach a point undistortion map to camera 'i', then 
+	   'remove_distortion()' and the batch triangulation look up the map 
+	   instead of evaluating the distortion model. Pass nullptr to detach.
+	 * \return the mutable reference of this object.
+	 */
+	MATRICE_HOST_INL _Myt& set_rectify_map(size_t i, shared_ptr<const rectify_map_type> map) noexcept {
+		m_maps[i] = map;
+		return (*this);
+	}
+	/**
+	 * \brief Build the undistortion map of camera 'i' for images of 
+	   'rows' x 'cols' from its internal parameters, and attach it.
+	 * \param 'compact' set to true to hold the map in fixed-point format.
+	 * \return the mutable reference of this object.
+	 */
+	MATRICE_HOST_INL _Myt& make_rectify_map(size_t i, size_t rows, size_t cols, bool compact = false) {
 		const auto k = m_inpars[i];
+		auto _Map = MATRICE_STD(make_shared)<rectify_map_type>(rows, cols);
+		_Map->build([k](value_type u, value_type v) {
+			_Undistort(k, u, v);
+			return MATRICE_STD(make_tuple)(u, v);
+			});
+		if (compact) _Map->compact();
+		m_maps[i] = _Map;
+		return (*this);
+	}
+
+protected:
+	static MATRICE_HOST_FINL void _Undistort(const value_type* k, value_type& u, value_type& v) noexcept {
 		const auto fx = k[0], fy = k[1], cx = k[2], cy = k[3];
 		const auto k1 = k[4], k2 = k[5], p1 = k[6], p2 = k[7];
 		const auto x = (u - cx) / fx, y = (v - cy) / fy;
@@ -106,10 +152,10 @@ public:
 		v = (ud * y + p1 * r2) * fy + cy;
 	}
 
-protected:
 	matrix_2x8t m_inpars;
 	matrix_3x3t m_rot[2];
 	vector_type m_trs[2];
+	shared_ptr<const rectify_map_type> m_maps[2];
 };
 
 template<typename _Ty>
@@ -120,6 +166,7 @@ class _LSTrig : public _Trig_base<_Ty>
 public:
 	using value_type = typename _Mybase::value_type;
 	using vector_type = typename _Mybase::vector_type;
+	using rectify_map_type = typename _Mybase::rectify_map_type;
 	using correspondence = pair_t<Vec2_<value_type>>;
 	using correspondences = std::vector<correspondence>;
 	_LSTrig() noexcept {
@@ -196,6 +243,188 @@ public:
 	MATRICE_HOST_INL auto compute(const pair_t<Vec2_<value_type>>& cpd) noexcept {
 		return compute(cpd.first, cpd.second);
 	}
+
+	/**
+	 * \brief Triangulate a batch of 'n' correspondences given in the
+	   structure-of-arrays layout. Each point is undistorted in the same pass
+	   as 'compute()' does, and the 3x3 normal equations are solved in closed
+	   form over SIMD packets. The batch is split across threads.
+	 * \param 'px', 'py' the left image points; 'qx', 'qy' the right ones.
+	 * \param 'X', 'Y', 'Z' output 3D coords, in the same frame as 'compute()'.
+	 * \param 'err' optional output, RMS reprojection error of the two views in pixels.
+	 */
+	MATRICE_HOST_INL void compute(size_t n, 
+		const value_type* px, const value_type* py, 
+		const value_type* qx, const value_type* qy,
+		value_type* X, value_type* Y, value_type* Z, value_type* err = nullptr) const noexcept {
+		const _View _Cams[2] = { _View(*this, 0), _View(*this, 1) };
+		const auto _Nchunks = index_t((n + MATRICE_TRIG_BATCH_CHUNK - 1) / MATRICE_TRIG_BATCH_CHUNK);
+#pragma omp parallel for schedule(static) if(_Nchunks > 1)
+		for (index_t _Chunk = 0; _Chunk < _Nchunks; ++_Chunk) {
+			const auto _Beg = size_t(_Chunk) * MATRICE_TRIG_BATCH_CHUNK;
+			const auto _End = (MATRICE_STD(min))(_Beg + MATRICE_TRIG_BATCH_CHUNK, n) - _Beg;
+			auto _Px = px + _Beg, _Py = py + _Beg, _Qx = qx + _Beg, _Qy = qy + _Beg;
+			const auto _X = X + _Beg, _Y = Y + _Beg, _Z = Z + _Beg;
+			const auto _E = err ? err + _Beg : nullptr;
+
+			// \undistort with the attached maps
+			MATRICE_STD(vector)<value_type> _Buf;
+			if (_Cams[0].map || _Cams[1].map) _Buf.resize(_End << 2);
+			if (_Cams[0].map) {
+				_Cams[0].map->apply(_Px, _Py, _Buf.data(), _Buf.data() + _End, _End);
+				_Px = _Buf.data(), _Py = _Buf.data() + _End;
+			}
+			if (_Cams[1].map) {
+				_Cams[1].map->apply(_Qx, _Qy, _Buf.data() + 2 * _End, _Buf.data() + 3 * _End, _End);
+				_Qx = _Buf.data() + 2 * _End, _Qy = _Buf.data() + 3 * _End;
+			}
+
+			size_t i = 0;
+#ifdef MATRICE_SIMD_ARCH
+			using packet_type = simd::Packet_<value_type>;
+			constexpr auto _Step = size_t(packet_type::size);
+			alignas(64) value_type _Err[_Step];
+			for (; i + _Step <= _End; i += _Step) {
+				const auto _Ret = _Eval(_Cams,
+					_Load<packet_type>(_Px + i), _Load<packet_type>(_Py + i),
+					_Load<packet_type>(_Qx + i), _Load<packet_type>(_Qy + i));
+				_Ret[0].unpack(_X + i);
+				_Ret[1].unpack(_Y + i);
+				_Ret[2].unpack(_Z + i);
+				if (_E) {
+					_Ret[3].unpack(_Err);
+					for (size_t l = 0; l < _Step; ++l) {
+						_E[i + l] = MATRICE_STD(sqrt)(_Err[l]);
+					}
+				}
+			}
+#endif
+			for (; i < _End; ++i) {
+				const auto _Ret = _Eval(_Cams, _Px[i], _Py[i], _Qx[i], _Qy[i]);
+				_X[i] = _Ret[0], _Y[i] = _Ret[1], _Z[i] = _Ret[2];
+				if (_E) _E[i] = MATRICE_STD(sqrt)(_Ret[3]);
+			}
+		}
+	}
+
+	/**
+	 * \brief Triangulate a set of correspondences.
+	 * \return 3D points in the same frame as 'compute()'.
+	 */
+	MATRICE_HOST_INL auto compute(const correspondences& cpds) const {
+		const auto n = cpds.size();
+		MATRICE_STD(vector)<value_type> _Buf(n * 7);
+		const auto px = _Buf.data(), py = px + n, qx = py + n, qy = qx + n;
+		for (size_t i = 0; i < n; ++i) {
+			px[i] = cpds[i].first.x, py[i] = cpds[i].first.y;
+			qx[i] = cpds[i].second.x, qy[i] = cpds[i].second.y;
+		}
+		const auto X = qy + n, Y = X + n, Z = Y + n;
+		this->compute(n, px, py, qx, qy, X, Y, Z);
+
+		MATRICE_STD(vector)<vector_type> _Ret(n);
+		for (size_t i = 0; i < n; ++i) {
+			_Ret[i].x = X[i], _Ret[i].y = Y[i], _Ret[i].z = Z[i];
+		}
+		return _Ret;
+	}
+
+private:
+	// \brief Constant geometry of a view for the batch triangulation.
+	// The distortion terms are zeroed if the view has an attached map.
+	struct _View {
+		_View(const _LSTrig& _Trig, size_t i) noexcept 
+			: map(_Trig.m_maps[i].get()) {
+			const auto k = _Trig.m_inpars[i];
+			fx = k[0], fy = k[1], cx = k[2], cy = k[3];
+			k1 = k[4], k2 = k[5], p1 = k[6], p2 = k[7];
+			if (map) k1 = k2 = p1 = p2 = zero<value_type>;
+			ifx = one<value_type> / fx, ify = one<value_type> / fy;
+			const auto& R = _Trig.m_rot[i];
+			for (size_t j = 0; j < 9; ++j) r[j] = R(j);
+			t[0] = _Trig.m_trs[i].x, t[1] = _Trig.m_trs[i].y, t[2] = _Trig.m_trs[i].z;
+		}
+		value_type fx, fy, cx, cy, k1, k2, p1, p2, ifx, ify;
+		value_type r[9], t[3];
+		const rectify_map_type* map;
+	};
+
+	template<typename _Pty>
+	static MATRICE_HOST_FINL _Pty _Load(const value_type* _Src) noexcept {
+		return _Pty(const_cast<value_type*>(_Src));
+	}
+
+	/**
+	 * \brief Undistort a point of a view and build its two rows 'a0', 'a1' 
+	   and rhs 'b0', 'b1' of the linear system. 
+	 * \return {a0, a1, b0, b1, x, y}, where (x, y) is the undistorted point
+	   relative to the principal point.
+	 * \note '_Pty' is either 'value_type' or a SIMD packet, intermediates
+	   are kept const so that packets are never modified in place.
+	 */
+	template<typename _Pty>
+	static MATRICE_HOST_FINL auto _Rows(const _View& c, const _Pty& u, const _Pty& v) noexcept {
+		const _Pty x = (u - c.cx) * c.ifx, y = (v - c.cy) * c.ify;
+		const _Pty r2 = x * x + y * y;
+		const _Pty ud = value_type(1) + (c.k1 + c.k2 * r2) * r2 +
+			value_type(2) * (c.p1 * x + c.p2 * y);
+		const _Pty xu = (ud * x + c.p2 * r2) * c.fx;
+		const _Pty yu = (ud * y + c.p1 * r2) * c.fy;
+		return MATRICE_STD(array)<_Pty, 10>{
+			xu * c.r[6] - c.fx * c.r[0], xu * c.r[7] - c.fx * c.r[1], xu * c.r[8] - c.fx * c.r[2],
+			yu * c.r[6] - c.fy * c.r[3], yu * c.r[7] - c.fy * c.r[4], yu * c.r[8] - c.fy * c.r[5],
+			c.fx * c.t[0] - xu * c.t[2], c.fy * c.t[1] - yu * c.t[2], xu, yu };
+	}
+
+	/**
+	 * \brief Squared reprojection distance of the point 'P' in a view.
+	 */
+	template<typename _Pty>
+	static MATRICE_HOST_FINL _Pty _Reproj_err(const _View& c, const _Pty* P, const MATRICE_STD(array)<_Pty, 10>& _Rw) noexcept {
+		const _Pty x = c.r[0] * P[0] + c.r[1] * P[1] + c.r[2] * P[2] + c.t[0];
+		const _Pty y = c.r[3] * P[0] + c.r[4] * P[1] + c.r[5] * P[2] + c.t[1];
+		const _Pty z = c.r[6] * P[0] + c.r[7] * P[1] + c.r[8] * P[2] + c.t[2];
+		const _Pty ex = c.fx * x / z - _Rw[8], ey = c.fy * y / z - _Rw[9];
+		return ex * ex + ey * ey;
+	}
+
+	/**
+	 * \brief Closed-form least squares triangulation of a correspondence.
+	 * \return {X, Y, Z, e}, where 'e' is the mean squared reprojection
+	   distance of the two views.
+	 */
+	template<typename _Pty>
+	static MATRICE_HOST_FINL auto _Eval(const _View (&_Cams)[2],
+		const _Pty& u0, const _Pty& v0, const _Pty& u1, const _Pty& v1) noexcept {
+		const auto L = _Rows(_Cams[0], u0, v0), R = _Rows(_Cams[1], u1, v1);
+
+		// \normal equations N*P = g, where N = A^T*A and g = A^T*b.
+		const _Pty n00 = L[0] * L[0] + L[3] * L[3] + R[0] * R[0] + R[3] * R[3];
+		const _Pty n01 = L[0] * L[1] + L[3] * L[4] + R[0] * R[1] + R[3] * R[4];
+		const _Pty n02 = L[0] * L[2] + L[3] * L[5] + R[0] * R[2] + R[3] * R[5];
+		const _Pty n11 = L[1] * L[1] + L[4] * L[4] + R[1] * R[1] + R[4] * R[4];
+		const _Pty n12 = L[1] * L[2] + L[4] * L[5] + R[1] * R[2] + R[4] * R[5];
+		const _Pty n22 = L[2] * L[2] + L[5] * L[5] + R[2] * R[2] + R[5] * R[5];
+		const _Pty g0 = L[0] * L[6] + L[3] * L[7] + R[0] * R[6] + R[3] * R[7];
+		const _Pty g1 = L[1] * L[6] + L[4] * L[7] + R[1] * R[6] + R[4] * R[7];
+		const _Pty g2 = L[2] * L[6] + L[5] * L[7] + R[2] * R[6] + R[5] * R[7];
+
+		// \solve with the adjugate of the symmetric N.
+		const _Pty c00 = n11 * n22 - n12 * n12;
+		const _Pty c01 = n02 * n12 - n01 * n22;
+		const _Pty c02 = n01 * n12 - n02 * n11;
+		const _Pty c11 = n00 * n22 - n02 * n02;
+		const _Pty c12 = n01 * n02 - n00 * n12;
+		const _Pty c22 = n00 * n11 - n01 * n01;
+		const _Pty idet = value_type(1) / (n00 * c00 + n01 * c01 + n02 * c02);
+		const _Pty P[3] = {
+			(c00 * g0 + c01 * g1 + c02 * g2) * idet,
+			(c01 * g0 + c11 * g1 + c12 * g2) * idet,
+			(c02 * g0 + c12 * g1 + c22 * g2) * idet };
+
+		const _Pty e = (_Reproj_err(_Cams[0], P, L) + _Reproj_err(_Cams[1], P, R)) * value_type(0.5);
+		return MATRICE_STD(array)<_Pty, 4>{ P[0], value_type(0) - P[1], value_type(0) - P[2], e };
+	}
 };
 _DETAIL_END
 MATRICE_ALGS_END
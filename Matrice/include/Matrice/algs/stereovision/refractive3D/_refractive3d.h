@@ -1,5 +1,5 @@
 /*********************************************************************
-This file is part of Matrice, an effcient and elegant C++ library for 
+This file is part of Matrice, an effcient and elegant C++ library for
 3D Vision and Photo-Mechanics.
 Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
 
@@ -17,7 +17,15 @@ You should have received a copy of the GNU General Public License
 along with this program.If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #pragma once
-#include "../core.hpp"
+#include "core.hpp"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+// \brief Number of points reconstructed by a thread at a time.
+#ifndef MATRICE_REFRACT_BATCH_CHUNK
+#define MATRICE_REFRACT_BATCH_CHUNK 4096
+#endif
 
 MATRICE_ALG_BEGIN(vision)
 inline _DETAIL_BEGIN
@@ -41,22 +49,28 @@ struct air2water_tag {
 };
 
 // Traits
-template<typename _Ty> 
+template<typename _Ty>
 struct is_refractive_tag : MATRICE_STD(false_type) {};
 template<>
 struct is_refractive_tag<air2glass_tag> : MATRICE_STD(true_type) {};
 template<>
 struct is_refractive_tag<glass2water_tag> : MATRICE_STD(true_type) {};
+template<>
 struct is_refractive_tag<air2water_tag> : MATRICE_STD(true_type) {};
 template<typename _Ty>
 constexpr auto is_refractive_tag_v = is_refractive_tag<_Ty>::value;
 
 /// <summary>
 /// \brief CLASS TEMPLATE, refractive 3d reconstruction.
-/// This module is thread-safe.
+/// The rays of the two cameras are traced through the interfaces
+/// $\Pi_1$ (air to glass) and $\Pi_2$ (glass to water), and the true
+/// object point is the midpoint of the common perpendicular of the two
+/// emergent rays. Points are processed in batches of the structure-of-
+/// arrays layout, which are split across threads and evaluated over SIMD
+/// packets. This module is thread-safe.
 /// </summary>
 /// <typeparam name="_Ty">data type</typeparam>
-template<typename _Ty> 
+template<typename _Ty>
 requires is_floating_point_v<_Ty>
 class _Refractive_reconstruction {
 	using _Myt = _Refractive_reconstruction;
@@ -71,24 +85,29 @@ public:
 	{
 		MATRICE_HOST_FINL interface_type() = default;
 		MATRICE_HOST_FINL
-		interface_type(value_type _Nx, value_type _Ny, value_type _Nz) noexcept
-			: _Mynormal{_Nx, _Ny, _Nz} {
-			const auto _Norm = _Mynormal.norm<2>();
-			_Norm == 1 ? _Mynormal.normalize(_Norm) : ;
+		interface_type(value_type _Nx, value_type _Ny, value_type _Nz,
+			value_type _Dist = 0, value_type _Shift = 0) noexcept
+			: _Mynormal{_Nx, _Ny, _Nz}, _Mydist{_Dist}, _Myshift{_Shift} {
+			// \normalize and orient the normal away from the origin.
+			auto _Norm = MATRICE_STD(sqrt)(sqsum(_Nx, _Ny, _Nz));
+			if (_Mydist < 0) _Norm = -_Norm, _Mydist = -_Mydist;
+			if (_Norm != 1) {
+				_Mynormal.x /= _Norm, _Mynormal.y /= _Norm, _Mynormal.z /= _Norm;
+			}
 		}
 
 		MATRICE_HOST_FINL decltype(auto) normal() const noexcept {
-			return _Mynormal;
+			return (_Mynormal);
 		}
 		MATRICE_HOST_FINL decltype(auto) normal() noexcept {
-			return _Mynormal;
+			return (_Mynormal);
 		}
 
 		MATRICE_HOST_FINL decltype(auto) near_distance() const noexcept {
-			return _Mydist;
+			return (_Mydist);
 		}
 		MATRICE_HOST_FINL decltype(auto) near_distance() noexcept {
-			return _Mydist;
+			return (_Mydist);
 		}
 
 		MATRICE_HOST_FINL decltype(auto) far_distance() const noexcept {
@@ -105,35 +124,11 @@ public:
 		value_type  _Myshift{ 0 };
 	};
 
-	/// <summary>
-	/// \brief Light ray type with origin and direction.
-	/// </summary>
-	struct ray_type
-	{
-		vector_t<3> _Myorigin;
-		vector_t<3> _Mydirection;
-
-		vector_t<3> operator()(value_type s) const noexcept {
-			return _Mydirection * s - _Myorigin;
-		}
-
-		MATRICE_HOST_FINL friend 
-		vector_t<3> intersection(const ray_type& _R1, const ray_type& _R2) noexcept {
-			const auto _Coef = concat(_R1._Mydirection, _R2._Mydirection);
-			const auto _A = _Coef.t().mul(_Coef).eval();
-			auto _B = _Coef.t().mul(_R1._Myorigin - _R2._Myorigin);
-			const auto _S = _A.inv().mul(_B);
-
-			return (_R1(_S(0)) + _R2(_S(1)))/2
-		}
-	};
-
-	using ray_pair_t = tuple<ray_type, ray_type>;
-
 	/**
-	 * \brief CTOR, create an object with a given interface.
+	 * \brief CTOR, create an object with a given interface, where
+	   $\Pi_1: \mathbf{N}^T\mathbf{X} = D$ and $\Pi_2: \mathbf{N}^T\mathbf{X} = D + d$.
 	 */
-	explicit _Refractive_reconstruction(interface_type&& _Interf) noexcept
+	explicit _Refractive_reconstruction(const interface_type& _Interf) noexcept
 		:_Myinterface(_Interf) {
 	}
 
@@ -144,7 +139,7 @@ public:
 		_Myorigin = _O;
 		return (*this);
 	}
-	
+
 	/**
 	 * \brief METHOD, set the translation of the right camera relative to  the frame $O-XYZ$.
 	 */
@@ -158,9 +153,11 @@ public:
 	 * \param '_P' the distorted object point $\mathbf{P}$, estimated by regular triangulation.
 	 * \return 'Q' the true object point.
 	 */
-	auto compute(const vector_t<3>& _P) const noexcept {
-		const auto [left_direc, right_direc] = _Eval_incident_directions(_P);
-
+	MATRICE_HOST_INL vector_t<3> compute(const vector_t<3>& _P) const noexcept {
+		const value_type _Dl[3] = { _P.x - _Myorigin.x, _P.y - _Myorigin.y, _P.z - _Myorigin.z };
+		const value_type _Dr[3] = { _P.x - _Mytrans.x, _P.y - _Mytrans.y, _P.z - _Mytrans.z };
+		const auto _Q = _Eval(_Dl, _Dr);
+		return vector_t<3>(_Q[0], _Q[1], _Q[2]);
 	}
 
 	/**
@@ -168,19 +165,53 @@ public:
 	 * \param '_x <-> _y' stereo correspondence in undistorted image domain.
 	 * \return 'Q' the true object point.
 	 */
-	auto compute(const vector_t<3>& _x, const vector_t<3>& _y) const noexcept {
-		decltype(_x) b_left = _x - _Myorigin;
-		decltype(_y) b_right = _y - _Mytrans;
+	MATRICE_HOST_INL vector_t<3> compute(const vector_t<3>& _x, const vector_t<3>& _y) const noexcept {
+		const value_type _Dl[3] = { _x.x - _Myorigin.x, _x.y - _Myorigin.y, _x.z - _Myorigin.z };
+		const value_type _Dr[3] = { _y.x - _Mytrans.x, _y.y - _Mytrans.y, _y.z - _Mytrans.z };
+		const auto _Q = _Eval(_Dl, _Dr);
+		return vector_t<3>(_Q[0], _Q[1], _Q[2]);
+	}
+
+	/**
+	 * \brief METHOD, compute the true object points of a batch of 'n'
+	   distorted points given in the structure-of-arrays layout.
+	 * \param 'px', 'py', 'pz' coords of the distorted points $\mathbf{P}$.
+	 * \param 'qx', 'qy', 'qz' output coords of the true points $\mathbf{Q}$,
+	   which are NaNs if a ray is totally reflected.
+	 */
+	MATRICE_HOST_INL void compute(size_t n,
+		const value_type* px, const value_type* py, const value_type* pz,
+		value_type* qx, value_type* qy, value_type* qz) const noexcept;
 
+	/**
+	 * \brief METHOD, compute the true object points of a 3-by-n matrix,
+	   each column of which holds a distorted point $\mathbf{P}$.
+	 * \return 3-by-n matrix of the true points.
+	 */
+	MATRICE_HOST_INL Matrix<value_type> compute(const Matrix<value_type>& _P) const {
+		DGELOM_CHECK(_P.rows() == 3, "_P must be a 3-by-n matrix.");
+		const auto n = size_t(_P.cols());
+		Matrix<value_type> _Q(3, n);
+		this->compute(n, _P[0], _P[1], _P[2], _Q[0], _Q[1], _Q[2]);
+		return _Q;
 	}
 
 private:
-	// \brief Compute the directions of the leading incident rays L1 and L2.
-	auto _Eval_incident_directions(const vector_t<3>& _P) const noexcept;
+	/**
+	 * \brief Trace the ray from the center '_C' along '_D' through the
+	   two interfaces.
+	 * \return {X, Y, Z, u, v, w}, the incident point at $\Pi_2$ and
+	   the unit direction of the emergent ray.
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_FINL MATRICE_STD(array)<_Pty, 6> _Trace(const vector_t<3>& _C, const _Pty* _D) const noexcept;
 
-	// \brief Compute the intersection of a ray and an interface.
-	template<typename _Tag, MATRICE_ENABLE_IF(is_refractive_tag_v<_Tag>)>
-	auto _Eval_incident_points(_Tag, ray_pair_t&& ray_pair) const noexcept;
+	/**
+	 * \brief Compute the true object point from the incident directions
+	   '_Dl' and '_Dr' of the left and right rays.
+	 */
+	template<typename _Pty>
+	MATRICE_HOST_FINL MATRICE_STD(array)<_Pty, 3> _Eval(const _Pty* _Dl, const _Pty* _Dr) const noexcept;
 
 	interface_type _Myinterface;
 
@@ -199,7 +230,7 @@ _DETAIL_END
 /// </summary>
 /// <typeparam name="_Ty"></typeparam>
 template<typename _Ty>
-using refractive_reconstruction = detail::_Refractive_reconstruction;
+using refractive_reconstruction = detail::_Refractive_reconstruction<_Ty>;
 
 MATRICE_ALG_END(vision)
 
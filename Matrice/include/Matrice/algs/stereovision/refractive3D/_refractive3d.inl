@@ -22,59 +22,133 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 MATRICE_ALG_BEGIN(vision)
 
 namespace internal {
-template<typename _Ty, typename _Uy, typename _Cat> MATRICE_HOST_FINL 
-auto _Interf_ray_intersection(const _Ty& _Plane, const _Uy& _Ray, _Cat);
+/**
+ * \brief Square root of a scalar or a SIMD packet.
+ */
+template<typename _Pty> MATRICE_HOST_FINL
+_Pty _Sqrt(const _Pty& _X) noexcept {
+	if constexpr (is_scalar_v<_Pty>) {
+		return MATRICE_STD(sqrt)(_X);
+	}
+#ifdef MATRICE_SIMD_ARCH
+	else {
+		return simd::sqrt(_X);
+	}
+#endif
 }
 
-template<typename _Ty> MATRICE_HOST_FINL
-auto detail::_Refractive_reconstruction<_Ty>::
-_Eval_incident_directions(const vector_t<3>& _P) const noexcept 
+/**
+ * \brief Refract the unit direction '_D' at an interface with the unit
+   normal '_N' along the propagation, by the vector form of Snell's law:
+ //tex: $\mathbf{d}'=\eta\mathbf{d}+(\cos\theta_2-\eta\cos\theta_1)\mathbf{N}, \eta=n_1/n_2$
+ * \return Unit direction of the refracted ray, which is NaN if the ray
+   is totally reflected.
+ * \note '_Pty' is either a scalar or a SIMD packet, all intermediates
+   are kept const so that packets are never modified in place.
+ */
+template<typename _Tag, typename _Pty, typename _Ty> MATRICE_HOST_FINL
+MATRICE_STD(array)<_Pty, 3> _Refract(const _Pty* _D, const _Ty* _N) noexcept {
+	static_assert(is_refractive_tag_v<_Tag>, "_Tag must be a refractive tag.");
+	constexpr auto _Eta = _Ty(_Tag::n1) / _Ty(_Tag::n2);
+
+	const _Pty _Cos1 = _D[0] * _N[0] + _D[1] * _N[1] + _D[2] * _N[2];
+	const _Pty _Sin2 = _Eta * _Eta * (_Ty(1) - _Cos1 * _Cos1);
+	const _Pty _Coef = _Sqrt<_Pty>(_Ty(1) - _Sin2) - _Eta * _Cos1;
+	return { _Eta * _D[0] + _Coef * _N[0],
+		_Eta * _D[1] + _Coef * _N[1],
+		_Eta * _D[2] + _Coef * _N[2] };
+}
+}
+
+template<typename _Ty> requires is_floating_point_v<_Ty>
+template<typename _Pty> MATRICE_HOST_FINL
+MATRICE_STD(array)<_Pty, 6> detail::_Refractive_reconstruction<_Ty>::
+_Trace(const vector_t<3>& _C, const _Pty* _D) const noexcept
 {
-	vector_t<3> _Diff_po = _P - _Myorigin;
-	vector_t<3> _Diff_pt = _P - _Mytrans;
+	const auto& _Normal = _Myinterface.normal();
+	const value_type _N[3] = { _Normal.x, _Normal.y, _Normal.z };
 
-	_Diff_po = _Diff_po.normalize(_Diff_po.norm());
-	_Diff_pt = _Diff_pt.normalize(_Diff_pt.norm());
+	// Unit direction of the incident ray L1
+	const _Pty _Inorm = value_type(1) / internal::_Sqrt<_Pty>(_D[0] * _D[0] + _D[1] * _D[1] + _D[2] * _D[2]);
+	const _Pty _D1[3] = { _D[0] * _Inorm, _D[1] * _Inorm, _D[2] * _Inorm };
 
-	return tuple{ _Diff_po, _Diff_pt };
-}
+	// Incident point P1 = C + s1*d1 of L1 at the interface 1
+	const auto _Nc = _N[0] * _C.x + _N[1] * _C.y + _N[2] * _C.z;
+	const _Pty _S1 = (_Myinterface.near_distance() - _Nc) / (_D1[0] * _N[0] + _D1[1] * _N[1] + _D1[2] * _N[2]);
 
-template<typename _Ty> 
-template<typename _Tag, typename> MATRICE_HOST_FINL
-auto detail::_Refractive_reconstruction<_Ty>::
-_Eval_incident_points(_Tag, ray_pair_t&& ray_pair) const noexcept
-{
-	const auto [_Lray, _Rray] = ray_pair;
-	const auto _P1 = internal::_Interf_ray_intersection(_Myinterface, _Lray, air2glass_tag());
-	const auto _P2 = internal::_Interf_ray_intersection(_Myinterface, _Rray, air2glass_tag());
+	// Direction of the ray L2 in glass, and its incident point P2 = P1 + s2*d2 at the interface 2
+	const auto _D2 = internal::_Refract<air2glass_tag>(_D1, _N);
+	const _Pty _S2 = _Myinterface._Myshift / (_D2[0] * _N[0] + _D2[1] * _N[1] + _D2[2] * _N[2]);
 
-	return tuple{_P1, _P2}
+	// Direction of the ray L3 in water
+	const auto _D3 = internal::_Refract<glass2water_tag>(_D2.data(), _N);
+
+	return { _C.x + _S1 * _D1[0] + _S2 * _D2[0],
+		_C.y + _S1 * _D1[1] + _S2 * _D2[1],
+		_C.z + _S1 * _D1[2] + _S2 * _D2[2],
+		_D3[0], _D3[1], _D3[2] };
 }
 
-namespace internal {
-template<typename _Ty, typename _Uy, typename _Cat> MATRICE_HOST_FINL
-auto _Interf_ray_intersection(const _Ty& _Plane, const _Uy& _Ray, _Cat) {
-	auto _Dist = _Ty(0);
-	if constexpr (is_same_v<_Cat, air2glass_tag>)
-		_Dist = _Plane.near_distance();
-	else
-		_Dist = _Plane.far_distance()
-
-	decltype(auto) _Normal = _Plane.normal();
-	decltype(auto) _End = _Ray._Myorigin;
-	decltype(auto) _Direc = _Ray._Mydirection;
-
-	using type = remove_all_t<decltype(_End)>;
-	const type _U = _End.x * _Direc - _Direc.x * _End;
-	const type _V = _End.y * _Direc - _Direc.y * _End;
-	const type _W = _End.z * _Direc - _Direc.z * _End;
-
-	typename type::template extend<3> _M;
-	_M.cview(0) = _U, _M.cview(1) = _V, _M.cview(2) = _W;
-
-	const auto _Exp = (_M.t().mul(_Normal) - _Dist * _Direc)/_Normal.dot(_Direc);
-	return type(_Exp(0), _Exp(1), _Exp(2));
+template<typename _Ty> requires is_floating_point_v<_Ty>
+template<typename _Pty> MATRICE_HOST_FINL
+MATRICE_STD(array)<_Pty, 3> detail::_Refractive_reconstruction<_Ty>::
+_Eval(const _Pty* _Dl, const _Pty* _Dr) const noexcept
+{
+	const auto _L = _Trace(_Myorigin, _Dl);
+	const auto _R = _Trace(_Mytrans, _Dr);
+
+	// Closest points P2 + s*d3 and P2' + t*d3' of the emergent rays L3 and L3'
+	const _Pty _Wx = _L[0] - _R[0], _Wy = _L[1] - _R[1], _Wz = _L[2] - _R[2];
+	const _Pty _B = _L[3] * _R[3] + _L[4] * _R[4] + _L[5] * _R[5];
+	const _Pty _Dw = _L[3] * _Wx + _L[4] * _Wy + _L[5] * _Wz;
+	const _Pty _Ew = _R[3] * _Wx + _R[4] * _Wy + _R[5] * _Wz;
+	const _Pty _Iden = value_type(1) / (value_type(1) - _B * _B);
+	const _Pty _S = (_B * _Ew - _Dw) * _Iden;
+	const _Pty _T = (_Ew - _B * _Dw) * _Iden;
+
+	// The true object point Q is the midpoint of the common perpendicular
+	return { (_L[0] + _S * _L[3] + _R[0] + _T * _R[3]) * value_type(0.5),
+		(_L[1] + _S * _L[4] + _R[1] + _T * _R[4]) * value_type(0.5),
+		(_L[2] + _S * _L[5] + _R[2] + _T * _R[5]) * value_type(0.5) };
 }
+
+template<typename _Ty> requires is_floating_point_v<_Ty>
+MATRICE_HOST_INL void detail::_Refractive_reconstruction<_Ty>::
+compute(size_t n,
+	const value_type* px, const value_type* py, const value_type* pz,
+	value_type* qx, value_type* qy, value_type* qz) const noexcept
+{
+	const auto _Nchunks = index_t((n + MATRICE_REFRACT_BATCH_CHUNK - 1) / MATRICE_REFRACT_BATCH_CHUNK);
+#pragma omp parallel for schedule(static) if(_Nchunks > 1)
+	for (index_t _Chunk = 0; _Chunk < _Nchunks; ++_Chunk) {
+		const auto _Beg = size_t(_Chunk) * MATRICE_REFRACT_BATCH_CHUNK;
+		const auto _End = (MATRICE_STD(min))(_Beg + MATRICE_REFRACT_BATCH_CHUNK, n);
+
+		size_t i = _Beg;
+#ifdef MATRICE_SIMD_ARCH
+		using packet_type = simd::Packet_<value_type>;
+		constexpr auto _Step = size_t(packet_type::size);
+		const packet_type _Ox(_Myorigin.x), _Oy(_Myorigin.y), _Oz(_Myorigin.z);
+		const packet_type _Rx(_Mytrans.x), _Ry(_Mytrans.y), _Rz(_Mytrans.z);
+		for (; i + _Step <= _End; i += _Step) {
+			const packet_type _Px(const_cast<value_type*>(px + i));
+			const packet_type _Py(const_cast<value_type*>(py + i));
+			const packet_type _Pz(const_cast<value_type*>(pz + i));
+			const packet_type _Dl[3] = { _Px - _Ox, _Py - _Oy, _Pz - _Oz };
+			const packet_type _Dr[3] = { _Px - _Rx, _Py - _Ry, _Pz - _Rz };
+			const auto _Q = _Eval(_Dl, _Dr);
+			_Q[0].unpack(qx + i);
+			_Q[1].unpack(qy + i);
+			_Q[2].unpack(qz + i);
+		}
+#endif
+		for (; i < _End; ++i) {
+			const value_type _Dl[3] = { px[i] - _Myorigin.x, py[i] - _Myorigin.y, pz[i] - _Myorigin.z };
+			const value_type _Dr[3] = { px[i] - _Mytrans.x, py[i] - _Mytrans.y, pz[i] - _Mytrans.z };
+			const auto _Q = _Eval(_Dl, _Dr);
+			qx[i] = _Q[0], qy[i] = _Q[1], qz[i] = _Q[2];
+		}
+	}
 }
 
-MATRICE_ALG_END(vision)
\ No newline at end of file
+MATRICE_ALG_END(vision)
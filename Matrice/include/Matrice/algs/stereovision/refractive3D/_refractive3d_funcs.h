@@ -17,7 +17,7 @@ You should have received a copy of the GNU General Public License
 along with this program.If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #pragma once
-#include "../core.hpp"
+#include "core.hpp"
 
 MATRICE_ALG_BEGIN(vision)
 
@@ -88,7 +88,7 @@ vec3d_t<_Ty> _Get_refracted_vector(vec3d_t<_Ty> vec1, vec3d_t<_Ty> N,
 	MATRICE_USE_STD(cos);
 	const auto _Prev = (n1 / n2) * vec1;
 	const auto _Tail = (n1 / n2 * cos(theta1) - cos(theta2)) * N;
-	return { _Prev(0) - _Tail(0), _Prev(1) - _Tail(1), _Prev(1) - _Tail(1) };
+	return { _Prev(0) - _Tail(0), _Prev(1) - _Tail(1), _Prev(2) - _Tail(2) };
 }
 
 /// <summary>
@@ -233,8 +233,8 @@ vec3d_t<_Ty> refractive_3d_reconstruction(
 	const auto angleR3 = angleR2;
 
 	// Refracted angles of rays L2 and L2'
-	auto angleL4 = asin(n1 * sin(angleL3) / n2);
-	auto angleR4 = asin(n1 * sin(angleR3) / n2);
+	auto angleL4 = asin(n2 * sin(angleL3) / n3);
+	auto angleR4 = asin(n2 * sin(angleR3) / n3);
 
 	// Direction vectors of the ray L3 and L3'
 	const auto nlineL3 = detail::_Get_refracted_vector(nlineL2, N2, n2, n3, angleL3, angleL4);
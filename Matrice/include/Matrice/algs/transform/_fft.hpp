@@ -19,15 +19,23 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "core.hpp"
+#include "_fft_engine.hpp"
 
 MATRICE_ALG_BEGIN()
 _DETAIL_BEGIN
+/// <summary>
+/// \brief FFT descriptor of a real 1D signal or a real 2D image in row-major,
+/// which is transformed by the native engine 'fft_engine'. The forward pass
+/// yields the half spectrum with rows x (cols/2+1) bins, and the backward pass
+/// restores the real data from it.
+/// </summary>
 template<typename _Ty>
 class _Fft_descriptor {
 	using _Myt = _Fft_descriptor;
 public:
 	using value_type = _Ty;
 	using pointer = add_pointer_t<value_type>;
+	using engine_type = fft_engine<value_type>;
 
 	struct status_type
 	{
@@ -48,13 +56,17 @@ public:
 	};
 
 	_Fft_descriptor(const pointer _Src, size_t _Size) noexcept 
-		:_Mysrc(_Src), _Mysize(_Size) {
+		:_Mysrc(_Src), _Mysize(_Size), _Mycols(_Size) {
+
+	}
+	_Fft_descriptor(const pointer _Src, size_t _Rows, size_t _Cols) noexcept
+		:_Mysrc(_Src), _Mysize(_Rows*_Cols), _Myrows(_Rows), _Mycols(_Cols) {
 
 	}
 
 	template<typename _Cont>
 	_Fft_descriptor(const _Cont& _Src) noexcept
-		:_Mysrc(_Src.data()), _Mysize(_Src.size()) {
+		:_Mysrc(_Src.data()), _Mysize(_Src.size()), _Mycols(_Src.size()) {
 
 	}
 
@@ -65,6 +77,42 @@ public:
 		return (_Myoptions);
 	}
 
+	/**
+	 *\brief Forward real-to-complex FFT, the spectrum is scaled by 'fwdscale'.
+	 */
+	MATRICE_HOST_INL status_type forward() noexcept {
+		return _Forward();
+	}
+	/**
+	 *\brief Backward complex-to-real FFT, the result is scaled by 'bwdscale' 
+	          and written to the source if 'inplace' is true, or else to output().
+	 */
+	MATRICE_HOST_INL status_type backward() noexcept {
+		return _Backward();
+	}
+
+	/**
+	 *\brief Real and imaginary parts of the half spectrum after forward().
+	 */
+	MATRICE_HOST_INL const pointer real() const noexcept {
+		return _Myreal;
+	}
+	MATRICE_HOST_INL const pointer imag() const noexcept {
+		return _Myimag;
+	}
+	/**
+	 *\brief Number of {rows, cols} of the half spectrum.
+	 */
+	MATRICE_HOST_INL auto bins() const noexcept {
+		return MATRICE_STD(make_tuple)(_Mydims[0], _Mydims[1] / 2 + 1);
+	}
+	/**
+	 *\brief Result of backward(), with the same shape as the source.
+	 */
+	MATRICE_HOST_INL const value_type* output() const noexcept {
+		return _Myoptions.inplace ? _Mysrc : _Myout.data();
+	}
+
 private:
 	status_type _Forward() noexcept;
 	status_type _Backward() noexcept;
@@ -74,14 +122,77 @@ protected:
 
 	size_t  _Mysize;
 	pointer _Mysrc = nullptr;
+	size_t  _Myrows = 1, _Mycols = 0;
+	size_t  _Mydims[2]{ 1, 0 };
 
 	pointer _Myreal = nullptr;
 	pointer _Myimag = nullptr;
 
+	MATRICE_STD(vector)<value_type> _Myspec, _Mywork, _Myout;
 };
+
+template<typename _Ty> MATRICE_HOST_INL
+typename _Fft_descriptor<_Ty>::status_type _Fft_descriptor<_Ty>::_Forward() noexcept {
+	if (!_Mysrc || _Mysize == 0) return status_type{ -1 };
+
+	const auto _Rows = _Myrows > 1 && _Myoptions.padding ? engine_type::good_size(_Myrows) : _Myrows;
+	const auto _Cols = _Myoptions.padding ? engine_type::good_size(_Mycols) : _Mycols;
+	_Mydims[0] = _Rows, _Mydims[1] = _Cols;
+
+	const value_type* _Data = _Mysrc;
+	if (_Rows != _Myrows || _Cols != _Mycols) {
+		_Mywork.assign(_Rows * _Cols, value_type(0));
+		for (size_t r = 0; r < _Myrows; ++r) {
+			MATRICE_STD(copy)(_Mysrc + r * _Mycols, _Mysrc + (r + 1) * _Mycols, _Mywork.data() + r * _Cols);
+		}
+		_Data = _Mywork.data();
+	}
+
+	const auto _Bins = _Rows * (_Cols / 2 + 1);
+	_Myspec.resize(2 * _Bins);
+	_Myreal = _Myspec.data(), _Myimag = _Myspec.data() + _Bins;
+	if (_Rows == 1) {
+		engine_type::r2c(_Data, _Myreal, _Myimag, _Cols);
+	}
+	else {
+		engine_type::r2c_2d(_Data, _Myreal, _Myimag, _Rows, _Cols, _Myoptions.threads);
+	}
+
+	if (_Myoptions.fwdscale != value_type(1)) {
+		for (auto& _Val : _Myspec) _Val *= _Myoptions.fwdscale;
+	}
+	return status_type{ 0 };
+}
+
+template<typename _Ty> MATRICE_HOST_INL
+typename _Fft_descriptor<_Ty>::status_type _Fft_descriptor<_Ty>::_Backward() noexcept {
+	if (!_Myreal) return status_type{ -1 };
+
+	const auto _Rows = _Mydims[0], _Cols = _Mydims[1];
+	const auto _Bins = _Rows * (_Cols / 2 + 1);
+	MATRICE_STD(vector)<value_type> _Data(_Rows * _Cols);
+	if (_Rows == 1) {
+		engine_type::c2r(_Myreal, _Myimag, _Data.data(), _Cols);
+	}
+	else {
+		// \the 2D inverse overwrites its input, so keep the spectrum.
+		_Mywork.assign(_Myspec.begin(), _Myspec.end());
+		engine_type::c2r_2d(_Mywork.data(), _Mywork.data() + _Bins, _Data.data(), _Rows, _Cols, _Myoptions.threads);
+	}
+
+	const auto _Dst = _Myoptions.inplace ? _Mysrc : (_Myout.resize(_Mysize), _Myout.data());
+	const auto _Scale = _Myoptions.bwdscale;
+	for (size_t r = 0; r < _Myrows; ++r) {
+		const auto _Line = _Data.data() + r * _Cols;
+		for (size_t c = 0; c < _Mycols; ++c) {
+			_Dst[r * _Mycols + c] = _Line[c] * _Scale;
+		}
+	}
+	return status_type{ 0 };
+}
 _DETAIL_END
 
 template<typename _Ty>
 using fft_t = detail::_Fft_descriptor<_Ty>;
 
-MATRICE_ALG_END()
\ No newline at end of file
+MATRICE_ALG_END()
@@ -0,0 +1,453 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library for
+3D Vision and Photo-Mechanics.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#pragma once
+
+#include <map>
+#include <cmath>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include "util/_macros.h"
+#include "util/_type_defs.h"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+DGE_MATRICE_BEGIN
+_DETAIL_BEGIN
+
+/// <summary>
+/// \brief Plan of a complex FFT with size '_N', which is factorized into
+/// radix-4, 2, 3 and generic prime stages of a Stockham auto-sort FFT.
+/// Plans are immutable and cached, get them with _Fft_plan::get(_N).
+/// </summary>
+template<typename _Ty> struct _Fft_plan {
+	using value_type = _Ty;
+	struct stage_type {
+		size_t radix = 1, m = 1;
+		// \twiddles w^(p*k) of the stage, p < m and 0 < k < radix
+		MATRICE_STD(vector)<value_type> twr, twi;
+		// \roots of unity exp(-2 pi i j/radix) for generic radix
+		MATRICE_STD(vector)<value_type> rootr, rooti;
+	};
+
+	size_t size = 0;
+	MATRICE_STD(vector)<stage_type> stages;
+	// \twiddles exp(-2 pi i k/(2 size)), k <= size, for the real FFT of length 2*size
+	MATRICE_STD(vector)<value_type> rtwr, rtwi;
+
+	explicit _Fft_plan(size_t _N) : size(_N) {
+		constexpr auto _Pi = 3.14159265358979323846;
+		MATRICE_STD(vector)<size_t> _Radices;
+		auto n = _N;
+		for (; n % 4 == 0; n >>= 2) _Radices.push_back(4);
+		for (; n % 2 == 0; n >>= 1) _Radices.push_back(2);
+		for (size_t p = 3; p * p <= n; p += 2) {
+			for (; n % p == 0; n /= p) _Radices.push_back(p);
+		}
+		if (n > 1) _Radices.push_back(n);
+
+		auto _Len = _N;
+		for (const auto r : _Radices) {
+			stage_type _Stage;
+			_Stage.radix = r, _Stage.m = _Len / r;
+			_Stage.twr.resize(_Stage.m * (r - 1));
+			_Stage.twi.resize(_Stage.m * (r - 1));
+			for (size_t p = 0; p < _Stage.m; ++p) {
+				for (size_t k = 1; k < r; ++k) {
+					const auto _Theta = -2 * _Pi * double(p * k) / double(_Len);
+					_Stage.twr[p * (r - 1) + k - 1] = value_type(MATRICE_STD(cos)(_Theta));
+					_Stage.twi[p * (r - 1) + k - 1] = value_type(MATRICE_STD(sin)(_Theta));
+				}
+			}
+			if (r > 4) {
+				_Stage.rootr.resize(r), _Stage.rooti.resize(r);
+				for (size_t j = 0; j < r; ++j) {
+					const auto _Theta = -2 * _Pi * double(j) / double(r);
+					_Stage.rootr[j] = value_type(MATRICE_STD(cos)(_Theta));
+					_Stage.rooti[j] = value_type(MATRICE_STD(sin)(_Theta));
+				}
+			}
+			stages.push_back(MATRICE_STD(move)(_Stage));
+			_Len = _Len / r;
+		}
+
+		rtwr.resize(_N + 1), rtwi.resize(_N + 1);
+		for (size_t k = 0; k <= _N; ++k) {
+			const auto _Theta = -_Pi * double(k) / double(_N);
+			rtwr[k] = value_type(MATRICE_STD(cos)(_Theta));
+			rtwi[k] = value_type(MATRICE_STD(sin)(_Theta));
+		}
+	}
+
+	/**
+	 *\brief Get the cached plan of size '_N', it is thread-safe.
+	 */
+	static MATRICE_HOST_INL auto get(size_t _N) {
+		static MATRICE_STD(mutex) _Mtx;
+		static MATRICE_STD(map)<size_t, shared_ptr<const _Fft_plan>> _Cache;
+		MATRICE_STD(lock_guard)<MATRICE_STD(mutex)> _Lock(_Mtx);
+		auto& _Plan = _Cache[_N];
+		if (!_Plan) _Plan = MATRICE_STD(make_shared)<const _Fft_plan>(_N);
+		return _Plan;
+	}
+};
+
+/// <summary>
+/// \brief Native FFT engine on split complex data {re, im}. A batch of '_Nb'
+/// lines is transformed at once, where the k-th sample of the b-th line is
+/// stored at k*_Nb + b, hence the butterflies run across lines with SIMD.
+/// Transforms are unnormalized, the inverse of a forward transform of length
+/// N returns the input times N.
+/// </summary>
+template<typename _Ty> class _Fft_engine {
+	using _Myt = _Fft_engine;
+public:
+	using value_type = _Ty;
+	using plan_type = _Fft_plan<value_type>;
+
+	/**
+	 *\brief In-place complex FFT of '_Nb' interleaved lines with length '_N'.
+	 *\param [_Inv] false for the forward transform with exp(-2 pi i k n/N).
+	 */
+	static MATRICE_HOST_INL void c2c(value_type* _Re, value_type* _Im, size_t _N, size_t _Nb = 1, bool _Inv = false) {
+		if (_N < 2) return;
+		const auto _Plan = plan_type::get(_N);
+		auto& _Work = _Buffer(0, 2 * _N * _Nb);
+		_Exec(*_Plan, _Re, _Im, _Work.data(), _Work.data() + _N * _Nb, _Nb, _Inv);
+	}
+
+	/**
+	 *\brief Real-to-complex FFT of length '_N', which outputs _N/2+1 bins.
+	 */
+	static MATRICE_HOST_INL void r2c(const value_type* _X, value_type* _Re, value_type* _Im, size_t _N) {
+		if (_N % 2) {
+			auto& _Tmp = _Buffer(1, 2 * _N);
+			MATRICE_STD(copy)(_X, _X + _N, _Tmp.data());
+			MATRICE_STD(fill)(_Tmp.data() + _N, _Tmp.data() + 2 * _N, value_type(0));
+			c2c(_Tmp.data(), _Tmp.data() + _N, _N);
+			MATRICE_STD(copy)(_Tmp.data(), _Tmp.data() + _N / 2 + 1, _Re);
+			MATRICE_STD(copy)(_Tmp.data() + _N, _Tmp.data() + _N + _N / 2 + 1, _Im);
+			return;
+		}
+
+		// \pack even and odd samples to a complex sequence of length _N/2.
+		const auto _H = _N >> 1;
+		auto& _Z = _Buffer(1, 2 * _H);
+		const auto _Zr = _Z.data(), _Zi = _Z.data() + _H;
+		for (size_t m = 0; m < _H; ++m) {
+			_Zr[m] = _X[m << 1], _Zi[m] = _X[m << 1 | 1];
+		}
+		c2c(_Zr, _Zi, _H);
+
+		const auto _Plan = plan_type::get(_H);
+		const auto& _Wr = _Plan->rtwr, & _Wi = _Plan->rtwi;
+		constexpr auto _Half = value_type(0.5);
+		for (size_t k = 0; k <= _H; ++k) {
+			const auto _Kr = _Zr[k % _H], _Ki = _Zi[k % _H];
+			const auto _Cr = _Zr[(_H - k) % _H], _Ci = -_Zi[(_H - k) % _H];
+			const auto _Er = (_Kr + _Cr) * _Half, _Ei = (_Ki + _Ci) * _Half;
+			const auto _Or = (_Ki - _Ci) * _Half, _Oi = -(_Kr - _Cr) * _Half;
+			_Re[k] = _Er + _Wr[k] * _Or - _Wi[k] * _Oi;
+			_Im[k] = _Ei + _Wr[k] * _Oi + _Wi[k] * _Or;
+		}
+	}
+
+	/**
+	 *\brief Complex-to-real inverse FFT of length '_N' from _N/2+1 bins.
+	 */
+	static MATRICE_HOST_INL void c2r(const value_type* _Re, const value_type* _Im, value_type* _X, size_t _N) {
+		if (_N % 2) {
+			// \rebuild the full Hermitian spectrum.
+			auto& _Tmp = _Buffer(1, 2 * _N);
+			const auto _Tr = _Tmp.data(), _Ti = _Tmp.data() + _N;
+			for (size_t k = 0; k < _N; ++k) {
+				const auto _Conj = k > _N / 2;
+				_Tr[k] = _Re[_Conj ? _N - k : k];
+				_Ti[k] = _Conj ? -_Im[_N - k] : _Im[k];
+			}
+			c2c(_Tr, _Ti, _N, 1, true);
+			MATRICE_STD(copy)(_Tr, _Tr + _N, _X);
+			return;
+		}
+
+		const auto _H = _N >> 1;
+		auto& _Z = _Buffer(1, 2 * _H);
+		const auto _Zr = _Z.data(), _Zi = _Z.data() + _H;
+		const auto _Plan = plan_type::get(_H);
+		const auto& _Wr = _Plan->rtwr, & _Wi = _Plan->rtwi;
+		for (size_t k = 0; k < _H; ++k) {
+			const auto _Kr = _Re[k], _Ki = _Im[k];
+			const auto _Cr = _Re[_H - k], _Ci = -_Im[_H - k];
+			const auto _Er = _Kr + _Cr, _Ei = _Ki + _Ci;
+			// \odd part: (X[k] - conj(X[H-k])) * conj(W^k)
+			const auto _Dr = _Kr - _Cr, _Di = _Ki - _Ci;
+			const auto _Or = _Dr * _Wr[k] + _Di * _Wi[k];
+			const auto _Oi = _Di * _Wr[k] - _Dr * _Wi[k];
+			_Zr[k] = _Er - _Oi, _Zi[k] = _Ei + _Or;
+		}
+		c2c(_Zr, _Zi, _H, 1, true);
+		for (size_t m = 0; m < _H; ++m) {
+			_X[m << 1] = _Zr[m], _X[m << 1 | 1] = _Zi[m];
+		}
+	}
+
+	/**
+	 *\brief 2D complex FFT of a '_Rows' x '_Cols' row-major matrix in place.
+	 */
+	static MATRICE_HOST_INL void c2c_2d(value_type* _Re, value_type* _Im, size_t _Rows, size_t _Cols, bool _Inv = false, size_t _Nthr = 1) {
+		const auto _Nrows = index_t(_Rows);
+#pragma omp parallel for num_threads(int(_Nthr)) if(_Nthr > 1)
+		for (index_t r = 0; r < _Nrows; ++r) {
+			c2c(_Re + r * _Cols, _Im + r * _Cols, _Cols, 1, _Inv);
+		}
+		_Columns(_Re, _Im, _Rows, _Cols, _Inv, _Nthr);
+	}
+
+	/**
+	 *\brief 2D real-to-complex FFT, which outputs a '_Rows' x (_Cols/2+1) half spectrum.
+	 */
+	static MATRICE_HOST_INL void r2c_2d(const value_type* _X, value_type* _Re, value_type* _Im, size_t _Rows, size_t _Cols, size_t _Nthr = 1) {
+		const auto _Nrows = index_t(_Rows);
+		const auto _Bins = _Cols / 2 + 1;
+#pragma omp parallel for num_threads(int(_Nthr)) if(_Nthr > 1)
+		for (index_t r = 0; r < _Nrows; ++r) {
+			r2c(_X + r * _Cols, _Re + r * _Bins, _Im + r * _Bins, _Cols);
+		}
+		_Columns(_Re, _Im, _Rows, _Bins, false, _Nthr);
+	}
+
+	/**
+	 *\brief 2D complex-to-real inverse FFT from a '_Rows' x (_Cols/2+1) half
+	          spectrum, which is overwritten.
+	 */
+	static MATRICE_HOST_INL void c2r_2d(value_type* _Re, value_type* _Im, value_type* _X, size_t _Rows, size_t _Cols, size_t _Nthr = 1) {
+		const auto _Nrows = index_t(_Rows);
+		const auto _Bins = _Cols / 2 + 1;
+		_Columns(_Re, _Im, _Rows, _Bins, true, _Nthr);
+#pragma omp parallel for num_threads(int(_Nthr)) if(_Nthr > 1)
+		for (index_t r = 0; r < _Nrows; ++r) {
+			c2r(_Re + r * _Bins, _Im + r * _Bins, _X + r * _Cols, _Cols);
+		}
+	}
+
+	/**
+	 *\brief Smallest 2^a*3^b*5^c no less than '_N', which is a fast size.
+	 */
+	static MATRICE_HOST_INL size_t good_size(size_t _N) noexcept {
+		for (;; ++_N) {
+			auto n = _N;
+			for (const auto p : { 2, 3, 5 }) for (; n % p == 0; n /= p);
+			if (n == 1) return _N;
+		}
+	}
+
+private:
+#if MATRICE_SIMD_ARCH==MATRICE_SIMD_AVX
+	using packet_type = simd::Packet_<value_type>;
+	static constexpr size_t _Step = packet_type::size;
+#else
+	using packet_type = value_type;
+	static constexpr size_t _Step = 1;
+#endif
+	// \strip width of the column pass
+	static constexpr size_t _Strip = 64;
+
+	/**
+	 *\brief Thread-local work buffers, '_Idx' selects one of them.
+	 */
+	static MATRICE_HOST_INL auto& _Buffer(size_t _Idx, size_t _Size) {
+		static thread_local MATRICE_STD(vector)<value_type> _Bufs[3];
+		if (_Bufs[_Idx].size() < _Size) _Bufs[_Idx].resize(_Size);
+		return (_Bufs[_Idx]);
+	}
+
+	template<typename _V>
+	static MATRICE_HOST_FINL _V _Ld(const value_type* _Ptr) noexcept {
+		if constexpr (MATRICE_STD(is_same_v)<_V, value_type>) return *_Ptr;
+		else return _V(const_cast<value_type*>(_Ptr));
+	}
+	template<typename _V>
+	static MATRICE_HOST_FINL void _St(const _V& _Val, value_type* _Ptr) noexcept {
+		if constexpr (MATRICE_STD(is_same_v)<_V, value_type>) *_Ptr = _Val;
+		else _Val.unpack(_Ptr);
+	}
+
+	/**
+	 *\brief Run '_Op<_V>(t)' for t in [0, _S), with packets as many as possible.
+	 */
+	template<typename _Op>
+	static MATRICE_HOST_FINL void _For_lanes(size_t _S, _Op&& _Func) {
+		size_t t = 0;
+		if constexpr (_Step > 1) {
+			for (; t + _Step <= _S; t += _Step)
+				_Func.template operator()<packet_type>(t);
+		}
+		for (; t < _S; ++t) _Func.template operator()<value_type>(t);
+	}
+
+	/**
+	 *\brief Stockham FFT, the result is written back to {_Xr, _Xi}.
+	 */
+	static MATRICE_HOST_INL void _Exec(const plan_type& _Plan, value_type* _Xr, value_type* _Xi,
+		value_type* _Yr, value_type* _Yi, size_t _Nb, bool _Inv) {
+		const auto _Sg = _Inv ? value_type(-1) : value_type(1);
+		const auto _Xr0 = _Xr, _Xi0 = _Xi;
+		size_t _S = _Nb;
+		for (const auto& _Stage : _Plan.stages) {
+			const auto r = _Stage.radix, m = _Stage.m;
+			for (size_t p = 0; p < m; ++p) {
+				const auto _Twr = _Stage.twr.data() + p * (r - 1);
+				const auto _Twi = _Stage.twi.data() + p * (r - 1);
+				const auto _In = [&](size_t j) { return _S * (p + j * m); };
+				const auto _Out = [&](size_t k) { return _S * (r * p + k); };
+				switch (r) {
+				case 2: {
+					const auto _I0 = _In(0), _I1 = _In(1), _O0 = _Out(0), _O1 = _Out(1);
+					const auto _W1r = _Twr[0], _W1i = _Sg * _Twi[0];
+					_For_lanes(_S, [&]<typename _V>(size_t t) {
+						const auto _A0r = _Ld<_V>(_Xr + _I0 + t), _A0i = _Ld<_V>(_Xi + _I0 + t);
+						const auto _A1r = _Ld<_V>(_Xr + _I1 + t), _A1i = _Ld<_V>(_Xi + _I1 + t);
+						_St<_V>(_A0r + _A1r, _Yr + _O0 + t), _St<_V>(_A0i + _A1i, _Yi + _O0 + t);
+						const _V _Dr = _A0r - _A1r, _Di = _A0i - _A1i;
+						const _V _Wr(_W1r), _Wi(_W1i);
+						_St<_V>(_Dr * _Wr - _Di * _Wi, _Yr + _O1 + t);
+						_St<_V>(_Dr * _Wi + _Di * _Wr, _Yi + _O1 + t);
+					});
+				} break;
+				case 3: {
+					const auto _I0 = _In(0), _I1 = _In(1), _I2 = _In(2);
+					const auto _O0 = _Out(0), _O1 = _Out(1), _O2 = _Out(2);
+					const auto _W1r = _Twr[0], _W1i = _Sg * _Twi[0];
+					const auto _W2r = _Twr[1], _W2i = _Sg * _Twi[1];
+					const auto _S3 = _Sg * value_type(0.86602540378443864676);
+					_For_lanes(_S, [&]<typename _V>(size_t t) {
+						const auto _A0r = _Ld<_V>(_Xr + _I0 + t), _A0i = _Ld<_V>(_Xi + _I0 + t);
+						const auto _A1r = _Ld<_V>(_Xr + _I1 + t), _A1i = _Ld<_V>(_Xi + _I1 + t);
+						const auto _A2r = _Ld<_V>(_Xr + _I2 + t), _A2i = _Ld<_V>(_Xi + _I2 + t);
+						const _V _T1r = _A1r + _A2r, _T1i = _A1i + _A2i;
+						const _V _T2r = _A1r - _A2r, _T2i = _A1i - _A2i;
+						_St<_V>(_A0r + _T1r, _Yr + _O0 + t), _St<_V>(_A0i + _T1i, _Yi + _O0 + t);
+						const _V _Mr = _A0r - _T1r * _V(value_type(0.5)), _Mi = _A0i - _T1i * _V(value_type(0.5));
+						const _V _Rr = _T2i * _V(_S3), _Ri = _T2r * _V(-_S3);
+						const _V _B1r = _Mr + _Rr, _B1i = _Mi + _Ri;
+						const _V _B2r = _Mr - _Rr, _B2i = _Mi - _Ri;
+						_St<_V>(_B1r * _V(_W1r) - _B1i * _V(_W1i), _Yr + _O1 + t);
+						_St<_V>(_B1r * _V(_W1i) + _B1i * _V(_W1r), _Yi + _O1 + t);
+						_St<_V>(_B2r * _V(_W2r) - _B2i * _V(_W2i), _Yr + _O2 + t);
+						_St<_V>(_B2r * _V(_W2i) + _B2i * _V(_W2r), _Yi + _O2 + t);
+					});
+				} break;
+				case 4: {
+					const auto _I0 = _In(0), _I1 = _In(1), _I2 = _In(2), _I3 = _In(3);
+					const auto _O0 = _Out(0), _O1 = _Out(1), _O2 = _Out(2), _O3 = _Out(3);
+					const auto _W1r = _Twr[0], _W1i = _Sg * _Twi[0];
+					const auto _W2r = _Twr[1], _W2i = _Sg * _Twi[1];
+					const auto _W3r = _Twr[2], _W3i = _Sg * _Twi[2];
+					_For_lanes(_S, [&]<typename _V>(size_t t) {
+						const auto _A0r = _Ld<_V>(_Xr + _I0 + t), _A0i = _Ld<_V>(_Xi + _I0 + t);
+						const auto _A1r = _Ld<_V>(_Xr + _I1 + t), _A1i = _Ld<_V>(_Xi + _I1 + t);
+						const auto _A2r = _Ld<_V>(_Xr + _I2 + t), _A2i = _Ld<_V>(_Xi + _I2 + t);
+						const auto _A3r = _Ld<_V>(_Xr + _I3 + t), _A3i = _Ld<_V>(_Xi + _I3 + t);
+						const _V _T0r = _A0r + _A2r, _T0i = _A0i + _A2i;
+						const _V _T1r = _A0r - _A2r, _T1i = _A0i - _A2i;
+						const _V _T2r = _A1r + _A3r, _T2i = _A1i + _A3i;
+						const _V _Dr = _A1r - _A3r, _Di = _A1i - _A3i;
+						// \rotation by -i (forward) or +i (inverse)
+						const _V _Rr = _Di * _V(_Sg), _Ri = _Dr * _V(-_Sg);
+						_St<_V>(_T0r + _T2r, _Yr + _O0 + t), _St<_V>(_T0i + _T2i, _Yi + _O0 + t);
+						const _V _B1r = _T1r + _Rr, _B1i = _T1i + _Ri;
+						const _V _B2r = _T0r - _T2r, _B2i = _T0i - _T2i;
+						const _V _B3r = _T1r - _Rr, _B3i = _T1i - _Ri;
+						_St<_V>(_B1r * _V(_W1r) - _B1i * _V(_W1i), _Yr + _O1 + t);
+						_St<_V>(_B1r * _V(_W1i) + _B1i * _V(_W1r), _Yi + _O1 + t);
+						_St<_V>(_B2r * _V(_W2r) - _B2i * _V(_W2i), _Yr + _O2 + t);
+						_St<_V>(_B2r * _V(_W2i) + _B2i * _V(_W2r), _Yi + _O2 + t);
+						_St<_V>(_B3r * _V(_W3r) - _B3i * _V(_W3i), _Yr + _O3 + t);
+						_St<_V>(_B3r * _V(_W3i) + _B3i * _V(_W3r), _Yi + _O3 + t);
+					});
+				} break;
+				default: {
+					// \generic radix with O(r^2) DFT per butterfly
+					for (size_t t = 0; t < _S; ++t) {
+						for (size_t k = 0; k < r; ++k) {
+							auto _Sr = value_type(0), _Si = value_type(0);
+							for (size_t j = 0; j < r; ++j) {
+								const auto _Jk = (j * k) % r;
+								const auto _Ur = _Stage.rootr[_Jk], _Ui = _Sg * _Stage.rooti[_Jk];
+								const auto _Ar = _Xr[_In(j) + t], _Ai = _Xi[_In(j) + t];
+								_Sr += _Ar * _Ur - _Ai * _Ui;
+								_Si += _Ar * _Ui + _Ai * _Ur;
+							}
+							if (k == 0) {
+								_Yr[_Out(0) + t] = _Sr, _Yi[_Out(0) + t] = _Si;
+							}
+							else {
+								const auto _Wr = _Twr[k - 1], _Wi = _Sg * _Twi[k - 1];
+								_Yr[_Out(k) + t] = _Sr * _Wr - _Si * _Wi;
+								_Yi[_Out(k) + t] = _Sr * _Wi + _Si * _Wr;
+							}
+						}
+					}
+				} break;
+				}
+			}
+			MATRICE_STD(swap)(_Xr, _Yr), MATRICE_STD(swap)(_Xi, _Yi);
+			_S *= r;
+		}
+		if (_Xr != _Xr0) {
+			const auto _Len = _Plan.size * _Nb;
+			MATRICE_STD(copy)(_Xr, _Xr + _Len, _Yr);
+			MATRICE_STD(copy)(_Xi, _Xi + _Len, _Yi);
+		}
+	}
+
+	/**
+	 *\brief FFT along the columns of a '_Rows' x '_Cols' matrix in place.
+	          Strips of columns are gathered into compact buffers, so that
+	          the butterflies run across the columns of a strip.
+	 */
+	static MATRICE_HOST_INL void _Columns(value_type* _Re, value_type* _Im, size_t _Rows, size_t _Cols, bool _Inv, size_t _Nthr) {
+		if (_Rows < 2) return;
+		const auto _Nstrips = index_t((_Cols + _Strip - 1) / _Strip);
+#pragma omp parallel for num_threads(int(_Nthr)) if(_Nthr > 1)
+		for (index_t s = 0; s < _Nstrips; ++s) {
+			const auto _C0 = s * _Strip;
+			const auto _Nb = (MATRICE_STD(min))(_Strip, _Cols - _C0);
+			auto& _Buf = _Buffer(2, 2 * _Rows * _Nb);
+			const auto _Br = _Buf.data(), _Bi = _Buf.data() + _Rows * _Nb;
+			for (size_t r = 0; r < _Rows; ++r) {
+				MATRICE_STD(copy)(_Re + r * _Cols + _C0, _Re + r * _Cols + _C0 + _Nb, _Br + r * _Nb);
+				MATRICE_STD(copy)(_Im + r * _Cols + _C0, _Im + r * _Cols + _C0 + _Nb, _Bi + r * _Nb);
+			}
+			c2c(_Br, _Bi, _Rows, _Nb, _Inv);
+			for (size_t r = 0; r < _Rows; ++r) {
+				MATRICE_STD(copy)(_Br + r * _Nb, _Br + (r + 1) * _Nb, _Re + r * _Cols + _C0);
+				MATRICE_STD(copy)(_Bi + r * _Nb, _Bi + (r + 1) * _Nb, _Im + r * _Cols + _C0);
+			}
+		}
+	}
+};
+
+_DETAIL_END
+template<typename _Ty>
+using fft_engine = detail::_Fft_engine<_Ty>;
+DGE_MATRICE_END
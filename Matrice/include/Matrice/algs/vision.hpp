@@ -19,4 +19,5 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 
 #include "stereovision/_depth_estimation.hpp"
 #include "stereovision/_triangulation.hpp"
-#include "stereovision/_camera.hpp"
\ No newline at end of file
+#include "stereovision/_camera.hpp"
+#include "stereovision/_rectify_map.hpp"
\ No newline at end of file
@@ -62,15 +62,15 @@ template<> struct simd_hop<size_t, 4> : simd_hop_base<size_t, 4>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm256_set1_epi64x(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm256_load_si256((const raw_type*)_First); }
+	{ return _mm256_loadu_si256((const raw_type*)_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m256i_u64; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m256i_u64; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_si256((raw_type*)_Dst, _Packet); }
+	{ _mm256_storeu_si256((raw_type*)_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_si256((raw_type*)_Dst, _Packet); }
+	{ _mm256_storeu_si256((raw_type*)_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{ return (_Reduce_n<>::value(_First)); }
 };
@@ -79,15 +79,15 @@ template<> struct simd_hop<ptrdiff_t, 4> : simd_hop_base<ptrdiff_t, 4>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm256_set1_epi64x(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm256_load_si256((const raw_type*)_First); }
+	{ return _mm256_loadu_si256((const raw_type*)_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m256i_i64; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m256i_i64; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_si256((raw_type*)_Dst, _Packet); }
+	{ _mm256_storeu_si256((raw_type*)_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_si256((raw_type*)_Dst, _Packet); }
+	{ _mm256_storeu_si256((raw_type*)_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{ return (_Reduce_n<>::value(_First)); }
 };
@@ -96,15 +96,15 @@ template<> struct simd_hop<float, 4> : simd_hop_base<float, 4>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm_set_ps1(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm_load_ps(_First); }
+	{ return _mm_loadu_ps(_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m128_f32; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m128_f32; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm_store_ps(_Dst, _Packet); }
+	{ _mm_storeu_ps(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm_store_ps(_Dst, _Packet); }
+	{ _mm_storeu_ps(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{ return (_Reduce_n<>::value(_First)); }
 };
@@ -113,15 +113,15 @@ template<> struct simd_hop<float, 8> : simd_hop_base<float, 8>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm256_set1_ps(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm256_load_ps(_First); }
+	{ return _mm256_loadu_ps(_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m256_f32; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m256_f32; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_ps(_Dst, _Packet); }
+	{ _mm256_storeu_ps(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_ps(_Dst, _Packet); }
+	{ _mm256_storeu_ps(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{	return (_Reduce_n<>::value(_First)); }
 };
@@ -130,15 +130,15 @@ template<> struct simd_hop<float, 16> : simd_hop_base<float, 16>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm512_set1_ps(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm512_load_ps(_First); }
+	{ return _mm512_loadu_ps(_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m512_f32; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m512_f32; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm512_store_ps(_Dst, _Packet); }
+	{ _mm512_storeu_ps(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm512_store_ps(_Dst, _Packet); }
+	{ _mm512_storeu_ps(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{	return (_Reduce_n<>::value(_First)); }
 };
@@ -147,15 +147,15 @@ template<> struct simd_hop<double, 2> : simd_hop_base<double, 2>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm_set1_pd(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm_load_pd(_First); }
+	{ return _mm_loadu_pd(_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m128d_f64; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m128d_f64; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm_store_pd(_Dst, _Packet); }
+	{ _mm_storeu_pd(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm_store_pd(_Dst, _Packet); }
+	{ _mm_storeu_pd(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{ return (_Reduce_n<>::value(_First)); }
 };
@@ -164,15 +164,15 @@ template<> struct simd_hop<double, 4> : simd_hop_base<double, 4>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm256_set1_pd(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm256_load_pd(_First); }
+	{ return _mm256_loadu_pd(_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m256d_f64; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m256d_f64; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_pd(_Dst, _Packet); }
+	{ _mm256_storeu_pd(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm256_store_pd(_Dst, _Packet); }
+	{ _mm256_storeu_pd(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{ return (_Reduce_n<>::value(_First)); }
 };
@@ -181,15 +181,15 @@ template<> struct simd_hop<double, 8> : simd_hop_base<double, 8>
 	HOST_INL_CXPR_T operator()(const value_t _Value) const noexcept
 	{ return _mm512_set1_pd(_Value); }
 	HOST_INL_CXPR_T operator()(const pointer _First) const noexcept
-	{ return _mm512_load_pd(_First); }
+	{ return _mm512_loadu_pd(_First); }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet) const noexcept
 	{ return  _Packet.m512d_f64; }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet) const noexcept
 	{ return  _Packet.m512d_f64; }
 	HOST_INL_CXPR_T operator()(raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm512_store_pd(_Dst, _Packet); }
+	{ _mm512_storeu_pd(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator()(const raw_type& _Packet, pointer _Dst) const noexcept
-	{ _mm512_store_pd(_Dst, _Packet); }
+	{ _mm512_storeu_pd(_Dst, _Packet); }
 	HOST_INL_CXPR_T operator+ (const pointer _First) const noexcept
 	{	return (_Reduce_n<>::value(_First)); }
 };
@@ -255,6 +255,15 @@ template<> struct simd_vop<float, 4> : public simd_vop_base<float, 4>
 	HOST_STATIC_INL_CXPR_T const abs(const type& _Right) noexcept {
 		return  base_t::_Unary([&]()->type{return _mm_and_ps(_Right, _mm_castsi128_ps(_mm_set1_epi32(~(1 << 31)))); });
 	}
+	HOST_STATIC_INL_CXPR_T const sqrt(const type& _Right) noexcept {
+		return base_t::_Unary([&]()->type{ return _mm_sqrt_ps(_Right); });
+	}
+	HOST_STATIC_INL_CXPR_T max(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm_max_ps(_Left, _Right); });
+	}
+	HOST_STATIC_INL_CXPR_T min(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm_min_ps(_Left, _Right); });
+	}
 };
 template<> struct simd_vop<float, 8> : public simd_vop_base<float, 8>
 {
@@ -278,6 +287,15 @@ template<> struct simd_vop<float, 8> : public simd_vop_base<float, 8>
 	HOST_STATIC_INL_CXPR_T const abs(const type& _Right) noexcept {
 		return base_t::_Unary([&]()->type{ return _mm256_and_ps(_Right, _mm256_castsi256_ps(_mm256_set1_epi32(~(1 << 31)))); });
 	}
+	HOST_STATIC_INL_CXPR_T const sqrt(const type& _Right) noexcept {
+		return base_t::_Unary([&]()->type{ return _mm256_sqrt_ps(_Right); });
+	}
+	HOST_STATIC_INL_CXPR_T max(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm256_max_ps(_Left, _Right); });
+	}
+	HOST_STATIC_INL_CXPR_T min(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm256_min_ps(_Left, _Right); });
+	}
 };
 template<> struct simd_vop<float, 16> : public simd_vop_base<float, 16>
 {
@@ -301,6 +319,15 @@ template<> struct simd_vop<float, 16> : public simd_vop_base<float, 16>
 	HOST_STATIC_INL_CXPR_T const abs(const type& _Right) noexcept {
 		return base_t::_Unary([&]()->type{return _mm512_castsi512_ps(_mm512_srli_epi64(_mm512_slli_epi64(_mm512_castps_si512(_Right), 1), 1)); });
 	}
+	HOST_STATIC_INL_CXPR_T const sqrt(const type& _Right) noexcept {
+		return base_t::_Unary([&]()->type{ return _mm512_sqrt_ps(_Right); });
+	}
+	HOST_STATIC_INL_CXPR_T max(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm512_max_ps(_Left, _Right); });
+	}
+	HOST_STATIC_INL_CXPR_T min(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm512_min_ps(_Left, _Right); });
+	}
 };
 template<> struct simd_vop<double, 2> : public simd_vop_base<double, 2>
 {
@@ -323,6 +350,15 @@ template<> struct simd_vop<double, 2> : public simd_vop_base<double, 2>
 	HOST_STATIC_INL_CXPR_T const abs(const type& _Right) noexcept {
 		return base_t::_Unary([&]()->type{ return _mm_and_pd(_Right, _mm_castsi128_pd(_mm_setr_epi32(-1, 0x7FFFFFFF, -1, 0x7FFFFFFF)));});
 	}
+	HOST_STATIC_INL_CXPR_T const sqrt(const type& _Right) noexcept {
+		return base_t::_Unary([&]()->type{ return _mm_sqrt_pd(_Right); });
+	}
+	HOST_STATIC_INL_CXPR_T max(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm_max_pd(_Left, _Right); });
+	}
+	HOST_STATIC_INL_CXPR_T min(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm_min_pd(_Left, _Right); });
+	}
 };
 template<> struct simd_vop<double, 4> : public simd_vop_base<double, 4>
 {
@@ -346,6 +382,15 @@ template<> struct simd_vop<double, 4> : public simd_vop_base<double, 4>
 	HOST_STATIC_INL_CXPR_T const abs(const type& _Right) noexcept {
 		return base_t::_Unary([&]()->type{ return _mm256_and_pd(_Right, _mm256_castsi256_pd(_mm256_set1_epi32(~(1 << 31)))); });
 	}
+	HOST_STATIC_INL_CXPR_T const sqrt(const type& _Right) noexcept {
+		return base_t::_Unary([&]()->type{ return _mm256_sqrt_pd(_Right); });
+	}
+	HOST_STATIC_INL_CXPR_T max(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm256_max_pd(_Left, _Right); });
+	}
+	HOST_STATIC_INL_CXPR_T min(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm256_min_pd(_Left, _Right); });
+	}
 };
 template<> struct simd_vop<double, 8> : public simd_vop_base<double, 8>
 {
@@ -367,6 +412,15 @@ template<> struct simd_vop<double, 8> : public simd_vop_base<double, 8>
 		return base_t::_Binary([&]()->auto{return _mm512_div_pd(_Left, _Right); });
 	}
 	HOST_STATIC_INL_CXPR_T const abs(const type& _Right) noexcept { return _Right; }
+	HOST_STATIC_INL_CXPR_T const sqrt(const type& _Right) noexcept {
+		return base_t::_Unary([&]()->type{ return _mm512_sqrt_pd(_Right); });
+	}
+	HOST_STATIC_INL_CXPR_T max(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm512_max_pd(_Left, _Right); });
+	}
+	HOST_STATIC_INL_CXPR_T min(const type& _Left, const type& _Right) noexcept {
+		return base_t::_Binary([&]()->auto{return _mm512_min_pd(_Left, _Right); });
+	}
 };
 #pragma endregion
 
@@ -70,6 +70,20 @@ struct Op_ MATRICE_NONHERITABLE {
 			return impl::simd_vop<value_t, size>::div(_Left, _Right);
 		}
 	};
+	template<size_t _Elems> struct maximum {
+		using type = typename _base_type<_Elems>::type;
+		enum { size = _base_type<_Elems>::num_of_elem };
+		MATRICE_HOST_INL decltype(auto)operator()(const type& _Left, const type& _Right) {
+			return impl::simd_vop<value_t, size>::max(_Left, _Right);
+		}
+	};
+	template<size_t _Elems> struct minimum {
+		using type = typename _base_type<_Elems>::type;
+		enum { size = _base_type<_Elems>::num_of_elem };
+		MATRICE_HOST_INL decltype(auto)operator()(const type& _Left, const type& _Right) {
+			return impl::simd_vop<value_t, size>::min(_Left, _Right);
+		}
+	};
 
 	/**
 	 * ... - vertical unary arithmetic operations.
@@ -81,6 +95,13 @@ struct Op_ MATRICE_NONHERITABLE {
 			return impl::simd_vop<value_t, size>::abs(_Right);
 		}
 	};
+	template<size_t _Elems> struct sqrt {
+		using type = typename _base_type<_Elems>::type;
+		enum { size = _base_type<_Elems>::num_of_elem };
+		MATRICE_HOST_INL decltype(auto)operator()(const type& _Right)noexcept{
+			return impl::simd_vop<value_t, size>::sqrt(_Right);
+		}
+	};
 
 	/**
 	 * adaptor - for data loading, storing and horizontal collection.
@@ -49,6 +49,11 @@ Packet_<T, _Elems> Packet_<T, _Elems>::abs() const
 {
 	return (transform<op_t::abs<size>>(*this));
 }
+template<typename T, int _Elems> MATRICE_HOST_FINL
+Packet_<T, _Elems> Packet_<T, _Elems>::sqrt() const
+{
+	return (transform<op_t::sqrt<size>>(*this));
+}
 
 template<typename T, int _N, typename Packet>
 MATRICE_HOST_FINL Packet operator+(const Packet_<T, _N>& _Left, const Packet_<T, _N>& _Right)
@@ -157,6 +162,21 @@ MATRICE_HOST_FINL Packet abs(const Packet_<T, _N>& _Right)
 {
 	return (transform<Packet::op_t::abs<_N>>(_Right));
 }
+template<typename T, int _N, typename Packet = Packet_<T, _N>>
+MATRICE_HOST_FINL Packet sqrt(const Packet_<T, _N>& _Right)
+{
+	return (transform<Packet::op_t::sqrt<_N>>(_Right));
+}
+template<typename T, int _N, typename Packet = Packet_<T, _N>>
+MATRICE_HOST_FINL Packet max(const Packet_<T, _N>& _Left, const Packet_<T, _N>& _Right)
+{
+	return (transform<Packet::op_t::maximum<_N>>(_Left, _Right));
+}
+template<typename T, int _N, typename Packet = Packet_<T, _N>>
+MATRICE_HOST_FINL Packet min(const Packet_<T, _N>& _Left, const Packet_<T, _N>& _Right)
+{
+	return (transform<Packet::op_t::minimum<_N>>(_Left, _Right));
+}
 template<typename T, int _N, typename = enable_if_t<is_arithmetic_v<T>>>
 MATRICE_HOST_FINL T reduce(const Packet_<T, _N>& _Right)
 {
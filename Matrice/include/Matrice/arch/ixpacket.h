@@ -63,9 +63,16 @@ public:
 	MATRICE_HOST_FINL Myt& operator* (const Packet_& _other);
 	MATRICE_HOST_FINL Myt& operator/ (const Packet_& _other);
 	MATRICE_HOST_FINL Myt  abs() const;
+	MATRICE_HOST_FINL Myt  sqrt() const;
 
 	template<typename T, int _Elems, typename Packet> friend
 	MATRICE_HOST_FINL Packet abs(const Packet_<T, _Elems>& _Right);
+	template<typename T, int _Elems, typename Packet> friend
+	MATRICE_HOST_FINL Packet sqrt(const Packet_<T, _Elems>& _Right);
+	template<typename T, int _Elems, typename Packet> friend
+	MATRICE_HOST_FINL Packet max(const Packet_<T, _Elems>& _Left, const Packet_<T, _Elems>& _Right);
+	template<typename T, int _Elems, typename Packet> friend
+	MATRICE_HOST_FINL Packet min(const Packet_<T, _Elems>& _Left, const Packet_<T, _Elems>& _Right);
 	template<typename T, int _Elems, typename> friend
 	MATRICE_HOST_FINL T reduce(const Packet_<T, _Elems>& _Right);
 };
@@ -0,0 +1,355 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "core/matrix.h"
+#include "core/span.h"
+#include "util/_exception.h"
+
+DGE_MATRICE_BEGIN namespace io {
+using path_t = MATRICE_STD(filesystem::path);
+
+/**
+ *\brief Element types of the binary container.
+ */
+enum class dtype : uint8_t {
+	unknown = 0, u8, i8, u16, i16, u32, i32, u64, i64, f32, f64
+};
+
+_DETAIL_BEGIN
+template<typename _Ty> constexpr dtype _Dtype_of() noexcept {
+	if constexpr (is_floating_point_v<_Ty>)
+		return sizeof(_Ty) == 4 ? dtype::f32 : dtype::f64;
+	else if constexpr (MATRICE_STD(is_integral_v)<_Ty> && MATRICE_STD(is_signed_v)<_Ty>)
+		return sizeof(_Ty) == 1 ? dtype::i8 : sizeof(_Ty) == 2 ? dtype::i16 :
+		sizeof(_Ty) == 4 ? dtype::i32 : dtype::i64;
+	else if constexpr (MATRICE_STD(is_integral_v)<_Ty>)
+		return sizeof(_Ty) == 1 ? dtype::u8 : sizeof(_Ty) == 2 ? dtype::u16 :
+		sizeof(_Ty) == 4 ? dtype::u32 : dtype::u64;
+	else return dtype::unknown;
+}
+
+/**
+ *\brief File header of the binary container, 64 bytes. The header is
+ followed by fixed-shape frames, the i-th frame starts at byte
+ 64+i*stride, where the stride is the row-major payload of a frame padded
+ to a multiple of 64 bytes. So every frame is 64-byte aligned in a mapped
+ file, and the number of frames follows from the file size, a frame being
+ appended is not visible until it has been fully written.
+ */
+struct _Binary_header {
+	static constexpr uint16_t version_value = 1;
+	static constexpr uint16_t endian_value = 0x0102;
+	static constexpr size_t alignment = 64;
+
+	char magic[8] = { 'M', 'A', 'T', 'R', 'I', 'C', 'E', '\0' };
+	uint16_t version = version_value;
+	uint16_t endian = endian_value;
+	dtype type = dtype::unknown;
+	uint8_t elsize = 0;
+	uint8_t layout = 0; // 0 for row-major
+	uint8_t rank = 2;   // 2 for a matrix, 3 for a tensor
+	uint64_t shape[3] = { 0, 0, 1 }; // height, width and depth of a frame
+	uint64_t stride = 0;
+	uint64_t reserved[2] = { 0, 0 };
+
+	MATRICE_HOST_INL size_t frame_size() const noexcept {
+		return shape[0] * shape[1] * shape[2];
+	}
+	MATRICE_HOST_INL bool valid() const noexcept {
+		return MATRICE_STD(memcmp)(magic, "MATRICE", 8) == 0 &&
+			version == version_value && endian == endian_value && layout == 0 &&
+			stride % alignment == 0 && stride >= frame_size() * elsize;
+	}
+};
+static_assert(sizeof(_Binary_header) == _Binary_header::alignment,
+	"The header of the binary container must have 64 bytes.");
+
+/**
+ *\brief Read-only mapping of a whole file.
+ */
+class _Mapped_file {
+	using _Myt = _Mapped_file;
+public:
+	_Mapped_file() noexcept = default;
+	_Mapped_file(const _Myt&) = delete;
+	_Mapped_file(_Myt&& _Other) noexcept {
+		*this = MATRICE_STD(move)(_Other);
+	}
+	~_Mapped_file() { close(); }
+
+	_Myt& operator=(_Myt&& _Other) noexcept {
+		if (this != &_Other) {
+			close();
+			MATRICE_STD(swap)(_Mydata, _Other._Mydata);
+			MATRICE_STD(swap)(_Mysize, _Other._Mysize);
+		}
+		return (*this);
+	}
+
+	/**
+	 *\brief Map a file read-only, it fails for a missing or empty file.
+	 */
+	MATRICE_HOST_ONLY bool open(const path_t& _Path);
+	MATRICE_HOST_ONLY void close() noexcept;
+
+	MATRICE_HOST_FINL const uint8_t* data() const noexcept {
+		return static_cast<const uint8_t*>(_Mydata);
+	}
+	MATRICE_HOST_FINL size_t size() const noexcept {
+		return (_Mysize);
+	}
+
+private:
+	void* _Mydata = nullptr;
+	size_t _Mysize = 0;
+};
+_DETAIL_END
+
+/// <summary>
+/// \brief CLASS TEMPLATE, writer of the binary container. Frames of a fixed
+/// shape, such as the displacement field of each image of a sequence, are
+/// appended to the file one after another.
+/// </summary>
+/// <typeparam name="_Ty">Element type, an arithmetic type</typeparam>
+/// <example>
+/// io::binary_writer<float> w(path, {npts, 2});
+/// for (...) w.append(disp);
+/// </example>
+template<typename _Ty>
+class binary_writer {
+	using _Myt = binary_writer;
+	using _Myheader = detail::_Binary_header;
+public:
+	using value_type = _Ty;
+	static_assert(detail::_Dtype_of<value_type>() != dtype::unknown,
+		"Unsupported element type of binary_writer.");
+
+	/**
+	 *\brief Create a file for frames of '_Shape', or append to it if
+	 '_Append' is true and it exists, where its header must agree with the
+	 element type and '_Shape'. A partially written trailing frame of an
+	 existing file is dropped.
+	 */
+	binary_writer(const path_t& _Path, const shape_t<3>& _Shape, bool _Append = false) {
+		_Myheader _Hdr;
+		_Hdr.type = detail::_Dtype_of<value_type>();
+		_Hdr.elsize = uint8_t(sizeof(value_type));
+		_Hdr.rank = _Shape.d > 1 ? 3 : 2;
+		_Hdr.shape[0] = _Shape.h, _Hdr.shape[1] = _Shape.w, _Hdr.shape[2] = _Shape.d;
+		const auto _Bytes = _Hdr.frame_size() * sizeof(value_type);
+		_Hdr.stride = (_Bytes + _Myheader::alignment - 1) / _Myheader::alignment * _Myheader::alignment;
+		_Hdr.stride = (MATRICE_STD(max))(_Hdr.stride, uint64_t(_Myheader::alignment));
+		_Myheader_data = _Hdr;
+
+		if (_Path.has_parent_path() && !MATRICE_STD(filesystem)::exists(_Path.parent_path()))
+			MATRICE_STD(filesystem)::create_directories(_Path.parent_path());
+
+		if (_Append && MATRICE_STD(filesystem)::exists(_Path) && MATRICE_STD(filesystem)::file_size(_Path) >= sizeof(_Myheader)) {
+			_Myheader _Old;
+			{
+				MATRICE_STD(ifstream) _Fin(_Path, MATRICE_STD(ios)::binary);
+				_Fin.read(reinterpret_cast<char*>(&_Old), sizeof(_Old));
+			}
+			DGELOM_CHECK(_Old.valid() && _Old.type == _Hdr.type && _Old.stride == _Hdr.stride &&
+				MATRICE_STD(equal)(_Old.shape, _Old.shape + 3, _Hdr.shape),
+				"The file " + _Path.string() + " has a different element type or frame shape.");
+			_Mycount = (MATRICE_STD(filesystem)::file_size(_Path) - sizeof(_Myheader)) / _Hdr.stride;
+			MATRICE_STD(filesystem)::resize_file(_Path, sizeof(_Myheader) + _Mycount * _Hdr.stride);
+			_Myfile.open(_Path, MATRICE_STD(ios)::binary | MATRICE_STD(ios)::app);
+		}
+		else {
+			_Myfile.open(_Path, MATRICE_STD(ios)::binary | MATRICE_STD(ios)::trunc);
+			_Myfile.write(reinterpret_cast<const char*>(&_Hdr), sizeof(_Hdr));
+		}
+		DGELOM_CHECK(_Myfile.is_open(), "Fail to open file: " + _Path.string());
+	}
+	binary_writer(const path_t& _Path, const shape_t<2>& _Shape, bool _Append = false)
+		: binary_writer(_Path, shape_t<3>(_Shape.h, _Shape.w, 1), _Append) {
+	}
+
+	/**
+	 *\brief Append a frame of 'frame_size()' elements.
+	 *\return Index of the frame.
+	 */
+	MATRICE_HOST_INL size_t append(const value_type* _Data) {
+		const auto _Bytes = frame_size() * sizeof(value_type);
+		_Myfile.write(reinterpret_cast<const char*>(_Data), _Bytes);
+		if (const auto _Pad = _Myheader_data.stride - _Bytes; _Pad > 0) {
+			static const char _Zeros[_Myheader::alignment] = {};
+			_Myfile.write(_Zeros, _Pad);
+		}
+		DGELOM_CHECK(_Myfile.good(), "Fail to append a frame to the binary file.");
+		return (_Mycount++);
+	}
+	/**
+	 *\brief Append a matrix or tensor with the frame shape.
+	 */
+	template<typename _Mty, MATRICE_ENABLE_IF(!MATRICE_STD(is_pointer_v)<_Mty>)>
+	MATRICE_HOST_INL size_t append(const _Mty& _Frame) {
+		DGELOM_CHECK(size_t(_Frame.size()) == frame_size(),
+			"The size of the frame does not match the binary file.");
+		return append(_Frame.data());
+	}
+
+	/**
+	 *\brief Flush the frames written to the file, so that a reader sees them.
+	 */
+	MATRICE_HOST_INL void flush() {
+		_Myfile.flush();
+	}
+	MATRICE_HOST_INL void close() {
+		_Myfile.close();
+	}
+
+	/**
+	 *\brief Number of frames in the file and the number of elements of a frame.
+	 */
+	MATRICE_HOST_FINL size_t count() const noexcept {
+		return (_Mycount);
+	}
+	MATRICE_HOST_FINL size_t frame_size() const noexcept {
+		return _Myheader_data.frame_size();
+	}
+
+private:
+	_Myheader _Myheader_data;
+	size_t _Mycount = 0;
+	MATRICE_STD(ofstream) _Myfile;
+};
+
+/// <summary>
+/// \brief CLASS TEMPLATE, reader of the binary container. The file is
+/// mapped to memory, a frame is a view of the mapped payload and is read
+/// without a copy, and any frame can be accessed at a constant cost.
+/// </summary>
+/// <typeparam name="_Ty">Element type, which must be the type of the file</typeparam>
+/// <example>
+/// io::binary_reader<float> r(path);
+/// for (size_t i = 0; i < r.count(); ++i) { const auto f = r[i]; ... }
+/// </example>
+template<typename _Ty>
+class binary_reader {
+	using _Myt = binary_reader;
+	using _Myheader = detail::_Binary_header;
+public:
+	using value_type = _Ty;
+	using view_type = span<const value_type>;
+
+	binary_reader(const path_t& _Path)
+		: _Mypath(_Path) {
+		DGELOM_CHECK(refresh(), "Fail to map the binary file: " + _Path.string());
+	}
+
+	/**
+	 *\brief Map the file again to see frames appended since it was mapped.
+	 The views taken before are invalidated on success. If it fails, the
+	 previous mapping, its frame count and views are kept.
+	 */
+	MATRICE_HOST_INL bool refresh() {
+		detail::_Mapped_file _Map;
+		if (!_Map.open(_Mypath) || _Map.size() < sizeof(_Myheader))
+			return false;
+		_Myheader _Hdr;
+		MATRICE_STD(memcpy)(&_Hdr, _Map.data(), sizeof(_Myheader));
+		DGELOM_CHECK(_Hdr.valid(),
+			"The file " + _Mypath.string() + " is not a valid binary file.");
+		DGELOM_CHECK(_Hdr.type == detail::_Dtype_of<value_type>(),
+			"The element type does not match the binary file.");
+		_Mymap = MATRICE_STD(move)(_Map);
+		_Myheader_data = _Hdr;
+		_Mycount = (_Mymap.size() - sizeof(_Myheader)) / _Myheader_data.stride;
+		return true;
+	}
+
+	/**
+	 *\brief Number of frames, the shape {h, w, d} of a frame and its size.
+	 */
+	MATRICE_HOST_FINL size_t count() const noexcept {
+		return (_Mycount);
+	}
+	MATRICE_HOST_FINL shape_t<3> shape() const noexcept {
+		return shape_t<3>(_Myheader_data.shape[0], _Myheader_data.shape[1], _Myheader_data.shape[2]);
+	}
+	MATRICE_HOST_FINL size_t frame_size() const noexcept {
+		return _Myheader_data.frame_size();
+	}
+
+	/**
+	 *\brief View of the i-th frame, valid while the reader is alive.
+	 */
+	MATRICE_HOST_INL view_type operator[](size_t i) const {
+#ifdef MATRICE_DEBUG
+		DGELOM_CHECK(i < _Mycount, "frame index out of range.");
+#endif
+		const auto _Ptr = _Mymap.data() + sizeof(_Myheader) + i * _Myheader_data.stride;
+		return view_type(reinterpret_cast<const value_type*>(_Ptr), frame_size());
+	}
+
+	/**
+	 *\brief Copy the i-th frame to '_Dst'. A matrix is created with (h*d) x w
+	 if its size differs, a tensor must have the frame size.
+	 */
+	template<typename _Mty>
+	MATRICE_HOST_INL _Mty& read(size_t i, _Mty& _Dst) const {
+		DGELOM_CHECK(i < _Mycount, "frame index out of range.");
+		if (const auto _Shape = shape(); size_t(_Dst.size()) != frame_size()) {
+			DGELOM_CHECK(_Dst.shape().d == 1, "The size of the tensor does not match the frame.");
+			_Dst.create(_Shape.rows(), _Shape.cols());
+		}
+		const auto _View = (*this)[i];
+		MATRICE_STD(copy)(_View.begin(), _View.end(), _Dst.data());
+		return (_Dst);
+	}
+	/**
+	 *\brief Copy the i-th frame to a matrix of (h*d) x w.
+	 */
+	MATRICE_HOST_INL Matrix<value_type> frame(size_t i) const {
+		Matrix<value_type> _Ret;
+		return MATRICE_STD(move)(read(i, _Ret));
+	}
+
+private:
+	path_t _Mypath;
+	detail::_Mapped_file _Mymap;
+	_Myheader _Myheader_data;
+	size_t _Mycount = 0;
+};
+
+/// <summary>
+/// \brief FUNCTION, save a matrix or a tensor to a binary file as one frame.
+/// </summary>
+template<typename _Mty>
+MATRICE_HOST_INL void save_binary(const _Mty& _Data, const path_t& _Path) {
+	using value_type = remove_all_t<decltype(*_Data.data())>;
+	binary_writer<value_type>(_Path, _Data.shape()).append(_Data);
+}
+
+/// <summary>
+/// \brief FUNCTION, load the i-th frame of a binary file into a matrix.
+/// </summary>
+template<typename _Ty>
+MATRICE_HOST_INL Matrix<_Ty> load_binary(const path_t& _Path, size_t i = 0) {
+	return binary_reader<_Ty>(_Path).frame(i);
+}
+} DGE_MATRICE_END
@@ -0,0 +1,287 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "_binary_file.hpp"
+
+// \brief Bytes of text parsed at a time by the streaming CSV reader.
+#ifndef MATRICE_CSV_BLOCK_SIZE
+#define MATRICE_CSV_BLOCK_SIZE (size_t(64) << 20)
+#endif
+// \brief Min. bytes of text of a chunk parsed by one thread.
+#ifndef MATRICE_CSV_CHUNK_SIZE
+#define MATRICE_CSV_CHUNK_SIZE (size_t(1) << 20)
+#endif
+
+DGE_MATRICE_BEGIN namespace io { _DETAIL_BEGIN
+/// <summary>
+/// \brief CLASS TEMPLATE, parser of numeric delimited text. Fields are
+/// separated by any run of ',', ';', tabs or spaces, and parsed with
+/// std::from_chars. A piece of text is cut into chunks at line breaks,
+/// the rows of the chunks are counted in parallel, the destination is
+/// sized once, and the chunks are then parsed in parallel into their rows
+/// of the destination. Lines of separators only are skipped.
+/// </summary>
+/// <typeparam name="_Ty">Arithmetic value type</typeparam>
+template<typename _Ty> class _Csv_parser {
+public:
+	using value_type = _Ty;
+
+	/**
+	 *\brief Parse the fields [_Col0, _Col1) of each line of [_First, _Last)
+	 into '_Dst', which is resized to the number of lines by (_Col1-_Col0).
+	 If '_Col1' is 0, all fields of the first line are parsed.
+	 *\return Number of fields of the first line.
+	 */
+	static MATRICE_HOST_INL size_t eval(const char* _First, const char* _Last,
+		Matrix<value_type>& _Dst, size_t _Col0 = 0, size_t _Col1 = 0) {
+		_First = _Skip_empty(_First, _Last);
+		if (_First == _Last) {
+			_Dst.create(0, _Col1 > _Col0 ? _Col1 - _Col0 : 0);
+			return 0;
+		}
+		const auto _Nfields = _Count_fields(_First, _Line_end(_First, _Last));
+		if (_Col1 == 0) _Col1 = _Nfields;
+		DGELOM_CHECK(_Col0 < _Col1, "Empty column range of the text to be parsed.");
+		const auto _Cols = _Col1 - _Col0;
+
+		// \chunks at line breaks, and their rows
+		const auto _Chunks = _Split(_First, _Last);
+		const auto _Nchunks = index_t(_Chunks.size() - 1);
+		MATRICE_STD(vector)<size_t> _Offsets(_Chunks.size(), 0);
+#pragma omp parallel for schedule(dynamic) if(_Nchunks > 1)
+		for (index_t _Idx = 0; _Idx < _Nchunks; ++_Idx) {
+			_Offsets[_Idx + 1] = _Count_rows(_Chunks[_Idx], _Chunks[_Idx + 1]);
+		}
+		for (size_t _Idx = 1; _Idx < _Offsets.size(); ++_Idx)
+			_Offsets[_Idx] += _Offsets[_Idx - 1];
+
+		const auto _Rows = _Offsets.back();
+		if (size_t(_Dst.rows()) != _Rows || size_t(_Dst.cols()) != _Cols)
+			_Dst.create(_Rows, _Cols);
+
+		const auto _Data = _Dst.data();
+		index_t _Failed = 0;
+#pragma omp parallel for schedule(dynamic) if(_Nchunks > 1) reduction(+:_Failed)
+		for (index_t _Idx = 0; _Idx < _Nchunks; ++_Idx) {
+			_Failed += _Parse_rows(_Chunks[_Idx], _Chunks[_Idx + 1],
+				_Data + _Offsets[_Idx] * _Cols, _Col0, _Col1);
+		}
+		DGELOM_CHECK(_Failed == 0, MATRICE_STD(to_string)(_Failed) +
+			" line(s) have invalid numbers or less than " + MATRICE_STD(to_string)(_Col1) +
+			" fields, headers can be skipped with '_Skips'.");
+
+		return _Nfields;
+	}
+
+	/**
+	 *\brief Skip '_Count' lines from '_First'.
+	 */
+	static MATRICE_HOST_INL const char* skip_lines(const char* _First, const char* _Last, size_t _Count) noexcept {
+		for (; _Count > 0 && _First != _Last; --_Count) {
+			_First = _Line_end(_First, _Last);
+			if (_First != _Last) ++_First;
+		}
+		return (_First);
+	}
+
+	/**
+	 *\brief End of the last complete line in [_First, _Last).
+	 */
+	static MATRICE_HOST_INL const char* last_line_end(const char* _First, const char* _Last) noexcept {
+		for (auto _It = _Last; _It != _First; --_It) {
+			if (_It[-1] == '\n') return (_It);
+		}
+		return (_First);
+	}
+
+private:
+	static MATRICE_HOST_FINL bool _Is_sep(char _C) noexcept {
+		return _C == ',' || _C == ' ' || _C == '\t' || _C == ';' || _C == '\r';
+	}
+	static MATRICE_HOST_FINL const char* _Line_end(const char* _First, const char* _Last) noexcept {
+		const auto _It = static_cast<const char*>(MATRICE_STD(memchr)(_First, '\n', size_t(_Last - _First)));
+		return _It ? _It : _Last;
+	}
+	static MATRICE_HOST_FINL const char* _Skip_sep(const char* _First, const char* _Last) noexcept {
+		while (_First != _Last && _Is_sep(*_First)) ++_First;
+		return (_First);
+	}
+	// \skip the lines which have separators only
+	static MATRICE_HOST_INL const char* _Skip_empty(const char* _First, const char* _Last) noexcept {
+		for (;;) {
+			const auto _It = _Skip_sep(_First, _Last);
+			if (_It == _Last || *_It != '\n') return (_First);
+			_First = _It + 1;
+		}
+	}
+
+	/**
+	 *\brief Cut [_First, _Last) into chunks of at least MATRICE_CSV_CHUNK_SIZE
+	 bytes, which begin at line starts.
+	 */
+	static MATRICE_HOST_INL auto _Split(const char* _First, const char* _Last) {
+		MATRICE_STD(vector)<const char*> _Chunks{ _First };
+		const auto _Step = size_t(MATRICE_CSV_CHUNK_SIZE);
+		while (size_t(_Last - _Chunks.back()) > _Step) {
+			auto _It = _Line_end(_Chunks.back() + _Step, _Last);
+			if (_It == _Last) break;
+			_Chunks.push_back(_It + 1);
+		}
+		_Chunks.push_back(_Last);
+		return (_Chunks);
+	}
+
+	static MATRICE_HOST_INL size_t _Count_fields(const char* _First, const char* _Last) noexcept {
+		size_t _Cnt = 0;
+		for (_First = _Skip_sep(_First, _Last); _First != _Last; _First = _Skip_sep(_First, _Last)) {
+			while (_First != _Last && !_Is_sep(*_First)) ++_First;
+			++_Cnt;
+		}
+		return (_Cnt);
+	}
+
+	static MATRICE_HOST_INL size_t _Count_rows(const char* _First, const char* _Last) noexcept {
+		size_t _Cnt = 0;
+		while (_First != _Last) {
+			const auto _End = _Line_end(_First, _Last);
+			if (_Skip_sep(_First, _End) != _End) ++_Cnt;
+			_First = _End == _Last ? _Last : _End + 1;
+		}
+		return (_Cnt);
+	}
+
+	/**
+	 *\brief Parse a field of [_First, _Last) to '_Val'.
+	 *\return End of the field, or nullptr if it is not a number.
+	 */
+	static MATRICE_HOST_FINL const char* _Parse(const char* _First, const char* _Last, value_type& _Val) noexcept {
+		if (_First != _Last && *_First == '+') ++_First;
+		auto [_It, _Ec] = MATRICE_STD(from_chars)(_First, _Last, _Val);
+		if constexpr (MATRICE_STD(is_integral_v)<value_type>) {
+			// \a field like '3.0' or '1e3' is parsed as double and cast to the integer type
+			if (_Ec == MATRICE_STD(errc)() && _It != _Last && (*_It == '.' || *_It == 'e' || *_It == 'E')) {
+				double _Tmp;
+				const auto _Res = MATRICE_STD(from_chars)(_First, _Last, _Tmp);
+				_It = _Res.ptr, _Ec = _Res.ec, _Val = value_type(_Tmp);
+			}
+		}
+		if (_Ec != MATRICE_STD(errc)() || (_It != _Last && !_Is_sep(*_It)))
+			return nullptr;
+		return (_It);
+	}
+
+	/**
+	 *\brief Parse the fields [_Col0, _Col1) of the lines of [_First, _Last)
+	 to the rows of '_Dst'.
+	 *\return Number of the lines that failed.
+	 */
+	static MATRICE_HOST_INL size_t _Parse_rows(const char* _First, const char* _Last,
+		value_type* _Dst, size_t _Col0, size_t _Col1) noexcept {
+		const auto _Cols = _Col1 - _Col0;
+		size_t _Failed = 0;
+		while (_First != _Last) {
+			const auto _End = _Line_end(_First, _Last);
+			auto _It = _Skip_sep(_First, _End);
+			if (_It != _End) {
+				size_t _Col = 0;
+				for (; _It != _End && _Col < _Col1; ++_Col) {
+					if (_Col < _Col0) {
+						while (_It != _End && !_Is_sep(*_It)) ++_It;
+					}
+					else if (_It = _Parse(_It, _End, _Dst[_Col - _Col0]); !_It) break;
+					_It = _Skip_sep(_It, _End);
+				}
+				if (_Col < _Col1) {
+					++_Failed;
+					MATRICE_STD(fill)(_Dst, _Dst + _Cols, value_type(0));
+				}
+				_Dst += _Cols;
+			}
+			_First = _End == _Last ? _Last : _End + 1;
+		}
+		return (_Failed);
+	}
+};
+
+/// <summary>
+/// \brief CLASS TEMPLATE, numeric CSV reader on a mapped file.
+/// </summary>
+template<typename _Ty> class _Csv_reader {
+	using _Myparser = _Csv_parser<_Ty>;
+public:
+	using value_type = _Ty;
+
+	_Csv_reader(const path_t& _Path, size_t _Skips = 0) {
+		DGELOM_CHECK(_Mymap.open(_Path) || MATRICE_STD(filesystem)::exists(_Path),
+			"Cannot open file in " + _Path.string());
+		const auto _Data = reinterpret_cast<const char*>(_Mymap.data());
+		_Mylast = _Data + _Mymap.size();
+		_Myfirst = _Myparser::skip_lines(_Data, _Mylast, _Skips);
+	}
+
+	/**
+	 *\brief Parse the fields [_Col0, _Col1) of the whole file into a matrix,
+	 all fields of the first line if '_Col1' is 0.
+	 */
+	MATRICE_HOST_INL Matrix<value_type> read(size_t _Col0 = 0, size_t _Col1 = 0) const {
+		Matrix<value_type> _Ret;
+		_Myparser::eval(_Myfirst, _Mylast, _Ret, _Col0, _Col1);
+		return (_Ret);
+	}
+
+	/**
+	 *\brief Parse the file in blocks of about MATRICE_CSV_BLOCK_SIZE bytes
+	 and call '_Op(block, row)' for each of them, where 'block' is a matrix
+	 of the parsed rows, which is reused for the next block, and 'row' is the
+	 index of its first row in the file. The memory is bounded by the block
+	 size, so a file larger than the RAM can be processed.
+	 *\return Number of rows of the file.
+	 */
+	template<typename _Op>
+	MATRICE_HOST_INL size_t read_blocks(_Op&& _Op_block, size_t _Col0 = 0, size_t _Col1 = 0) const {
+		Matrix<value_type> _Block;
+		size_t _Rows = 0;
+		for (auto _First = _Myfirst; _First != _Mylast; ) {
+			auto _Last = _Mylast;
+			if (size_t(_Mylast - _First) > size_t(MATRICE_CSV_BLOCK_SIZE)) {
+				_Last = _Myparser::last_line_end(_First, _First + MATRICE_CSV_BLOCK_SIZE);
+				// \a line longer than a block
+				if (_Last == _First) _Last = _Myparser::skip_lines(_First, _Mylast, 1);
+			}
+			const auto _Nfields = _Myparser::eval(_First, _Last, _Block, _Col0, _Col1);
+			// \fix the columns by the first block
+			if (_Col1 == 0) _Col1 = _Nfields;
+			if (_Block.rows() > 0) {
+				_Op_block(MATRICE_STD(as_const)(_Block), _Rows);
+				_Rows += _Block.rows();
+			}
+			_First = _Last;
+		}
+		return (_Rows);
+	}
+
+private:
+	_Mapped_file _Mymap;
+	const char* _Myfirst = nullptr;
+	const char* _Mylast = nullptr;
+};
+_DETAIL_END } DGE_MATRICE_END
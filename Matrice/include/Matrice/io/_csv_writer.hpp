@@ -0,0 +1,306 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "_binary_file.hpp"
+
+// \brief Bytes of text buffered by the CSV writer before a flush.
+#ifndef MATRICE_CSV_WRITE_BUFFER
+#define MATRICE_CSV_WRITE_BUFFER (size_t(4) << 20)
+#endif
+// \brief Min. number of values of a matrix to be formatted in parallel.
+#ifndef MATRICE_CSV_WRITE_PARALLEL
+#define MATRICE_CSV_WRITE_PARALLEL (size_t(1) << 16)
+#endif
+
+DGE_MATRICE_BEGIN namespace io { _DETAIL_BEGIN
+/// <summary>
+/// \brief CLASS, buffered writer of delimited text. Values are formatted
+/// with std::to_chars into a buffer of MATRICE_CSV_WRITE_BUFFER bytes,
+/// which is written to the file in one call when it is full. Floating
+/// point values take the shortest text that reads back exactly, or
+/// 'precision()' significant digits if it is set. In the async mode,
+/// a full buffer is swapped with a second one and written by a background
+/// thread, while the caller keeps formatting into the other buffer.
+/// A matrix is written in one call, large ones are formatted in parallel.
+/// </summary>
+class _Csv_writer {
+	using _Mybuf_t = MATRICE_STD(vector)<char>;
+	// \max. digits and max. length of a formatted value
+	static constexpr int _Maxprec = 100;
+	static constexpr size_t _Maxlen = 128;
+public:
+	_Csv_writer() = default;
+	_Csv_writer(const _Csv_writer&) = delete;
+	_Csv_writer& operator=(const _Csv_writer&) = delete;
+	~_Csv_writer() {
+		try { close(); } catch (...) {}
+	}
+
+	/**
+	 *\brief Open a file, which is truncated unless '_Append' is true. The
+	 parent folders are created if they are missing.
+	 */
+	MATRICE_HOST_INL void open(const path_t& _Path, bool _Append = false, bool _Async = false) {
+		close();
+		if (_Path.has_parent_path() && !MATRICE_STD(filesystem)::exists(_Path.parent_path()))
+			MATRICE_STD(filesystem)::create_directories(_Path.parent_path());
+
+		_Myfile.rdbuf()->pubsetbuf(nullptr, 0);
+		_Myfile.open(_Path, MATRICE_STD(ios)::binary | MATRICE_STD(ios)::out |
+			(_Append ? MATRICE_STD(ios)::app : MATRICE_STD(ios)::trunc));
+		DGELOM_CHECK(_Myfile.is_open(), "Fail to open the file in " + _Path.string());
+
+		_Mybuf.resize(MATRICE_CSV_WRITE_BUFFER), _Mypos = 0;
+		if (_Async) {
+			_Myback.resize(_Mybuf.size());
+			_Mystop = false, _Mybusy = false;
+			_Mythread = MATRICE_STD(thread)([this] { _Run(); });
+		}
+	}
+	MATRICE_HOST_FINL bool is_open() const noexcept {
+		return _Myfile.is_open();
+	}
+
+	/**
+	 *\brief Write the buffered text and wait for the background thread. An
+	 error of a background write is rethrown here.
+	 */
+	MATRICE_HOST_INL void flush() {
+		if (!is_open()) return;
+		_Submit();
+		if (_Mythread.joinable()) {
+			MATRICE_STD(unique_lock)<MATRICE_STD(mutex)> _Lock(_Mymtx);
+			_Mycv.wait(_Lock, [this] { return !_Mybusy; });
+		}
+		_Rethrow();
+		_Myfile.flush();
+	}
+
+	/**
+	 *\brief Flush, stop the background thread and close the file.
+	 */
+	MATRICE_HOST_INL void close() {
+		if (!is_open()) return;
+		auto _Except = MATRICE_STD(exception_ptr)();
+		try { flush(); }
+		catch (...) { _Except = MATRICE_STD(current_exception)(); }
+		if (_Mythread.joinable()) {
+			{
+				MATRICE_STD(lock_guard)<MATRICE_STD(mutex)> _Lock(_Mymtx);
+				_Mystop = true;
+			}
+			_Mycv.notify_all();
+			_Mythread.join();
+		}
+		_Myfile.close();
+		_Mybuf = _Mybuf_t(), _Myback = _Mybuf_t(), _Mypos = 0;
+		if (_Except) MATRICE_STD(rethrow_exception)(_Except);
+	}
+
+	/**
+	 *\brief Significant digits of floating point values, at most 100. The
+	 shortest exact text is written if '_Digits' is less than 1.
+	 */
+	MATRICE_HOST_FINL _Csv_writer& precision(int _Digits) noexcept {
+		_Myprec = (MATRICE_STD(min))(_Digits, _Maxprec);
+		return (*this);
+	}
+	MATRICE_HOST_FINL int precision() const noexcept {
+		return _Myprec;
+	}
+
+	/**
+	 *\brief Append a piece of text or a single value, the writer must be open.
+	 */
+	MATRICE_HOST_INL void put(MATRICE_STD(string_view) _Str) {
+		DGELOM_CHECK(is_open(), "The CSV writer is not open.");
+		while (!_Str.empty()) {
+			if (_Mypos == _Mybuf.size()) _Submit();
+			const auto _Size = (MATRICE_STD(min))(_Str.size(), _Mybuf.size() - _Mypos);
+			MATRICE_STD(memcpy)(_Mybuf.data() + _Mypos, _Str.data(), _Size);
+			_Mypos += _Size, _Str.remove_prefix(_Size);
+		}
+	}
+	template<typename _Ty>
+	MATRICE_HOST_INL void put(const _Ty& _Val) {
+		if constexpr (MATRICE_STD(is_arithmetic_v)<_Ty> && !MATRICE_STD(is_same_v)<_Ty, char>) {
+			DGELOM_CHECK(is_open(), "The CSV writer is not open.");
+			for (;;) {
+				const auto _Res = _Format(_Mybuf.data() + _Mypos, _Mybuf.data() + _Mybuf.size(), _Val);
+				if (_Res.ec == MATRICE_STD(errc)()) {
+					_Mypos = _Res.ptr - _Mybuf.data();
+					return;
+				}
+				DGELOM_CHECK(_Mypos != 0, "The CSV write buffer is too small for a value.");
+				_Submit();
+			}
+		}
+		else if constexpr (MATRICE_STD(is_convertible_v)<const _Ty&, MATRICE_STD(string_view)>)
+			put(MATRICE_STD(string_view)(_Val));
+		else if constexpr (MATRICE_STD(is_same_v)<_Ty, char>)
+			put(MATRICE_STD(string_view)(&_Val, 1));
+		else {
+			MATRICE_STD(ostringstream) _Os;
+			_Os << _Val;
+			put(MATRICE_STD(string_view)(_Os.str()));
+		}
+	}
+
+	/**
+	 *\brief Append a line of the values in [_First, _Last), which are
+	 separated by '_Delm'.
+	 */
+	template<typename _It>
+	MATRICE_HOST_INL void line(_It _First, _It _Last, MATRICE_STD(string_view) _Delm) {
+		for (; _First != _Last;) {
+			put(*_First);
+			if (++_First != _Last) put(_Delm);
+		}
+		put(MATRICE_STD(string_view)("\n"));
+	}
+
+	/**
+	 *\brief Append '_Rows' lines of '_Cols' values of a row-major array.
+	 Blocks of rows are formatted in parallel into separate strings, which
+	 are then appended in order.
+	 */
+	template<typename _Ty>
+	MATRICE_HOST_INL void lines(const _Ty* _Data, size_t _Rows, size_t _Cols, MATRICE_STD(string_view) _Delm) {
+		DGELOM_CHECK(is_open(), "The CSV writer is not open.");
+		constexpr auto _Is_number = MATRICE_STD(is_arithmetic_v)<_Ty> && !MATRICE_STD(is_same_v)<_Ty, char>;
+		if (!_Is_number || _Rows * _Cols < MATRICE_CSV_WRITE_PARALLEL) {
+			for (size_t _Row = 0; _Row < _Rows; ++_Row, _Data += _Cols)
+				line(_Data, _Data + _Cols, _Delm);
+		}
+		else if constexpr (_Is_number) {
+			constexpr size_t _Nblocks = 16;
+			const auto _Block = (MATRICE_STD(max))(size_t(1), (MATRICE_CSV_WRITE_PARALLEL >> 2) / _Cols);
+			MATRICE_STD(vector)<MATRICE_STD(string)> _Texts(_Nblocks);
+			for (size_t _Row = 0; _Row < _Rows; _Row += _Nblocks * _Block) {
+				const auto _Nb = index_t((MATRICE_STD(min))(_Nblocks, (_Rows - _Row + _Block - 1) / _Block));
+#pragma omp parallel for schedule(dynamic) if(_Nb > 1)
+				for (index_t _Idx = 0; _Idx < _Nb; ++_Idx) {
+					const auto _Row0 = _Row + size_t(_Idx) * _Block;
+					const auto _Row1 = (MATRICE_STD(min))(_Row0 + _Block, _Rows);
+					_Format_rows(_Texts[_Idx], _Data + _Row0 * _Cols, _Row1 - _Row0, _Cols, _Delm);
+				}
+				for (index_t _Idx = 0; _Idx < _Nb; ++_Idx) put(MATRICE_STD(string_view)(_Texts[_Idx]));
+			}
+		}
+	}
+
+private:
+	template<typename _Ty>
+	MATRICE_HOST_FINL auto _Format(char* _First, char* _Last, _Ty _Val) const {
+		if constexpr (MATRICE_STD(is_same_v)<_Ty, bool>)
+			return MATRICE_STD(to_chars)(_First, _Last, int(_Val));
+		else if constexpr (MATRICE_STD(is_floating_point_v)<_Ty>) {
+			if (_Myprec > 0)
+				return MATRICE_STD(to_chars)(_First, _Last, _Val, MATRICE_STD(chars_format)::general, _Myprec);
+			return MATRICE_STD(to_chars)(_First, _Last, _Val);
+		}
+		else return MATRICE_STD(to_chars)(_First, _Last, _Val);
+	}
+
+	template<typename _Ty>
+	MATRICE_HOST_INL void _Format_rows(MATRICE_STD(string)& _Text, const _Ty* _Data,
+		size_t _Rows, size_t _Cols, MATRICE_STD(string_view) _Delm) const {
+		char _Tmp[_Maxlen];
+		_Text.clear();
+		for (size_t _Idx = 0; _Idx < _Rows; ++_Idx) {
+			for (size_t _Col = 0; _Col < _Cols; ++_Col) {
+				_Text.append(_Tmp, _Format(_Tmp, _Tmp + _Maxlen, *_Data++).ptr);
+				if (_Col + 1 < _Cols) _Text.append(_Delm);
+			}
+			_Text.push_back('\n');
+		}
+	}
+
+	/**
+	 *\brief Hand the buffered text over, to the background thread if it is
+	 running, otherwise it is written here.
+	 */
+	MATRICE_HOST_INL void _Submit() {
+		if (_Mypos == 0) return;
+		if (!_Mythread.joinable()) {
+			_Write(_Mybuf.data(), _Mypos);
+			_Mypos = 0;
+			return;
+		}
+		{
+			MATRICE_STD(unique_lock)<MATRICE_STD(mutex)> _Lock(_Mymtx);
+			_Mycv.wait(_Lock, [this] { return !_Mybusy; });
+			_Rethrow();
+			MATRICE_STD(swap)(_Mybuf, _Myback);
+			_Mysize = _Mypos, _Mybusy = true;
+		}
+		_Mycv.notify_all();
+		_Mypos = 0;
+	}
+
+	MATRICE_HOST_INL void _Write(const char* _Data, size_t _Size) {
+		_Myfile.write(_Data, MATRICE_STD(streamsize)(_Size));
+		DGELOM_CHECK(_Myfile.good(), "Fail to write the CSV file.");
+	}
+
+	MATRICE_HOST_INL void _Rethrow() {
+		if (_Myexcept) {
+			auto _Except = MATRICE_STD(exchange)(_Myexcept, nullptr);
+			MATRICE_STD(rethrow_exception)(_Except);
+		}
+	}
+
+	MATRICE_HOST_INL void _Run() {
+		MATRICE_STD(unique_lock)<MATRICE_STD(mutex)> _Lock(_Mymtx);
+		for (;;) {
+			_Mycv.wait(_Lock, [this] { return _Mybusy || _Mystop; });
+			if (!_Mybusy) return;
+			_Lock.unlock();
+			auto _Except = MATRICE_STD(exception_ptr)();
+			try { _Write(_Myback.data(), _Mysize); }
+			catch (...) { _Except = MATRICE_STD(current_exception)(); }
+			_Lock.lock();
+			if (_Except && !_Myexcept) _Myexcept = _Except;
+			_Mybusy = false;
+			_Mycv.notify_all();
+		}
+	}
+
+	MATRICE_STD(ofstream) _Myfile;
+	_Mybuf_t _Mybuf, _Myback;
+	size_t _Mypos = 0, _Mysize = 0;
+	int _Myprec = 0;
+
+	MATRICE_STD(thread) _Mythread;
+	MATRICE_STD(mutex) _Mymtx;
+	MATRICE_STD(condition_variable) _Mycv;
+	MATRICE_STD(exception_ptr) _Myexcept;
+	bool _Mybusy = false, _Mystop = false;
+};
+_DETAIL_END } DGE_MATRICE_END
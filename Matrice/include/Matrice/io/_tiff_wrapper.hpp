@@ -29,8 +29,42 @@ using tiff_pointer = std::add_pointer_t<tiff_type>;
 struct image_instance;
 
 /**
- *\brief read tiff file to image_instance
+ *\brief TIFF header, 'format' is the TIFFTAG_SAMPLEFORMAT: 1 for unsigned
+         integer, 2 for signed integer and 3 for floating-point samples.
+         Signed integer samples are reported here but cannot be decoded.
+ */
+struct tiff_info {
+	uint32_t rows = 0, cols = 0;
+	uint16_t nchs = 1, bits = 8, format = 1;
+	bool tiled = false;
+};
+
+/**
+ *\brief read the header of a tiff file, which is empty if the file cannot be opened.
+ *\param [fpath] file path input.
+ */
+MATRICE_HOST_ONLY tiff_info read_tiff_info(const char* fpath);
+
+/**
+ *\brief read tiff file to image_instance, 16 and 32 bit samples are
+          narrowed to their high 8 bits.
  *\param [fpath] file path input.
  */
 MATRICE_HOST_ONLY image_instance read_tiff_file(const char* fpath);
+
+/**
+ *\brief read tiff file to a matrix of rows x (cols*nchs), where the channels
+          of a row are stored one after another. The strips (tiles) are decoded
+          in parallel and written to 'dst' directly, which is reallocated only
+          if its shape differs, so a matrix can be reused to read a sequence.
+          Integer samples are normalized to [0, 1] for floating-point
+          outputs if 'normalize' is true; integer outputs keep the high bits
+          of the samples if they are narrower.
+ *\param [fpath] file path input; [dst] output matrix.
+ *\return header of the tiff file, which is empty if the file cannot be opened.
+ */
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<uint8_t>& dst);
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<uint16_t>& dst);
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<float>& dst, bool normalize = true);
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<double>& dst, bool normalize = true);
 DGE_MATRICE_END
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../io.hpp"
 #include "util/_exception.h"
 #include "util/_std_wrapper.h"
+#include "thread/_task_pool.h"
 
 DGE_MATRICE_BEGIN namespace io { _DETAIL_BEGIN
 
@@ -202,6 +203,7 @@ public:
 	using dir_type = _Mydir_type;
 	using iterator = _Loader_iterator;
 	using data_type = Matrix<_Ty>;
+	using hook_type = std::function<void(data_type&)>;
 
 	_Data_loader_impl(const _Mydir_type& _Dir)
 		: _Mydir(_Dir) {
@@ -209,7 +211,7 @@ public:
 	}
 	template<typename _Fn>
 	_Data_loader_impl(const _Mydir_type& _Dir, _Fn&& _Op)
-		: _Mydir(_Dir), _Myloader(_Op) {
+		: _Mydir(_Dir), _Myloader(_Wrap_loader(_Op)) {
 		_Collect_fnames();
 	}
 	_Data_loader_impl(_Mydir_type&& _Dir)
@@ -219,7 +221,7 @@ public:
 	template<typename _Fn>
 	_Data_loader_impl(_Mydir_type&& _Dir, _Fn&& _Op)
 		: _Mydir(std::forward<_Mydir_type>(_Dir)),
-		_Myloader(std::forward<_Fn>(_Op)) {
+		_Myloader(_Wrap_loader(std::forward<_Fn>(_Op))) {
 		_Collect_fnames();
 	}
 
@@ -259,20 +261,29 @@ public:
 			return (*this);
 	}
 
+	/**
+	 *\brief Enable read-ahead of the next '_Depth' frames, where a frame
+	 is the current file of each subfolder (e.g. the views of a stereo rig).
+	 The frames are loaded by a pool of '_Nthreads' I/O threads (0 for auto),
+	 and the files of a frame are loaded in parallel. '_Hook' is called on
+	 every loaded matrix in the I/O threads, such as to prefilter an image.
+	 At most '_Depth' frames are held ahead of the caller, the next one is
+	 requested when forward() takes one, so a slow consumer never makes the
+	 buffer grow. Setting '_Depth' to 0 disables the read-ahead.
+	 *\note The file loader and '_Hook' are called concurrently.
+	 */
+	MATRICE_HOST_INL _Myt& prefetch(size_t _Depth, size_t _Nthreads = 0, hook_type _Hook = {}) {
+		_Myprefetch._Reset(_Depth, _Nthreads, std::move(_Hook));
+		return (*this);
+	}
+
 	/**
 	 * \brief Load current file in each of subfolders in one folder
 	 */
 	MATRICE_HOST_INL auto forward() const {
-		std::vector<data_type> _Data;
-		const auto _Size = _Mydir.size() == 0 ? 1 : _Mydir.size();
-		for (const auto& _Idx : range(0, _Size)) {
-			const auto& _Names = _Mynames[_Idx];
-#ifdef MATRICE_DEBUG
-			DGELOM_CHECK(_Mypos<_Names.size(), "file list subscript out of range.");
-#endif
-			auto _File = _Myloader(_Mydir[_Idx] + _Names[_Mypos]);
-			_Cond_push_file(_Data, _File);
-		}
+		if (_Myprefetch._Myahead != 0)
+			return _Myprefetch._Pop(*this, _Mypos++);
+		auto _Data = _Load(_Mypos);
 		_Mypos++;
 		return std::forward<decltype(_Data)>(_Data);
 	}
@@ -338,17 +349,7 @@ public:
 	 *\param [i] index of the file to be loaded
 	 */
 	MATRICE_HOST_INL auto at(size_t i) const {
-		std::vector<data_type> _Data;
-		const auto _Size = _Mydir.size()==0?1:_Mydir.size();
-		for (const auto& _Idx : range(0, _Size)) {
-			const auto& _Names = _Mynames[_Idx];
-#ifdef MATRICE_DEBUG
-			DGELOM_CHECK(i < _Names.size(), "file list subscript out of range.");
-#endif
-			auto _File = _Myloader(_Mydir[_Idx] + _Names[i]);
-			_Cond_push_file(_Data, _File);
-		}
-		return std::forward<decltype(_Data)>(_Data);
+		return _Load(i);
 	}
 
 	/**
@@ -409,6 +410,20 @@ public:
 	}
 
 private:
+	/**
+	 *\brief Loaders returning an image_instance are adapted to return the
+	 data_type, typed loaders such as io::tiff are stored as they are.
+	 */
+	template<typename _Fn>
+	static MATRICE_HOST_INL decltype(auto) _Wrap_loader(_Fn&& _Op) {
+		using file_type = remove_all_t<std::invoke_result_t<_Fn, _Mydir_type::value_type&&>>;
+		if constexpr (is_same_v<file_type, image_instance>)
+			return [_Op](_Mydir_type::value_type&& _Path) mutable {
+			return _Op(std::move(_Path)).template matrix<typename data_type::value_t>();
+		};
+		else return std::forward<_Fn>(_Op);
+	}
+
 	MATRICE_HOST_INL void _Collect_fnames() {
 		using collector_t = _Collector<file_tag>;
 		if (_Mydir.size() == 0) {//no subfolder(s)
@@ -424,6 +439,32 @@ private:
 		}
 	}
 
+	/**
+	 *\brief Load the '_Pos'-th file of each subfolder. The files are loaded
+	 in parallel on '_Pool' if given, and '_Hook' is applied to each of them.
+	 */
+	MATRICE_HOST_INL std::vector<data_type> _Load(size_t _Pos,
+		task_pool* _Pool = nullptr, const hook_type* _Hook = nullptr) const {
+		const auto _Size = _Mydir.size() == 0 ? 1 : _Mydir.size();
+		std::vector<data_type> _Files(_Size);
+		const auto _Op = [&](size_t _Idx, size_t = 0) {
+			const auto& _Names = _Mynames[_Idx];
+#ifdef MATRICE_DEBUG
+			DGELOM_CHECK(_Pos < _Names.size(), "file list subscript out of range.");
+#endif
+			_Files[_Idx] = _Myloader(_Mydir[_Idx] + _Names[_Pos]);
+			if (_Hook && *_Hook && _Files[_Idx].size()) (*_Hook)(_Files[_Idx]);
+		};
+		if (_Pool && _Size > 1) _Pool->parallel_for(_Size, 1, _Op);
+		else for (size_t _Idx = 0; _Idx < _Size; ++_Idx) _Op(_Idx);
+
+		std::vector<data_type> _Data;
+		for (auto& _File : _Files) {
+			if (_File.size()) _Data.push_back(std::move(_File));
+		}
+		return std::forward<decltype(_Data)>(_Data);
+	}
+
 	template<class _Dty, class _Fty>
 	MATRICE_HOST_INL void _Cond_push_file(_Dty& _Data, const _Fty& _File)const {
 		using file_type = remove_all_t<decltype(_File)>;
@@ -442,7 +483,77 @@ private:
 	mutable index_t _Mypos = 0;
 	index_t _Mydepth = std::numeric_limits<index_t>::max();
 	std::vector<_Mydir_type::container> _Mynames;
-	std::function<image_instance(_Mydir_type::value_type&&)> _Myloader;
+	std::function<data_type(_Mydir_type::value_type&&)> _Myloader;
+
+	/**
+	 *\brief Read-ahead queue of a loader. It holds the futures of the next
+	 '_Myahead' frames in order of position. A copy takes the settings only,
+	 its pool is started on the first forward() of the copy, since the tasks
+	 of a pool refer to the loader that started them.
+	 */
+	struct _Prefetcher {
+		using result_type = std::vector<data_type>;
+		_Prefetcher() = default;
+		_Prefetcher(const _Prefetcher& _Oth)
+			: _Myahead(_Oth._Myahead), _Mynthreads(_Oth._Mynthreads),
+			_Myhook(_Oth._Myhook) {}
+		_Prefetcher& operator=(const _Prefetcher& _Oth) {
+			if (this != &_Oth) _Reset(_Oth._Myahead, _Oth._Mynthreads, _Oth._Myhook);
+			return (*this);
+		}
+		~_Prefetcher() { _Stop(); }
+
+		MATRICE_HOST_INL void _Reset(size_t _Ahead, size_t _Nthreads, hook_type _Hook) {
+			_Stop();
+			_Myahead = _Ahead, _Mynthreads = _Nthreads;
+			_Myhook = std::move(_Hook);
+		}
+
+		/**
+		 *\brief Take the frame at '_Pos' and request the frames after it.
+		 The queue is refilled from '_Pos' if the caller has moved the loader.
+		 */
+		MATRICE_HOST_INL result_type _Pop(const _Myt& _Loader, index_t _Pos) {
+			if (_Pos < 0 || _Pos >= _Loader._Mydepth) return result_type{};
+			if (!_Mypool) {
+				_Mycancel = false;
+				_Mypool = std::make_unique<task_pool>(_Mynthreads);
+			}
+			if (_Myqueue.empty() || _Myqueue.front().first != _Pos) {
+				_Myqueue.clear();
+				_Mynext = _Pos;
+			}
+			const auto _Pool = _Mypool.get();
+			while (_Myqueue.size() <= _Myahead && _Mynext < _Loader._Mydepth) {
+				const auto _Next = _Mynext++;
+				_Myqueue.emplace_back(_Next, _Pool->async([this, &_Loader, _Pool, _Next] {
+					if (_Mycancel) return result_type{};
+					return _Loader._Load(_Next, _Pool, &_Myhook);
+				}));
+			}
+			auto _Future = std::move(_Myqueue.front().second);
+			_Myqueue.pop_front();
+			return _Future.get();
+		}
+
+		/**
+		 *\brief Drop the pending frames and join the I/O threads.
+		 */
+		MATRICE_HOST_INL void _Stop() {
+			_Mycancel = true;
+			_Myqueue.clear();
+			_Mypool.reset();
+		}
+
+		size_t _Myahead = 0, _Mynthreads = 0;
+		hook_type _Myhook;
+		index_t _Mynext = 0;
+		std::atomic<bool> _Mycancel{ false };
+		std::deque<std::pair<index_t, std::future<result_type>>> _Myqueue;
+		std::unique_ptr<task_pool> _Mypool;
+	};
+	// \declared last to join the I/O threads before the other fields are destroyed
+	mutable _Prefetcher _Myprefetch;
 };
 
 template<typename _Ty>
@@ -450,11 +561,21 @@ struct _Loader_impl<_Ty, loader_tag::tiff> {
 	using value_type = _Ty;
 	using category = loader_tag::tiff;
 
-	MATRICE_HOST_INL image_instance operator()(std::string path) {
-		if( string_helper::split(path, '.').back() == "tif" ||
-			string_helper::split(path, '.').back() == "tiff" )
-			return read_tiff_file(path.c_str());
-		else return image_instance{};
+	/**
+	 *\brief Decode a tiff file into Matrix<value_type>. The file is read to
+	 the matrix directly for uint8_t, uint16_t, float and double, and via an
+	 image_instance for other types.
+	 */
+	MATRICE_HOST_INL Matrix<value_type> operator()(std::string path) {
+		Matrix<value_type> _Ret;
+		const auto _Ext = string_helper::split(path, '.').back();
+		if (_Ext == "tif" || _Ext == "tiff") {
+			if constexpr (is_any_of_v<value_type, uint8_t, uint16_t, float, double>)
+				read_tiff_file(path.c_str(), _Ret);
+			else
+				_Ret = read_tiff_file(path.c_str()).template matrix<value_type>();
+		}
+		return forward<decltype(_Ret)>(_Ret);
 	}
 };
 _DETAIL_END } DGE_MATRICE_END
\ No newline at end of file
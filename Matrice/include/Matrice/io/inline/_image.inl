@@ -98,6 +98,20 @@ MATRICE_HOST_INL auto _Imread(const char* path, uint8_t) {
 	}
 }
 
+MATRICE_HOST_INL auto _Imread(const char* path, uint16_t) {
+	const auto fmt = _Get_image_fmt(path);
+
+#ifdef MATRICE_DEBUG
+	DGELOM_CHECK(fmt.size() == 3, "Unsupported image format.");
+#endif // MATRICE_DEBUG
+
+	Matrix<uint16_t> img;
+	if (fmt == "tif" || fmt == "iff") {
+		read_tiff_file(path, img);
+	}
+	return forward<decltype(img)>(img);
+}
+
 MATRICE_HOST_INL auto _Imread(const char* path, float) {
 	const auto fmt = _Get_image_fmt(path);
 
@@ -105,9 +119,11 @@ MATRICE_HOST_INL auto _Imread(const char* path, float) {
 	DGELOM_CHECK(fmt.size() == 3, "Unsupported image format.");
 #endif // MATRICE_DEBUG
 
-	if (fmt == "tif") {
-		return read_tiff_file(path);
+	Matrix<float> img;
+	if (fmt == "tif" || fmt == "iff") {
+		read_tiff_file(path, img);
 	}
+	return forward<decltype(img)>(img);
 }
 
 MATRICE_HOST_INL auto _Imread(const char* path, double) {
@@ -117,9 +133,11 @@ MATRICE_HOST_INL auto _Imread(const char* path, double) {
 	DGELOM_CHECK(fmt.size() == 3, "Unsupported image format.");
 #endif // MATRICE_DEBUG
 
-	if (fmt == "tif") {
-		return read_tiff_file(path);
+	Matrix<double> img;
+	if (fmt == "tif" || fmt == "iff") {
+		read_tiff_file(path, img);
 	}
+	return forward<decltype(img)>(img);
 }
 
 _DETAIL_END
@@ -41,6 +41,8 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include "private/_range.h"
 #include "_dir.hpp"
 #include "text_loader.hpp"
+#include "_csv_parser.hpp"
+#include "_csv_writer.hpp"
 
 DGE_MATRICE_BEGIN
 /**
@@ -142,7 +144,8 @@ public:
 	};
 
 	/**
-	 * \csv writer
+	 * \csv writer, values are formatted with std::to_chars into a large
+	 * buffer, which can be written by a background thread, see async().
 	 */
 	class CSV {
 	public:
@@ -161,15 +164,34 @@ public:
 			return (*this);
 		}
 
+		/// <summary>
+		/// \brief Set significant digits of floating point values. The 
+		/// shortest text that reads back exactly is written by default.
+		/// </summary>
+		MATRICE_HOST_FINL CSV& precision(int _Digits) noexcept {
+			_My_file.precision(_Digits);
+			return (*this);
+		}
+		/// <summary>
+		/// \brief Write the file with a background thread, while the caller
+		/// keeps appending lines. It takes effect on the next open().
+		/// </summary>
+		MATRICE_HOST_FINL CSV& async(bool _On = true) noexcept {
+			_My_async = _On;
+			return (*this);
+		}
+
+		/// <summary>
+		/// \brief Open the file, which is appended if '_Mode' has 'app',
+		/// otherwise truncated. Missing parent folders are created.
+		/// </summary>
 		MATRICE_HOST_FINL void open(int _Mode) {
-			if (_Mode & out || _Mode & app) {
-				if (!fs::exists(_Mypath.parent_path())) {
-					fs::create_directories(_Mypath.parent_path());
-				}
-			}
-			_My_file.open(_Mypath.string(), _Mode);
+			_My_file.open(_Mypath, (_Mode & app) != 0, _My_async);
 		}
-		MATRICE_HOST_FINL void close() noexcept {
+		MATRICE_HOST_FINL void flush() {
+			_My_file.flush();
+		}
+		MATRICE_HOST_FINL void close() {
 			_My_file.close(); 
 		}
 
@@ -182,12 +204,7 @@ public:
 		/// <returns>Current line number.</returns>
 		template<typename _It> 
 		MATRICE_HOST_INL size_t append(_It _First, _It _Last) {
-			for (; _First != _Last;) {
-				_My_file << *_First;
-				if (++_First != _Last) 
-					_My_file << _My_delimeter;
-			}
-			_My_file << "\n";
+			_My_file.line(_First, _Last, _My_delimeter);
 
 			return (_My_linecnt++);
 		}
@@ -202,22 +219,30 @@ public:
 		/// <returns>Current line number.</returns>
 		template<typename _It>
 		MATRICE_HOST_INL size_t append(std::string&& _Label, _It _First, _It _Last) {
-			_My_file << _Label << _My_delimeter;
-			for (; _First != _Last;) {
-				_My_file << *_First;
-				if (++_First != _Last)
-					_My_file << _My_delimeter;
-			}
-			_My_file << "\n";
+			_My_file.put(_Label), _My_file.put(_My_delimeter);
+			_My_file.line(_First, _Last, _My_delimeter);
 
 			return (_My_linecnt++);
 		}
 
 		MATRICE_HOST_INL size_t append(std::string&& _Label) {
-			_My_file << _Label << "\n";
+			_My_file.put(_Label), _My_file.put(std::string_view("\n"));
 			return (_My_linecnt++);
 		}
 
+		/// <summary>
+		/// \brief Add all rows of a matrix in one call, large matrices are 
+		/// formatted in parallel.
+		/// </summary>
+		/// <typeparam name="_Mty">Matrix type</typeparam>
+		/// <returns>Line number of the first row.</returns>
+		template<typename _Mty, MATRICE_ENABLE_IF(is_matrix_v<_Mty>)>
+		MATRICE_HOST_INL size_t write(const _Mty& _Data) {
+			_My_file.lines(_Data.data(), _Data.rows(), _Data.cols(), _My_delimeter);
+
+			return (_My_linecnt += _Data.rows()) - _Data.rows();
+		}
+
 		/// <summary>
 		/// \brief Get count of lines written. 
 		/// </summary>
@@ -230,7 +255,8 @@ public:
 		fs::path _Mypath;
 		std::string _My_delimeter = ",";
 		std::size_t _My_linecnt = 0;
-		std::fstream _My_file;
+		bool _My_async = false;
+		io::detail::_Csv_writer _My_file;
 	};
 
 	IO() noexcept {};
@@ -292,34 +318,17 @@ public:
 		static_assert(_N0 <= _N1, "_N1 must be greater than or equal to _N0");
 		using value_type = _Ty;
 		DGELOM_CHECK(fs::exists(fs::path(_Path)),"'"+_Path+"' does not exist!");
-		std::ifstream _Fin(_Path);
-		DGELOM_CHECK(_Fin.is_open(),"Cannot open file in "+_Path);
 
-		std::string _Line;
-		for (const auto _Idx : range(0, _Skips)) {
-			std::getline(_Fin, _Line);
-		}
-		
 		if constexpr (_N1 - _N0 > 1) {
-			std::array<value_type, -~(_N1 - _N0)> _Myline;
-			std::vector<decltype(_Myline)> _Data;
-			while (std::getline(_Fin, _Line)) {
-				const auto _Res = split<value_type>(_Line, ',');
-				if (_Res.size() >= _N1-1) {
-					for (auto _Idx = ~- _N0; _Idx < _N1; ++_Idx) {
-						_Myline[-~(_Idx - _N0)] = _Res[_Idx];
-					}
-					_Data.push_back(_Myline);
-				}
-			}
+			const auto _Res = io::detail::_Csv_reader<value_type>(_Path, _Skips).read(_N0 - 1, _N1);
+			std::vector<std::array<value_type, -~(_N1 - _N0)>> _Data(_Res.rows());
+			if (!_Data.empty())
+				std::copy(_Res.data(), _Res.data() + _Res.size(), _Data.front().data());
 			return forward<decltype(_Data)>(_Data);
 		}
 		else {
-			std::vector<value_type> _Data;
-			while (std::getline(_Fin, _Line)) {
-				auto _Res = split<value_type>(_Line, ',');
-				_Data.push_back(_Res[_N0-1]);
-			}
+			const auto _Res = io::detail::_Csv_reader<value_type>(_Path, _Skips).read(_N0 - 1, _N0);
+			std::vector<value_type> _Data(_Res.data(), _Res.data() + _Res.size());
 			return forward<decltype(_Data)>(_Data);
 		}
 	}
@@ -338,25 +347,8 @@ public:
 		using value_type = _Ty;
 		DGELOM_CHECK(fs::exists(fs::path(_Path)), 
 			"'" + _Path + "' does not exist!");
-		std::ifstream _Fin(_Path);
-		DGELOM_CHECK(_Fin.is_open(), 
-			"Cannot open file in " + _Path);
-
-		std::string _Line;
-		for (const auto _Idx : range(0, _Skips)) {
-			std::getline(_Fin, _Line);
-		}
-		std::vector<std::vector<value_type>> _Data;
-		while (std::getline(_Fin, _Line)) {
-			if(!_Line.empty())
-				_Data.push_back(split<value_type>(_Line, ','));
-		}
-
-		Matrix<value_type> _Res(_Data.size(),_Data.front().size());
-		for (const auto& _Idx : range(0, _Res.rows())) {
-			_Res.rview(_Idx) = _Data[_Idx].data();
-		}
 
+		auto _Res = io::detail::_Csv_reader<value_type>(_Path, _Skips).read();
 		return forward<decltype(_Res)>(_Res);
 	}
 	template<typename _Ty>
@@ -364,6 +356,21 @@ public:
 		return read<_Ty>(_Path.string(), _Skips);
 	}
 
+	/**
+	 *\brief Read a numeric text file block by block, for a file that does not
+	 fit in memory. '_Op(block, row)' is called for each block with a matrix of
+	 its rows and the index of its first row in the file.
+	 *\param '_Path' refers to the location of target file.
+     *\param '_Skips' indicates how many lines to skip over.
+	 *\return Number of rows of the file.
+	 */
+	template<typename _Ty, typename _Op>
+	static MATRICE_HOST_INL size_t read_blocks(const std::string& _Path, _Op&& _Op_block, size_t _Skips = 0) {
+		DGELOM_CHECK(fs::exists(fs::path(_Path)),
+			"'" + _Path + "' does not exist!");
+		return io::detail::_Csv_reader<_Ty>(_Path, _Skips).read_blocks(std::forward<_Op>(_Op_block));
+	}
+
 	/**
 	 *\brief Single-stream writter to output data to a file in '_path'.
 	 */
@@ -601,9 +608,7 @@ template<fmt _Fmt> void _Save(const auto& _Data, path_t _Path) {
 	IO::CSV csv(_Path);
 	csv.open(IO::out);
 	if constexpr (is_matrix_v<remove_all_t<decltype(_Data)>>) {
-		for (auto _It = _Data.rwbegin(); _It < _Data.rwend(); ++_It) {
-			csv.append(_It.begin(), _It.end());
-		}
+		csv.write(_Data);
 	}
 	csv.close();
 }
@@ -613,6 +618,8 @@ _DETAIL_END
 /**
  *\brief <func> imread: read image file </func>
  *\param [path] the path of the image to be read.
+ *\return image_instance for uint8_t, otherwise Matrix<_Ty> decoded directly,
+          where float and double images are normalized to [0, 1].
  */
 template<typename _Ty = uint8_t, class _Pth = std::string> 
 MATRICE_HOST_INL auto imread(const _Pth path);
@@ -18,16 +18,24 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include <functional>
 #include <cassert>
+#include <cstdint>
 #include "_shape.hpp"
 #include "_type_traits.h"
 #include "_size_traits.h"
 #include "_tag_defs.h"
 #include "forward.hpp"
 #include "math/_primitive_funcs.hpp"
+#include "math/_gemm_kernel.hpp"
+#include "math/_small_linear_kernel.hpp"
 #if defined(MATRICE_SIMD_ARCH)
 #include "arch/simd.h"
 #endif
 
+// \brief Minimal size of an expression evaluated or reduced in parallel.
+#ifndef MATRICE_EWISE_PARALLEL_THRESHOLD
+#define MATRICE_EWISE_PARALLEL_THRESHOLD 32768
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4715 4661 4224 4267 4244 4819 4199 26495)
@@ -69,6 +77,18 @@ struct is_matrix<detail::Base_<_Derived, _Traits, _Ty>> : std::true_type {};
 template<typename _Ty, size_t _Depth>
 struct is_tensor<detail::_Tensor<_Ty, _Depth>> : std::true_type {};
 
+/**
+ *\brief is_vectorizable_v<T> is true iff T can be evaluated by SIMD packets, 
+ i.e. T is a scalar, a plain matrix or an expression (operator) with 'vectorizable' set.
+ */
+template<typename T, typename = void>
+struct is_vectorizable : MATRICE_STD(bool_constant)<is_scalar_v<T> || is_matrix_v<T>> {};
+template<typename T>
+struct is_vectorizable<T, MATRICE_STD(void_t)<decltype(T::vectorizable)>> 
+	: MATRICE_STD(bool_constant)<bool(T::vectorizable)> {};
+template<typename T>
+inline constexpr bool is_vectorizable_v = is_vectorizable<remove_all_t<T>>::value;
+
 template<class _Derived, class _Traits, typename _Ty>
 struct matrix_traits<detail::Base_<_Derived, _Traits, _Ty>> {
 	using type = remove_all_t<_Ty>;
@@ -125,6 +145,19 @@ template<typename _Ty> struct _Ewise_##NAME { \
 		return (NAME(_Left, _Right)); \
 	}\
 };
+#define MATRICE_MAKE_EWISE_ARITH_BIOP(NAME, OP) \
+template<typename _Ty> struct _Ewise_##NAME { \
+	enum {flag = ewise, vectorizable = 1}; \
+	using category = tag::_Ewise_##NAME##_tag; \
+	template<typename _Uy = _Ty> \
+	MATRICE_GLOBAL_FINL constexpr auto operator() (const _Ty& _Left, const _Uy& _Right) const {\
+		return (NAME(_Left, _Right)); \
+	}\
+	template<typename _Pkt> \
+	MATRICE_HOST_FINL _Pkt packet(const _Pkt& _Left, const _Pkt& _Right) const {\
+		return (_Left OP _Right); \
+	}\
+};
 #define MATRICE_MAKE_ARITH_OP(OP, NAME) \
 template<typename _Rhs, MATRICE_ENABLE_IF(std::true_type::value)> \
 MATRICE_GLOBAL_FINL auto operator OP(const _Rhs& _Right) { \
@@ -161,10 +194,10 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 	 * \expression operators
 	 */
 	struct Op {
-		MATRICE_MAKE_EWISE_BIOP(add);
-		MATRICE_MAKE_EWISE_BIOP(sub);
-		MATRICE_MAKE_EWISE_BIOP(mul);
-		MATRICE_MAKE_EWISE_BIOP(div);
+		MATRICE_MAKE_EWISE_ARITH_BIOP(add, +);
+		MATRICE_MAKE_EWISE_ARITH_BIOP(sub, -);
+		MATRICE_MAKE_EWISE_ARITH_BIOP(mul, *);
+		MATRICE_MAKE_EWISE_ARITH_BIOP(div, /);
 		MATRICE_MAKE_EWISE_BIOP(max);
 		MATRICE_MAKE_EWISE_BIOP(min);
 		MATRICE_MAKE_EWISE_UNOP(sqrt);
@@ -276,6 +309,37 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		};
 	};
 
+	/**
+	 * \check if operand '_Ty' can be loaded as packets of '_Valty'
+	 */
+	template<typename _Ty, typename _Valty>
+	static constexpr bool _Is_packable() noexcept {
+		if constexpr (is_scalar_v<_Ty>) return true;
+		else if constexpr (is_vectorizable_v<_Ty>)
+			return is_same_v<typename _Ty::value_type, _Valty>;
+		else return false;
+	}
+	/**
+	 * \check if operand '_Opd' has no spreaded sub-expression at runtime
+	 */
+	template<typename _Ty>
+	static MATRICE_HOST_FINL bool _Is_fusable(const _Ty& _Opd) noexcept {
+		if constexpr (is_scalar_v<_Ty> || is_matrix_v<_Ty>) return true;
+		else return _Opd.fusable();
+	}
+	/**
+	 * \load the packet of operand '_Opd' starting at the '_Idx'-th entry
+	 */
+	template<typename _Pkt, typename _Ty>
+	static MATRICE_HOST_FINL _Pkt _Packet_of(const _Ty& _Opd, size_t _Idx) noexcept {
+		using pointer = typename _Pkt::pointer;
+		if constexpr (is_scalar_v<_Ty>) 
+			return _Pkt(typename _Pkt::value_t(_Opd));
+		else if constexpr (is_matrix_v<_Ty>)
+			return _Pkt(const_cast<pointer>(_Opd.data()) + _Idx);
+		else return _Opd.template packet<_Pkt>(_Idx);
+	}
+
 	/**
 	 * \expression base class
 	 */
@@ -403,15 +467,7 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		 * \sum over all expression entries
 		 */
 		MATRICE_GLOBAL_INL auto sum() const noexcept {
-			auto _Ret = value_t(0); 
-			int _Size = derived_pointer(this)->size();
-#pragma omp parallel if(_Size > 1000)
-		{
-#pragma omp for reduction(+:_Ret)
-			for (int i = 0; i < _Size; ++i) 
-				_Ret += derived_pointer(this)->operator()(i);
-		}
-			return (_Ret);
+			return _Reduce([](const auto& _Val) { return _Val; });
 		}
 		/**
 		 * \average of all entries
@@ -424,9 +480,28 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		 */
 		MATRICE_GLOBAL_INL auto var() const noexcept {
 			const auto _Avg = this->avg();
-			const auto _Diff = Exp::EwiseBinaryExp< derived_t, decltype(_Avg),
-				Exp::Op::_Ewise_sub<value_t>>( *static_cast<const derived_t*>(this), _Avg);
-			return (_Diff * _Diff).avg();
+			return _Reduce([_Avg](const auto& _Val) { 
+				const auto _Diff = _Val - _Avg;
+				return _Diff * _Diff; 
+			}) / _CDTHIS->size();
+		}
+		/**
+		 * \1-norm (_P = 1) or Frobenius norm (_P = 2) of all entries
+		 */
+		template<size_t _P = 2>
+		MATRICE_GLOBAL_INL auto norm() const noexcept {
+			static_assert(_P == 1 || _P == 2, "Only 1-norm and 2-norm are supported.");
+			if constexpr (_P == 1) {
+				return _Reduce([](const auto& _Val) {
+					if constexpr (is_scalar_v<decltype(_Val)>) return abs(_Val);
+					else return _Val.abs();
+				});
+			}
+			else {
+				return MATRICE_STD(sqrt)(_Reduce([](const auto& _Val) { 
+					return _Val * _Val; 
+				}));
+			}
 		}
 
 		/**
@@ -480,6 +555,89 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		MATRICE_MAKE_ARITH_OP(/, div);
 
 	protected:
+		/**
+		 *\brief Evaluate the expression into '_Res' in a single fused loop. 
+		 If the expression tree is vectorizable, each thread runs unaligned 
+		 packets over a block of entries, where the tail shorter than a packet
+		 is evaluated by scalars.
+		 */
+		template<typename _Mty>
+		MATRICE_HOST_INL void _Fused_assign(_Mty& _Res) const noexcept {
+			const auto _Size = index_t(_Res.size());
+#ifdef MATRICE_SIMD_ARCH
+			if constexpr (_Is_packable<derived_t, value_t>() && 
+				is_matrix_v<_Mty> && MATRICE_STD(is_floating_point_v)<value_t>) {
+				if (_Is_fusable(*_CDTHIS) && _Size == index_t(size())) {
+					using packet_type = simd::Packet_<value_t>;
+					constexpr index_t _Step = packet_type::size;
+					const auto _Dst = _Res.data();
+					const auto _Nblks = (_Size + _Block - 1) / _Block;
+#pragma omp parallel for if(_Size > MATRICE_EWISE_PARALLEL_THRESHOLD)
+					for (index_t _B = 0; _B < _Nblks; ++_B) {
+						auto i = _B * _Block;
+						const auto _End = (MATRICE_STD(min))(i + _Block, _Size);
+						for (; i + _Step <= _End; i += _Step)
+							_CDTHIS->template packet<packet_type>(i).unpack(_Dst + i);
+						for (; i < _End; ++i)
+							_Dst[i] = _CDTHIS->operator()(i);
+					}
+					return;
+				}
+			}
+#endif
+#pragma omp parallel for if(_Size > MATRICE_EWISE_PARALLEL_THRESHOLD)
+			for (index_t i = 0; i < _Size; ++i)
+				_Res(i) = _CDTHIS->operator()(i);
+		}
+
+		/**
+		 *\brief Accumulate '_Func(x)' over all entries in a single fused pass,
+		 '_Func' must accept both scalars and packets if the expression is 
+		 vectorizable. Partial sums of blocks are accumulated in double for 
+		 floating-point expressions.
+		 */
+		template<typename _Fn>
+		MATRICE_HOST_INL value_t _Reduce(_Fn&& _Func) const noexcept {
+			using accum_t = conditional_t<MATRICE_STD(is_floating_point_v)<value_t>, double, value_t>;
+			const auto _Size = index_t(size());
+			const auto _Nblks = (_Size + _Block - 1) / _Block;
+			accum_t _Ret = accum_t(0);
+#ifdef MATRICE_SIMD_ARCH
+			if constexpr (_Is_packable<derived_t, value_t>() &&
+				MATRICE_STD(is_floating_point_v)<value_t>) {
+				if (_Is_fusable(*_CDTHIS)) {
+					using packet_type = simd::Packet_<value_t>;
+					constexpr index_t _Step = packet_type::size;
+#pragma omp parallel for reduction(+:_Ret) if(_Size > MATRICE_EWISE_PARALLEL_THRESHOLD)
+					for (index_t _B = 0; _B < _Nblks; ++_B) {
+						auto i = _B * _Block;
+						const auto _End = (MATRICE_STD(min))(i + _Block, _Size);
+						packet_type _Acc(value_t(0));
+						for (; i + _Step <= _End; i += _Step)
+							_Acc = _Acc + _Func(_CDTHIS->template packet<packet_type>(i));
+						accum_t _Part = _Acc.reduce();
+						for (; i < _End; ++i) 
+							_Part += _Func(_CDTHIS->operator()(i));
+						_Ret += _Part;
+					}
+					return value_t(_Ret);
+				}
+			}
+#endif
+#pragma omp parallel for reduction(+:_Ret) if(_Size > MATRICE_EWISE_PARALLEL_THRESHOLD)
+			for (index_t _B = 0; _B < _Nblks; ++_B) {
+				const auto _End = (MATRICE_STD(min))(_B * _Block + _Block, _Size);
+				accum_t _Part = accum_t(0);
+				for (auto i = _B * _Block; i < _End; ++i)
+					_Part += _Func(_CDTHIS->operator()(i));
+				_Ret += _Part;
+			}
+			return value_t(_Ret);
+		}
+
+		// \entries per block of the fused loops
+		static constexpr index_t _Block = 4096;
+
 		size_t M, K, N;
 		shape_t<3> Shape;
 #undef _CDTHIS
@@ -502,7 +660,9 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		using typename _Mybase::eval_type;
 		using _Mybase::operator();
 		using category = category_type_t<_BinaryOp>;
-		enum { options = option<ewise>::value };
+		enum { options = option<ewise>::value, 
+			vectorizable = is_vectorizable_v<_BinaryOp> && 
+			_Is_packable<T, value_t>() && _Is_packable<U, value_t>() };
 
 		MATRICE_GLOBAL_INL EwiseBinaryExp(const T& _lhs, const U& _rhs)
 		 :_Mybase(detail::_Union(_lhs.shape(),_rhs.shape())),
@@ -514,17 +674,24 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		MATRICE_GLOBAL_FINL auto operator()(size_t _idx) const noexcept{
 			return _Op(_LHS(_idx), _RHS(_idx));
 		}
+		template<typename _Pkt>
+		MATRICE_HOST_FINL _Pkt packet(size_t _idx) const noexcept {
+			return _Op.packet(_Packet_of<_Pkt>(_LHS, _idx), _Packet_of<_Pkt>(_RHS, _idx));
+		}
+		MATRICE_HOST_FINL bool fusable() const noexcept {
+			return _LHS.size() == _RHS.size() && 
+				_Is_fusable(_LHS) && _Is_fusable(_RHS);
+		}
 
 		template<typename _Mty> 
 		MATRICE_GLOBAL_FINL void assign_to(_Mty& _Res) const noexcept{
 			if (_LHS.size() == _RHS.size()) { //element-wise operation
-//#pragma omp parallel for if(_Res.size() > 100)
-				for (index_t i = 0; i < _Res.size(); ++i)
-					_Res(i) = this->operator()(i);
+				_Mybase::_Fused_assign(_Res);
 			}
 			else { //spreaded element-wise operation
-//#pragma omp parallel for if(_Res.size() > 100)
-				for (index_t i = 0; i < _Res.size(); ++i)
+				const index_t _Size = _Res.size();
+#pragma omp parallel for if(_Size > MATRICE_EWISE_PARALLEL_THRESHOLD)
+				for (index_t i = 0; i < _Size; ++i)
 					_Res(i) = _Op(_LHS(i/_Mybase::cols()), _RHS(i));
 			}
 		}
@@ -552,7 +719,8 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		using typename _Mybase::eval_type;
 		using _Mybase::operator();
 		using category = category_type_t<_BinaryOp>;
-		enum { options = option<ewise>::value };
+		enum { options = option<ewise>::value,
+			vectorizable = is_vectorizable_v<_BinaryOp> && _Is_packable<U, value_t>() };
 
 		MATRICE_GLOBAL_INL EwiseBinaryExp(const T _scalar, const U& _rhs)
 			noexcept :_Mybase(_rhs.shape()), _Scalar(_scalar), _RHS(_rhs) {}
@@ -563,12 +731,17 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		MATRICE_GLOBAL_FINL value_t operator()(size_t _idx) const noexcept {
 			return _Op(_Scalar, _RHS(_idx));
 		}
+		template<typename _Pkt>
+		MATRICE_HOST_FINL _Pkt packet(size_t _idx) const noexcept {
+			return _Op.packet(_Pkt(_Scalar), _Packet_of<_Pkt>(_RHS, _idx));
+		}
+		MATRICE_HOST_FINL bool fusable() const noexcept {
+			return _Is_fusable(_RHS);
+		}
 
 		template<typename _Mty> 
 		MATRICE_GLOBAL_INL void assign_to(_Mty& res) const noexcept {
-//#pragma omp parallel for
-			for (index_t i = 0; i < res.size(); ++i) 
-				res(i) = this->operator()(i);
+			_Mybase::_Fused_assign(res);
 		}
 
 		// Added at May/6/2022
@@ -595,7 +768,8 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		using typename _Mybase::eval_type;
 		using _Mybase::operator();
 		using category = category_type_t<_BinaryOp>;
-		enum { options = option<ewise>::value };
+		enum { options = option<ewise>::value,
+			vectorizable = is_vectorizable_v<_BinaryOp> && _Is_packable<T, value_t>() };
 
 		MATRICE_GLOBAL_INL EwiseBinaryExp(const T& _lhs, const U _scalar)
 			noexcept :_Mybase(_lhs.shape()), _Scalar(_scalar), _LHS(_lhs) {
@@ -607,12 +781,17 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		MATRICE_GLOBAL_FINL auto operator()(size_t _idx) const noexcept {
 			return _Op(_LHS(_idx), _Scalar);
 		}
+		template<typename _Pkt>
+		MATRICE_HOST_FINL _Pkt packet(size_t _idx) const noexcept {
+			return _Op.packet(_Packet_of<_Pkt>(_LHS, _idx), _Pkt(_Scalar));
+		}
+		MATRICE_HOST_FINL bool fusable() const noexcept {
+			return _Is_fusable(_LHS);
+		}
 
 		template<typename _Mty> 
 		MATRICE_GLOBAL_INL void assign_to(_Mty& res) const noexcept {
-//#pragma omp parallel for
-			for (index_t i = 0; i < res.size(); ++i) 
-				res(i) = this->operator()(i);
+			_Mybase::_Fused_assign(res);
 		}
 
 		// \returns Shape of the evaluated type. Added at May/6/2022
@@ -654,8 +833,7 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 
 		template<typename _Mty> 
 		MATRICE_GLOBAL_FINL void assign_to(_Mty& res) const noexcept {
-			for (index_t i = 0; i < res.size(); ++i) 
-				res(i) = this->operator()(i);
+			_Mybase::_Fused_assign(res);
 		}
 
 		/**
@@ -721,6 +899,17 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 			for (int i = 0; i < res.size(); ++i)
 				res(i) = this->operator()(i);
 #else
+			if constexpr (is_same_v<_BinaryOp, Op::_Mat_mul<value_t>> &&
+				is_matrix_v<T> && is_matrix_v<U> && is_matrix_v<_Mty> &&
+				MATRICE_STD(is_floating_point_v)<value_t>) {
+				// \packed GEMM for large products of plain matrices
+				if (K == _RHS.rows() && size_t(res.size()) == size_t(M) * N &&
+					size_t(M) * N * K >= MATRICE_GEMM_THRESHOLD) {
+					detail::_Gemm_kernel<value_t>::eval(M, N, K,
+						_LHS.data(), K, _RHS.data(), N, res.data(), N);
+					return;
+				}
+			}
 			for (int i = 0; i < res.size(); ++i) 
 				res(i) = this->operator()(i);
 #endif
@@ -804,7 +993,14 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 		template<typename _Mty>
 		MATRICE_GLOBAL_INL void assign_to(_Mty& res) noexcept {
 			if constexpr (options == inv) {
-				_Op(M, res.data(), _RHS.data());
+				if constexpr (detail::is_small_square_v<T> &&
+					MATRICE_STD(is_floating_point_v)<value_t>) {
+					detail::_Small_linear_kernel<value_t, 
+						size_t(T::rows_at_compiletime)>::inv(_RHS.data(), res.data());
+				}
+				else {
+					_Op(M, res.data(), _RHS.data());
+				}
 			}
 			if constexpr (options == trp) {
 				const int _Size = this->size();
@@ -850,6 +1046,7 @@ MATRICE_GLOBAL_FINL auto operator OP(const _Lhs& _Left, const_derived& _Right) {
 #undef MATRICE_MAKE_ARITH_OP
 #undef MATRICE_MAKE_EWISE_UNOP
 #undef MATRICE_MAKE_EWISE_BIOP
+#undef MATRICE_MAKE_EWISE_ARITH_BIOP
 };
 
 template<typename _Exp, MATRICE_ENABLE_IF(is_expression_v<_Exp>)>
@@ -0,0 +1,599 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#pragma once
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include "util/_exception.h"
+#include "_ad_utils.h"
+
+DGE_MATRICE_BEGIN
+namespace ade {
+template<typename _Ty> class tape;
+template<typename _Ty> class tape_mat;
+
+// \brief Codes of the statements recorded on a tape.
+enum class _Tape_op : uint8_t { scalar, add, sub, mul, scale, matmul, dot, sum };
+
+/// <summary>
+/// \brief Scalar node of a reverse-mode tape, which is a light handle to
+/// a slot of the tape arena. Operations on nodes are evaluated eagerly
+/// and recorded on the tape they belong to.
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+template<typename _Ty>
+class tape_var {
+	using _Myt = tape_var;
+	friend class tape<_Ty>;
+	friend class tape_mat<_Ty>;
+public:
+	using value_type = _Ty;
+	using tape_type = tape<value_type>;
+
+	MATRICE_HOST_INL tape_var() noexcept = default;
+
+	/**
+	 *\brief Value of the node, which may be set for a leaf node before
+	         the operations depending on it are recorded.
+	 */
+	MATRICE_HOST_INL decltype(auto) value() const noexcept {
+		return (_Mytape->_Myvals[_Myidx]);
+	}
+	MATRICE_HOST_INL decltype(auto) value() noexcept {
+		return (_Mytape->_Myvals[_Myidx]);
+	}
+	/**
+	 *\brief Adjoint of the node, filled by tape::backward().
+	 */
+	MATRICE_HOST_INL decltype(auto) grad() const noexcept {
+		return (_Mytape->_Myadjs[_Myidx]);
+	}
+	MATRICE_HOST_INL size_t index() const noexcept {
+		return (_Myidx);
+	}
+
+	MATRICE_HOST_INL friend _Myt operator+(const _Myt& x, const _Myt& y) {
+		return x._Binary(x.value() + y.value(), 1, y, 1);
+	}
+	MATRICE_HOST_INL friend _Myt operator-(const _Myt& x, const _Myt& y) {
+		return x._Binary(x.value() - y.value(), 1, y, -1);
+	}
+	MATRICE_HOST_INL friend _Myt operator*(const _Myt& x, const _Myt& y) {
+		return x._Binary(x.value() * y.value(), y.value(), y, x.value());
+	}
+	MATRICE_HOST_INL friend _Myt operator/(const _Myt& x, const _Myt& y) {
+		const auto _Inv = value_type(1) / y.value();
+		const auto _Val = x.value() * _Inv;
+		return x._Binary(_Val, _Inv, y, -_Val * _Inv);
+	}
+	MATRICE_HOST_INL friend _Myt operator+(const _Myt& x, value_type s) {
+		return x._Unary(x.value() + s, 1);
+	}
+	MATRICE_HOST_INL friend _Myt operator+(value_type s, const _Myt& x) {
+		return x + s;
+	}
+	MATRICE_HOST_INL friend _Myt operator-(const _Myt& x, value_type s) {
+		return x._Unary(x.value() - s, 1);
+	}
+	MATRICE_HOST_INL friend _Myt operator-(value_type s, const _Myt& x) {
+		return x._Unary(s - x.value(), -1);
+	}
+	MATRICE_HOST_INL friend _Myt operator*(const _Myt& x, value_type s) {
+		return x._Unary(x.value() * s, s);
+	}
+	MATRICE_HOST_INL friend _Myt operator*(value_type s, const _Myt& x) {
+		return x * s;
+	}
+	MATRICE_HOST_INL friend _Myt operator/(const _Myt& x, value_type s) {
+		return x * (value_type(1) / s);
+	}
+	MATRICE_HOST_INL friend _Myt operator/(value_type s, const _Myt& x) {
+		const auto _Val = s / x.value();
+		return x._Unary(_Val, -_Val / x.value());
+	}
+	MATRICE_HOST_INL friend _Myt operator-(const _Myt& x) {
+		return x._Unary(-x.value(), -1);
+	}
+
+	MATRICE_HOST_INL friend _Myt sin(const _Myt& x) {
+		return x._Unary(MATRICE_STD(sin)(x.value()), MATRICE_STD(cos)(x.value()));
+	}
+	MATRICE_HOST_INL friend _Myt cos(const _Myt& x) {
+		return x._Unary(MATRICE_STD(cos)(x.value()), -MATRICE_STD(sin)(x.value()));
+	}
+	MATRICE_HOST_INL friend _Myt tan(const _Myt& x) {
+		const auto _Val = MATRICE_STD(tan)(x.value());
+		return x._Unary(_Val, 1 + _Val * _Val);
+	}
+	MATRICE_HOST_INL friend _Myt atan(const _Myt& x) {
+		return x._Unary(MATRICE_STD(atan)(x.value()), 1 / (1 + x.value() * x.value()));
+	}
+	MATRICE_HOST_INL friend _Myt atan2(const _Myt& y, const _Myt& x) {
+		const auto _Inv = value_type(1) / (x.value() * x.value() + y.value() * y.value());
+		return y._Binary(MATRICE_STD(atan2)(y.value(), x.value()), x.value() * _Inv, x, -y.value() * _Inv);
+	}
+	MATRICE_HOST_INL friend _Myt exp(const _Myt& x) {
+		const auto _Val = MATRICE_STD(exp)(x.value());
+		return x._Unary(_Val, _Val);
+	}
+	MATRICE_HOST_INL friend _Myt log(const _Myt& x) {
+		return x._Unary(MATRICE_STD(log)(x.value()), 1 / x.value());
+	}
+	MATRICE_HOST_INL friend _Myt sqrt(const _Myt& x) {
+		const auto _Val = MATRICE_STD(sqrt)(x.value());
+		return x._Unary(_Val, value_type(0.5) / _Val);
+	}
+	MATRICE_HOST_INL friend _Myt sq(const _Myt& x) {
+		return x._Unary(x.value() * x.value(), 2 * x.value());
+	}
+	MATRICE_HOST_INL friend _Myt pow(const _Myt& x, value_type p) {
+		const auto _Val = MATRICE_STD(pow)(x.value(), p);
+		return x._Unary(_Val, p * MATRICE_STD(pow)(x.value(), p - 1));
+	}
+	MATRICE_HOST_INL friend _Myt abs(const _Myt& x) {
+		return x._Unary(MATRICE_STD(abs)(x.value()), x.value() < 0 ? -1 : 1);
+	}
+
+private:
+	MATRICE_HOST_INL tape_var(tape_type* _Tape, size_t _Idx) noexcept
+		: _Mytape(_Tape), _Myidx(_Idx) {
+	}
+
+	/**
+	 *\brief Record a node with value '_Val' which depends on this node
+	         with the partial '_Px', and on 'y' with '_Py' if binary.
+	 */
+	MATRICE_HOST_INL _Myt _Unary(value_type _Val, value_type _Px) const {
+		return _Mytape->_Unary(_Val, _Myidx, _Px);
+	}
+	MATRICE_HOST_INL _Myt _Binary(value_type _Val, value_type _Px, const _Myt& y, value_type _Py) const {
+		return _Mytape->_Binary(_Val, _Myidx, _Px, y._Myidx, _Py);
+	}
+
+	tape_type* _Mytape = nullptr;
+	size_t _Myidx = 0;
+};
+
+/// <summary>
+/// \brief Vector or matrix node of a reverse-mode tape, a handle to a
+/// contiguous row-major block of the tape arena. Following Matrix_, the
+/// operator '*' is element-wise and 'mul()' is the matrix product. The
+/// elements are scalar nodes, so that mixed expressions are recorded.
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+template<typename _Ty>
+class tape_mat {
+	using _Myt = tape_mat;
+	friend class tape<_Ty>;
+public:
+	using value_type = _Ty;
+	using tape_type = tape<value_type>;
+	using var_type = tape_var<value_type>;
+
+	MATRICE_HOST_INL tape_mat() noexcept = default;
+
+	MATRICE_HOST_INL size_t rows() const noexcept { return _Myrows; }
+	MATRICE_HOST_INL size_t cols() const noexcept { return _Mycols; }
+	MATRICE_HOST_INL size_t size() const noexcept { return _Myrows * _Mycols; }
+	MATRICE_HOST_INL size_t offset() const noexcept { return _Myoff; }
+
+	/**
+	 *\brief Values and adjoints of the node, the pointers are valid
+	         until the next operation is recorded on the tape.
+	 */
+	MATRICE_HOST_INL auto data() const noexcept {
+		return _Mytape->_Myvals.data() + _Myoff;
+	}
+	MATRICE_HOST_INL auto data() noexcept {
+		return _Mytape->_Myvals.data() + _Myoff;
+	}
+	MATRICE_HOST_INL auto grad() const noexcept {
+		return _Mytape->_Myadjs.data() + _Myoff;
+	}
+
+	/**
+	 *\brief Element node at the linear index 'i' or at ('r', 'c').
+	 */
+	MATRICE_HOST_INL var_type operator()(size_t i) const noexcept {
+		return var_type(_Mytape, _Myoff + i);
+	}
+	MATRICE_HOST_INL var_type operator()(size_t r, size_t c) const noexcept {
+		return var_type(_Mytape, _Myoff + r * _Mycols + c);
+	}
+
+	/**
+	 *\brief Matrix product of this node and '_Right'.
+	 */
+	MATRICE_HOST_INL _Myt mul(const _Myt& _Right) const {
+		return _Mytape->matmul(*this, _Right);
+	}
+	/**
+	 *\brief Inner product and squared norm, regarding nodes as vectors.
+	 */
+	MATRICE_HOST_INL var_type dot(const _Myt& _Right) const {
+		return _Mytape->dot(*this, _Right);
+	}
+	MATRICE_HOST_INL var_type sqnorm() const {
+		return _Mytape->dot(*this, *this);
+	}
+	MATRICE_HOST_INL var_type sum() const {
+		return _Mytape->sum(*this);
+	}
+
+	MATRICE_HOST_INL friend _Myt operator+(const _Myt& x, const _Myt& y) {
+		return x._Ewise(_Tape_op::add, y);
+	}
+	MATRICE_HOST_INL friend _Myt operator-(const _Myt& x, const _Myt& y) {
+		return x._Ewise(_Tape_op::sub, y);
+	}
+	MATRICE_HOST_INL friend _Myt operator*(const _Myt& x, const _Myt& y) {
+		return x._Ewise(_Tape_op::mul, y);
+	}
+	MATRICE_HOST_INL friend _Myt operator*(const _Myt& x, const var_type& s) {
+		return x._Mytape->scale(x, s);
+	}
+	MATRICE_HOST_INL friend _Myt operator*(const var_type& s, const _Myt& x) {
+		return x._Mytape->scale(x, s);
+	}
+
+private:
+	MATRICE_HOST_INL tape_mat(tape_type* _Tape, size_t _Off, size_t _Rows, size_t _Cols) noexcept
+		: _Mytape(_Tape), _Myoff(_Off), _Myrows(_Rows), _Mycols(_Cols) {
+	}
+
+	MATRICE_HOST_INL _Myt _Ewise(_Tape_op _Code, const _Myt& y) const {
+		return _Mytape->_Ewise(_Code, *this, y);
+	}
+
+	tape_type* _Mytape = nullptr;
+	size_t _Myoff = 0, _Myrows = 0, _Mycols = 0;
+};
+
+/// <summary>
+/// \brief Reverse-mode automatic differentiation tape. Node values and
+/// adjoints live in two contiguous arenas, and each operation appends a
+/// statement holding its operands and, for scalar operations, the local
+/// partial derivatives. Vector and matrix operations are recorded as one
+/// statement each. A single backward sweep over the statements then
+/// accumulates the gradients w.r.t. all nodes.
+/// The arenas only grow: checkpoint() marks the current end of the tape,
+/// and rewind() or reset() truncate it without releasing memory, so that
+/// an iterative solver records the same residuals in every iteration
+/// without allocation.
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+/// <example>
+/// tape<double> t;
+/// auto x = t.variable(3, 1, p); // leaves
+/// const auto cp = t.checkpoint();
+/// for (...) {
+///	  t.rewind(cp); // keep leaves, drop the residuals of the last step
+///	  auto r = R.mul(x) + c;
+///	  t.jacobian(r, x, J.data());
+/// }
+/// </example>
+template<typename _Ty>
+class tape {
+	using _Myt = tape;
+	friend class tape_var<_Ty>;
+	friend class tape_mat<_Ty>;
+public:
+	using value_type = _Ty;
+	using var_type = tape_var<value_type>;
+	using mat_type = tape_mat<value_type>;
+
+	/**
+	 *\brief End of the tape, returned by checkpoint().
+	 */
+	struct checkpoint_type {
+		size_t nvals = 0, nstmts = 0, nargs = 0;
+	};
+
+	MATRICE_HOST_INL tape() noexcept = default;
+	tape(const _Myt&) = delete;
+	_Myt& operator=(const _Myt&) = delete;
+
+	/**
+	 *\brief Reserve the arenas for '_Nvals' nodes, '_Nstmts' statements
+	         and '_Nargs' operands of scalar statements.
+	 */
+	MATRICE_HOST_INL _Myt& reserve(size_t _Nvals, size_t _Nstmts, size_t _Nargs) {
+		_Myvals.reserve(_Nvals), _Myadjs.reserve(_Nvals);
+		_Mystmts.reserve(_Nstmts);
+		_Myargs.reserve(_Nargs), _Mypars.reserve(_Nargs);
+		return (*this);
+	}
+
+	/**
+	 *\brief Create a scalar leaf node.
+	 */
+	MATRICE_HOST_INL var_type variable(value_type _Val = 0) {
+		const auto _Idx = _Alloc(1);
+		_Myvals[_Idx] = _Val;
+		return var_type(this, _Idx);
+	}
+	/**
+	 *\brief Create a '_Rows' x '_Cols' leaf node, which is initialized
+	         with the row-major '_Data' if it is not null, or else zeros.
+	 */
+	MATRICE_HOST_INL mat_type variable(size_t _Rows, size_t _Cols, const value_type* _Data = nullptr) {
+		const auto _Off = _Alloc(_Rows * _Cols);
+		if (_Data) MATRICE_STD(copy)(_Data, _Data + _Rows * _Cols, _Myvals.data() + _Off);
+		return mat_type(this, _Off, _Rows, _Cols);
+	}
+	/**
+	 *\brief Gather scalar nodes into a column vector node.
+	 */
+	MATRICE_HOST_INL mat_type stack(MATRICE_STD(initializer_list)<var_type> _Vars) {
+		const auto _Off = _Alloc(_Vars.size());
+		auto _Idx = _Off;
+		for (const auto& _Var : _Vars) {
+			_Myvals[_Idx] = _Var.value();
+			_Push(_Op::scalar, _Idx++, _Myargs.size(), 0, 1);
+			_Myargs.push_back(_Var._Myidx), _Mypars.push_back(value_type(1));
+		}
+		return mat_type(this, _Off, _Vars.size(), 1);
+	}
+
+	/**
+	 *\brief Matrix product C = A*B.
+	 */
+	MATRICE_HOST_INL mat_type matmul(const mat_type& A, const mat_type& B) {
+		DGELOM_CHECK(A.cols() == B.rows(), "Inconsistent shapes in tape::matmul.");
+		const auto M = A.rows(), K = A.cols(), N = B.cols();
+		const auto _Off = _Alloc(M * N);
+		const auto _A = _Myvals.data() + A._Myoff, _B = _Myvals.data() + B._Myoff;
+		const auto _C = _Myvals.data() + _Off;
+		for (size_t i = 0; i < M; ++i) {
+			for (size_t j = 0; j < N; ++j) {
+				auto _Val = value_type(0);
+				for (size_t k = 0; k < K; ++k) _Val += _A[i * K + k] * _B[k * N + j];
+				_C[i * N + j] = _Val;
+			}
+		}
+		_Push(_Op::matmul, _Off, A._Myoff, B._Myoff, N, M, K);
+		return mat_type(this, _Off, M, N);
+	}
+	/**
+	 *\brief Inner product of two nodes with the same size.
+	 */
+	MATRICE_HOST_INL var_type dot(const mat_type& A, const mat_type& B) {
+		DGELOM_CHECK(A.size() == B.size(), "Inconsistent sizes in tape::dot.");
+		const auto _Idx = _Alloc(1);
+		auto _Val = value_type(0);
+		for (size_t i = 0; i < A.size(); ++i) {
+			_Val += _Myvals[A._Myoff + i] * _Myvals[B._Myoff + i];
+		}
+		_Myvals[_Idx] = _Val;
+		_Push(_Op::dot, _Idx, A._Myoff, B._Myoff, A.size());
+		return var_type(this, _Idx);
+	}
+	/**
+	 *\brief Sum of the elements of a node.
+	 */
+	MATRICE_HOST_INL var_type sum(const mat_type& A) {
+		const auto _Idx = _Alloc(1);
+		auto _Val = value_type(0);
+		for (size_t i = 0; i < A.size(); ++i) _Val += _Myvals[A._Myoff + i];
+		_Myvals[_Idx] = _Val;
+		_Push(_Op::sum, _Idx, A._Myoff, 0, A.size());
+		return var_type(this, _Idx);
+	}
+	/**
+	 *\brief Product of a node and a scalar node.
+	 */
+	MATRICE_HOST_INL mat_type scale(const mat_type& A, const var_type& s) {
+		const auto _Off = _Alloc(A.size());
+		const auto _S = _Myvals[s._Myidx];
+		for (size_t i = 0; i < A.size(); ++i) {
+			_Myvals[_Off + i] = _Myvals[A._Myoff + i] * _S;
+		}
+		_Push(_Op::scale, _Off, A._Myoff, s._Myidx, A.size());
+		return mat_type(this, _Off, A.rows(), A.cols());
+	}
+
+	/**
+	 *\brief Sweep the tape backward from the scalar node 'f', so that the
+	         adjoint of every node holds its derivative of 'f'.
+	 */
+	MATRICE_HOST_INL void backward(const var_type& f) noexcept {
+		clear_grad();
+		_Myadjs[f._Myidx] = value_type(1);
+		_Sweep();
+	}
+	/**
+	 *\brief Sweep the tape backward from the node 'f' seeded with the
+	         adjoints '_Seed', i.e. evaluate the vector-Jacobian product.
+	 */
+	MATRICE_HOST_INL void backward(const mat_type& f, const value_type* _Seed) noexcept {
+		clear_grad();
+		MATRICE_STD(copy)(_Seed, _Seed + f.size(), _Myadjs.data() + f._Myoff);
+		_Sweep();
+	}
+	/**
+	 *\brief Evaluate the Jacobian of the node 'f' w.r.t. the node 'x' into
+	         the row-major 'f.size()' x 'x.size()' matrix '_Jac', with one
+	         backward sweep per entry of 'f'.
+	 */
+	MATRICE_HOST_INL void jacobian(const mat_type& f, const mat_type& x, value_type* _Jac) noexcept {
+		for (size_t i = 0; i < f.size(); ++i) {
+			this->backward(f(i));
+			const auto _Adj = _Myadjs.data() + x._Myoff;
+			MATRICE_STD(copy)(_Adj, _Adj + x.size(), _Jac + i * x.size());
+		}
+	}
+	MATRICE_HOST_INL void clear_grad() noexcept {
+		MATRICE_STD(fill)(_Myadjs.begin(), _Myadjs.end(), value_type(0));
+	}
+
+	/**
+	 *\brief Mark the current end of the tape.
+	 */
+	MATRICE_HOST_INL checkpoint_type checkpoint() const noexcept {
+		return { _Myvals.size(), _Mystmts.size(), _Myargs.size() };
+	}
+	/**
+	 *\brief Truncate the tape to the checkpoint '_Cp', nodes created after
+	         it become invalid. The memory of the arenas is retained.
+	 */
+	MATRICE_HOST_INL _Myt& rewind(const checkpoint_type& _Cp) noexcept {
+		_Myvals.resize(_Cp.nvals), _Myadjs.resize(_Cp.nvals);
+		_Mystmts.resize(_Cp.nstmts);
+		_Myargs.resize(_Cp.nargs), _Mypars.resize(_Cp.nargs);
+		return (*this);
+	}
+	/**
+	 *\brief Clear the tape, the memory of the arenas is retained.
+	 */
+	MATRICE_HOST_INL _Myt& reset() noexcept {
+		return this->rewind(checkpoint_type{});
+	}
+
+	/**
+	 *\brief Number of nodes and statements on the tape.
+	 */
+	MATRICE_HOST_INL size_t size() const noexcept {
+		return _Myvals.size();
+	}
+	MATRICE_HOST_INL size_t nstmts() const noexcept {
+		return _Mystmts.size();
+	}
+
+private:
+	using _Op = _Tape_op;
+
+	/**
+	 *\brief Statement of the tape. A scalar statement reads the operands
+	         and partials [a, a + n) of _Myargs and _Mypars, and the other
+	         statements read the blocks at the offsets 'a' and 'b'.
+	 */
+	struct _Stmt {
+		_Op op;
+		size_t out, a, b, n, m, k;
+	};
+
+	MATRICE_HOST_INL size_t _Alloc(size_t _Size) {
+		const auto _Off = _Myvals.size();
+		_Myvals.resize(_Off + _Size), _Myadjs.resize(_Off + _Size);
+		return _Off;
+	}
+	MATRICE_HOST_INL void _Push(_Op _Code, size_t _Out, size_t _A, size_t _B, size_t _N, size_t _M = 0, size_t _K = 0) {
+		_Mystmts.push_back({ _Code, _Out, _A, _B, _N, _M, _K });
+	}
+	MATRICE_HOST_INL var_type _Unary(value_type _Val, size_t _A, value_type _Pa) {
+		const auto _Idx = _Alloc(1);
+		_Myvals[_Idx] = _Val;
+		_Push(_Op::scalar, _Idx, _Myargs.size(), 0, 1);
+		_Myargs.push_back(_A), _Mypars.push_back(_Pa);
+		return var_type(this, _Idx);
+	}
+	MATRICE_HOST_INL var_type _Binary(value_type _Val, size_t _A, value_type _Pa, size_t _B, value_type _Pb) {
+		const auto _Idx = _Alloc(1);
+		_Myvals[_Idx] = _Val;
+		_Push(_Op::scalar, _Idx, _Myargs.size(), 0, 2);
+		_Myargs.push_back(_A), _Mypars.push_back(_Pa);
+		_Myargs.push_back(_B), _Mypars.push_back(_Pb);
+		return var_type(this, _Idx);
+	}
+	MATRICE_HOST_INL mat_type _Ewise(_Op _Code, const mat_type& A, const mat_type& B) {
+		DGELOM_CHECK(A.size() == B.size(), "Inconsistent sizes of tape nodes.");
+		const auto _Off = _Alloc(A.size());
+		const auto _A = _Myvals.data() + A._Myoff, _B = _Myvals.data() + B._Myoff;
+		const auto _C = _Myvals.data() + _Off;
+		for (size_t i = 0; i < A.size(); ++i) {
+			_C[i] = _Code == _Op::add ? _A[i] + _B[i] : _Code == _Op::sub ? _A[i] - _B[i] : _A[i] * _B[i];
+		}
+		_Push(_Code, _Off, A._Myoff, B._Myoff, A.size());
+		return mat_type(this, _Off, A.rows(), A.cols());
+	}
+
+	/**
+	 *\brief Propagate the adjoints through all statements in reverse.
+	 */
+	MATRICE_HOST_INL void _Sweep() noexcept {
+		const auto _Val = _Myvals.data();
+		const auto _Adj = _Myadjs.data();
+		for (auto _It = _Mystmts.rbegin(); _It != _Mystmts.rend(); ++_It) {
+			const auto& _S = *_It;
+			const auto _Dc = _Adj + _S.out;
+			switch (_S.op) {
+			case _Op::scalar:
+				if (_Dc[0] != value_type(0)) {
+					for (size_t i = _S.a; i < _S.a + _S.n; ++i)
+						_Adj[_Myargs[i]] += _Mypars[i] * _Dc[0];
+				}
+				break;
+			case _Op::add:
+				for (size_t i = 0; i < _S.n; ++i) {
+					_Adj[_S.a + i] += _Dc[i], _Adj[_S.b + i] += _Dc[i];
+				}
+				break;
+			case _Op::sub:
+				for (size_t i = 0; i < _S.n; ++i) {
+					_Adj[_S.a + i] += _Dc[i], _Adj[_S.b + i] -= _Dc[i];
+				}
+				break;
+			case _Op::mul:
+				for (size_t i = 0; i < _S.n; ++i) {
+					_Adj[_S.a + i] += _Dc[i] * _Val[_S.b + i];
+					_Adj[_S.b + i] += _Dc[i] * _Val[_S.a + i];
+				}
+				break;
+			case _Op::scale:
+				for (size_t i = 0; i < _S.n; ++i) {
+					_Adj[_S.a + i] += _Dc[i] * _Val[_S.b];
+					_Adj[_S.b] += _Dc[i] * _Val[_S.a + i];
+				}
+				break;
+			case _Op::dot:
+				for (size_t i = 0; i < _S.n; ++i) {
+					_Adj[_S.a + i] += _Dc[0] * _Val[_S.b + i];
+					_Adj[_S.b + i] += _Dc[0] * _Val[_S.a + i];
+				}
+				break;
+			case _Op::sum:
+				for (size_t i = 0; i < _S.n; ++i) _Adj[_S.a + i] += _Dc[0];
+				break;
+			case _Op::matmul: {
+				// \dA += dC*B^T and dB += A^T*dC, with C = A*B of M x N and K inner
+				const auto M = _S.m, N = _S.n, K = _S.k;
+				const auto _A = _Val + _S.a, _B = _Val + _S.b;
+				const auto _Da = _Adj + _S.a, _Db = _Adj + _S.b;
+				for (size_t i = 0; i < M; ++i) {
+					for (size_t j = 0; j < N; ++j) {
+						const auto _G = _Dc[i * N + j];
+						for (size_t k = 0; k < K; ++k) {
+							_Da[i * K + k] += _G * _B[k * N + j];
+							_Db[k * N + j] += _G * _A[i * K + k];
+						}
+					}
+				}
+			} break;
+			default: break;
+			}
+		}
+	}
+
+	MATRICE_STD(vector)<value_type> _Myvals, _Myadjs;
+	MATRICE_STD(vector)<_Stmt> _Mystmts;
+	MATRICE_STD(vector)<size_t> _Myargs;
+	MATRICE_STD(vector)<value_type> _Mypars;
+};
+}
+DGE_MATRICE_END
@@ -18,18 +18,27 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include "../_matrix_ops.hpp"
 #include "../math/_linear_kernel.hpp"
+#include "../math/_small_linear_kernel.hpp"
 
 DGE_MATRICE_BEGIN
 _DETAIL_BEGIN
 template<class _Mty>
 class _Matrix_fact<_Mty, tag::_Linear_spd_tag> {
 	using matrix_type = _Mty;
+	using value_type = typename matrix_type::value_type;
+	static constexpr auto _Is_small = is_small_square_v<matrix_type> &&
+		is_floating_point_v<value_type>;
+	using _Small_kernel = _Small_linear_kernel<value_type,
+		_Is_small ? size_t(matrix_type::rows_at_compiletime) : 1>;
 public:
 	_Matrix_fact(_Mty& a) : m_ret(a) {
 #ifdef MATRICE_DEBUG
 		DGELOM_CHECK(a.rows() == a.cols(), "a must be a square matrix in _Matrix_linear_fact<>.");
 #endif
-		_Linear_spd_kernel(a.data(), a.rows());
+		if constexpr (_Is_small)
+			_Small_kernel::spd(a.data());
+		else
+			_Linear_spd_kernel(a.data(), a.rows());
 	}
 
 	MATRICE_GLOBAL_INL matrix_type& operator()() noexcept {
@@ -41,7 +50,10 @@ public:
 
 	MATRICE_GLOBAL_INL matrix_type inv() noexcept {
 		matrix_type inv(m_ret.shape());
-		_Linear_ispd_kernel(m_ret.data(), inv.data(), inv.rows());
+		if constexpr (_Is_small)
+			_Small_kernel::ispd(m_ret.data(), inv.data());
+		else
+			_Linear_ispd_kernel(m_ret.data(), inv.data(), inv.rows());
 		return inv;
 	}
 
@@ -0,0 +1,233 @@
+/**************************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+more detail.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "util/_macros.h"
+#include "util/_type_defs.h"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+// \brief Minimal M*N*K of a product evaluated by the native GEMM kernel,
+// smaller products are evaluated with dot products.
+#ifndef MATRICE_GEMM_THRESHOLD
+#define MATRICE_GEMM_THRESHOLD 4096
+#endif
+
+DGE_MATRICE_BEGIN
+_DETAIL_BEGIN
+/// <summary>
+/// \brief Epilogue of the native GEMM kernel which leaves C untouched.
+/// </summary>
+struct _Gemm_epilogue_none {
+	template<typename _Ty>
+	MATRICE_HOST_FINL void operator()(_Ty*, size_t, size_t, size_t) const noexcept {}
+};
+
+/// <summary>
+/// \brief Native GEMM kernel, C = A * B with row-major operands, which is
+/// used when MKL is absent. The product is blocked into KC x NC panels of B
+/// and MC x KC blocks of A (GotoBLAS style), both packed into contiguous
+/// micro-panels. A register-blocked micro-kernel updates an MR x NR tile of
+/// C from the packed panels, and the MC blocks run in parallel.
+/// Either operand may be read transposed while it is packed, and an
+/// epilogue may be fused into the last KC panel to post-process each tile
+/// while it is still in cache, e.g. adding a bias and activating.
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+template<typename _Ty> class _Gemm_kernel {
+	using _Myt = _Gemm_kernel;
+public:
+	using value_type = _Ty;
+#ifdef MATRICE_SIMD_ARCH
+	using packet_type = simd::Packet_<value_type>;
+	static constexpr size_t lanes = packet_type::size;
+#else
+	static constexpr size_t lanes = 4;
+#endif
+	// \register tile: MR rows by NR = 2 packets
+	static constexpr size_t MR = 6, NR = lanes << 1;
+	// \cache blocks: A block in L2, B panel in L3
+	static constexpr size_t KC = 256, MC = MR * 16;
+	static constexpr size_t NC = NR * (2048 / NR);
+
+	/**
+	 *\brief Compute C = op(A) * op(B), where op(A) is M x K and op(B) is
+	         K x N. A is stored as M x K if '_Ta' is false or else as K x M,
+	         with leading dimension '_Lda', likewise B with '_Ldb', and C is
+	         M x N with '_Ldc'.
+	 *\param '_Epilogue' called as _Epilogue(c, i, j, n) on the segment
+	         c[0, n) of each row of C, which holds the entries (i, j + l),
+	         once the segment is final. It may be invoked concurrently on
+	         disjoint segments.
+	 */
+	template<bool _Ta = false, bool _Tb = false, typename _Op = _Gemm_epilogue_none>
+	static MATRICE_HOST_INL void eval(size_t M, size_t N, size_t K,
+		const value_type* A, size_t _Lda, const value_type* B, size_t _Ldb,
+		value_type* C, size_t _Ldc, const _Op& _Epilogue = _Op{}) {
+		constexpr auto _Has_epilogue = !MATRICE_STD(is_same_v)<_Op, _Gemm_epilogue_none>;
+		if (M == 0 || N == 0) return;
+		if (K == 0) {
+			for (size_t i = 0; i < M; ++i) {
+				MATRICE_STD(fill)(C + i * _Ldc, C + i * _Ldc + N, value_type(0));
+				if constexpr (_Has_epilogue) _Epilogue(C + i * _Ldc, i, 0, N);
+			}
+			return;
+		}
+
+		auto& _Bp = _Buffer<1>(KC * NC);
+		for (size_t _Jc = 0; _Jc < N; _Jc += NC) {
+			const auto _Nc = (MATRICE_STD(min))(NC, N - _Jc);
+			for (size_t _Pc = 0; _Pc < K; _Pc += KC) {
+				const auto _Kc = (MATRICE_STD(min))(KC, K - _Pc);
+				const auto _Last = _Pc + _Kc == K;
+				_Pack_b<_Tb>(_Tb ? B + _Jc * _Ldb + _Pc : B + _Pc * _Ldb + _Jc, _Ldb, _Kc, _Nc, _Bp.data());
+
+				const auto _Nblks = index_t((M + MC - 1) / MC);
+#pragma omp parallel for schedule(dynamic) if(_Nblks > 1 && M * _Nc * _Kc > (1 << 18))
+				for (index_t _B = 0; _B < _Nblks; ++_B) {
+					const auto _Ic = size_t(_B) * MC;
+					const auto _Mc = (MATRICE_STD(min))(MC, M - _Ic);
+					auto& _Ap = _Buffer<0>(MC * KC);
+					_Pack_a<_Ta>(_Ta ? A + _Pc * _Lda + _Ic : A + _Ic * _Lda + _Pc, _Lda, _Mc, _Kc, _Ap.data());
+					for (size_t _Jr = 0; _Jr < _Nc; _Jr += NR) {
+						const auto _Nr = (MATRICE_STD(min))(NR, _Nc - _Jr);
+						for (size_t _Ir = 0; _Ir < _Mc; _Ir += MR) {
+							const auto _Mr = (MATRICE_STD(min))(MR, _Mc - _Ir);
+							const auto _C = C + (_Ic + _Ir) * _Ldc + _Jc + _Jr;
+							_Micro(_Kc, _Ap.data() + _Ir * _Kc, _Bp.data() + _Jr * _Kc,
+								_C, _Ldc, _Pc == 0, _Mr, _Nr);
+							if constexpr (_Has_epilogue) if (_Last) {
+								for (size_t i = 0; i < _Mr; ++i)
+									_Epilogue(_C + i * _Ldc, _Ic + _Ir + i, _Jc + _Jr, _Nr);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+private:
+	template<size_t _Idx>
+	static MATRICE_HOST_INL auto& _Buffer(size_t _Size) {
+		static thread_local MATRICE_STD(vector)<value_type> _Buf;
+		if (_Buf.size() < _Size) _Buf.resize(_Size);
+		return (_Buf);
+	}
+
+	/**
+	 *\brief Pack an '_Mc' x '_Kc' block of A into micro-panels of MR rows,
+	         where the k-th column of a panel is contiguous. Rows out of
+	         the block are padded with zeros. The block is read from the
+	         '_Kc' x '_Mc' storage of A^T if '_Ta' is true.
+	 */
+	template<bool _Ta>
+	static MATRICE_HOST_INL void _Pack_a(const value_type* A, size_t _Lda, size_t _Mc, size_t _Kc, value_type* _Dst) noexcept {
+		for (size_t _Ir = 0; _Ir < _Mc; _Ir += MR) {
+			const auto _Mr = (MATRICE_STD(min))(MR, _Mc - _Ir);
+			for (size_t k = 0; k < _Kc; ++k, _Dst += MR) {
+				size_t i = 0;
+				for (; i < _Mr; ++i) _Dst[i] = _Ta ? A[k * _Lda + _Ir + i] : A[(_Ir + i) * _Lda + k];
+				for (; i < MR; ++i) _Dst[i] = value_type(0);
+			}
+		}
+	}
+
+	/**
+	 *\brief Pack a '_Kc' x '_Nc' panel of B into micro-panels of NR columns,
+	         where the k-th row of a panel is contiguous. Columns out of the
+	         panel are padded with zeros. The panel is read from the
+	         '_Nc' x '_Kc' storage of B^T if '_Tb' is true.
+	 */
+	template<bool _Tb>
+	static MATRICE_HOST_INL void _Pack_b(const value_type* B, size_t _Ldb, size_t _Kc, size_t _Nc, value_type* _Dst) noexcept {
+		for (size_t _Jr = 0; _Jr < _Nc; _Jr += NR) {
+			const auto _Nr = (MATRICE_STD(min))(NR, _Nc - _Jr);
+			for (size_t k = 0; k < _Kc; ++k, _Dst += NR) {
+				size_t j = 0;
+				if constexpr (_Tb) {
+					for (; j < _Nr; ++j) _Dst[j] = B[(_Jr + j) * _Ldb + k];
+				}
+				else {
+					const auto _Src = B + k * _Ldb + _Jr;
+					for (; j < _Nr; ++j) _Dst[j] = _Src[j];
+				}
+				for (; j < NR; ++j) _Dst[j] = value_type(0);
+			}
+		}
+	}
+
+	/**
+	 *\brief Update the '_Mr' x '_Nr' tile of C with packed panels of A and B,
+	         the tile is overwritten if '_First' is true, or else accumulated.
+	 */
+	static MATRICE_HOST_INL void _Micro(size_t _Kc, const value_type* _Ap, const value_type* _Bp,
+		value_type* C, size_t _Ldc, bool _First, size_t _Mr, size_t _Nr) noexcept {
+#ifdef MATRICE_SIMD_ARCH
+		packet_type _Acc[MR][2];
+		for (size_t i = 0; i < MR; ++i) {
+			_Acc[i][0] = packet_type(value_type(0));
+			_Acc[i][1] = packet_type(value_type(0));
+		}
+		for (size_t k = 0; k < _Kc; ++k, _Ap += MR, _Bp += NR) {
+			const packet_type _B0(const_cast<value_type*>(_Bp));
+			const packet_type _B1(const_cast<value_type*>(_Bp + lanes));
+			for (size_t i = 0; i < MR; ++i) {
+				const packet_type _A(_Ap[i]);
+				_Acc[i][0] = _Acc[i][0] + _A * _B0;
+				_Acc[i][1] = _Acc[i][1] + _A * _B1;
+			}
+		}
+		if (_Mr == MR && _Nr == NR) {
+			for (size_t i = 0; i < MR; ++i) {
+				const auto _C = C + i * _Ldc;
+				if (!_First) {
+					_Acc[i][0] = _Acc[i][0] + packet_type(_C);
+					_Acc[i][1] = _Acc[i][1] + packet_type(_C + lanes);
+				}
+				_Acc[i][0].unpack(_C);
+				_Acc[i][1].unpack(_C + lanes);
+			}
+			return;
+		}
+		value_type _Tile[MR][NR];
+		for (size_t i = 0; i < _Mr; ++i) {
+			_Acc[i][0].unpack(_Tile[i]);
+			_Acc[i][1].unpack(_Tile[i] + lanes);
+		}
+#else
+		value_type _Tile[MR][NR] = {};
+		for (size_t k = 0; k < _Kc; ++k, _Ap += MR, _Bp += NR) {
+			for (size_t i = 0; i < MR; ++i) {
+				const auto _A = _Ap[i];
+				for (size_t j = 0; j < NR; ++j) _Tile[i][j] += _A * _Bp[j];
+			}
+		}
+#endif
+		for (size_t i = 0; i < _Mr; ++i) {
+			const auto _C = C + i * _Ldc;
+			for (size_t j = 0; j < _Nr; ++j) {
+				_C[j] = _First ? _Tile[i][j] : _C[j] + _Tile[i][j];
+			}
+		}
+	}
+};
+_DETAIL_END
+DGE_MATRICE_END
@@ -18,6 +18,7 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 #include "../_type_traits.h"
 #include "core/matrix.h"
+#include "_small_linear_kernel.hpp"
 
 DGE_MATRICE_BEGIN
 /// <summary>
@@ -79,6 +80,12 @@ public:
 	using matrix_type = typename _Mytraits::matrix_type;
 	using value_type = typename _Mytraits::value_type;
 
+	// \small fixed-size systems are solved with the unrolled kernels.
+	static constexpr auto is_small = is_small_square_v<matrix_type> &&
+		is_floating_point_v<value_type>;
+	using small_kernel = _Small_linear_kernel<value_type,
+		is_small ? size_t(matrix_type::rows_at_compiletime) : 1>;
+
 	/**
 	 * \brief Ctor
 	 * \param 'coeff' Coefficient matrix of the system.
@@ -147,10 +154,16 @@ protected:
 				_Mdp->vt().view());
 		}
 		if constexpr (is_same_v<kernel_t, spt>) {
-			internal::_Lak_adapter<spt>(view(_Mycoeff));
+			if constexpr (is_small)
+				small_kernel::spd(_Mycoeff.data());
+			else
+				internal::_Lak_adapter<spt>(view(_Mycoeff));
 		}
 		if constexpr (is_same_v<kernel_t, lud>) {
-			internal::_Lak_adapter<lud>(view(_Mycoeff), _Mdp->piv().view());
+			if constexpr (is_small)
+				small_kernel::lud(_Mycoeff.data(), _Mdp->piv().data());
+			else
+				internal::_Lak_adapter<lud>(view(_Mycoeff), _Mdp->piv().view());
 		}
 	}
 
@@ -161,6 +174,9 @@ protected:
 		if constexpr (is_same_v<kernel_t, void>) {
 			//general matrix inverse
 			matrix_type _Ret(_Mycoeff.rows(), _Mycoeff.cols());
+			if constexpr (is_small) {
+				small_kernel::inv(_Mycoeff.data(), _Ret.data());
+			}
 
 			return move(_Ret);
 		}
@@ -173,7 +189,10 @@ protected:
 		}
 		if constexpr (is_same_v<kernel_t, spt>) {
 			matrix_type _Ret(_Mycoeff.rows(), _Mycoeff.cols());
-			internal::_Inv_adapter<kernel_t>(view(_Mycoeff), _Ret.view());
+			if constexpr (is_small)
+				small_kernel::ispd(_Mycoeff.data(), _Ret.data());
+			else
+				internal::_Inv_adapter<kernel_t>(view(_Mycoeff), _Ret.view());
 			return move(_Ret);
 		}
 	}
@@ -215,7 +234,9 @@ class _Linear_solver<_Mty, OP> : \
 	using _Myop = OP; \
 public: \
 	using typename _Mybase::value_type; \
-	using typename _Mybase::matrix_type;
+	using typename _Mybase::matrix_type; \
+	using typename _Mybase::small_kernel; \
+	using _Mybase::is_small;
 
 #define MATRICE_MAKE_LINEAR_SOLVER_SPEC_END(OP) };
 
@@ -298,7 +319,14 @@ MATRICE_MAKE_LINEAR_SOLVER_SPEC_BEGIN(spt)
 		DGELOM_CHECK(_L.rows() == B.rows(),
 			"The number of rows of the right-hand vector(s) is not identical to that of the coeff. matrix.");
 #endif
-		internal::_Bwd_adapter<_Myop>(_L.view(), B.view());
+		if constexpr (is_small) {
+			const auto _Stride = size_t(B.cols());
+			for (size_t _Off = 0; _Off < _Stride; ++_Off)
+				small_kernel::spd_bwd(_L.data(), B.data() + _Off, _Stride);
+		}
+		else {
+			internal::_Bwd_adapter<_Myop>(_L.view(), B.view());
+		}
 		return (B);
 	}
 MATRICE_MAKE_LINEAR_SOLVER_SPEC_END(spt)
@@ -376,7 +404,14 @@ MATRICE_MAKE_LINEAR_SOLVER_SPEC_BEGIN(lud)
 		DGELOM_CHECK(LU.rows() == B.rows(),
 			"The number of rows of the right-hand vector is not identical to that of the coeff. matrix.");
 #endif
-		internal::_Bwd_adapter<_Myop>(LU.view(), B.view(), _Myidx.view());
+		if constexpr (is_small) {
+			const auto _Stride = size_t(B.cols());
+			for (size_t _Off = 0; _Off < _Stride; ++_Off)
+				small_kernel::lud_sv(LU.data(), B.data() + _Off, _Myidx.data(), _Stride);
+		}
+		else {
+			internal::_Bwd_adapter<_Myop>(LU.view(), B.view(), _Myidx.view());
+		}
 		return (B);
 	}
 private:
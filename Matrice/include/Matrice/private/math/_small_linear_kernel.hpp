@@ -0,0 +1,515 @@
+/**************************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+more detail.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+#pragma once
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <type_traits>
+#include "util/_macros.h"
+#include "util/_type_defs.h"
+#ifdef MATRICE_SIMD_ARCH
+#include "arch/simd.h"
+#endif
+
+// \brief Maximal dimension of square matrices that are factorized and
+// solved with the compile-time unrolled kernels.
+#ifndef MATRICE_SMALL_LINALG_MAXDIM
+#define MATRICE_SMALL_LINALG_MAXDIM 8
+#endif
+
+DGE_MATRICE_BEGIN
+_DETAIL_BEGIN
+/**
+ *\brief Invoke '_Fn(integral_constant<size_t, i>)' for i in [_Begin, _End),
+         the loop is expanded at compile-time.
+ */
+template<size_t _Begin, size_t _End, typename _Fn, size_t... _Is>
+MATRICE_GLOBAL_FINL void _Static_for(_Fn&& _Func, MATRICE_STD(index_sequence)<_Is...>) {
+	(_Func(MATRICE_STD(integral_constant)<size_t, _Begin + _Is>{}), ...);
+}
+template<size_t _Begin, size_t _End, typename _Fn>
+MATRICE_GLOBAL_FINL void _Static_for(_Fn&& _Func) {
+	if constexpr (_Begin < _End) {
+		_Static_for<_Begin, _End>(_Func, MATRICE_STD(make_index_sequence)<_End - _Begin>{});
+	}
+}
+
+/**
+ *\brief Check if '_Mty' is a square matrix type with a dimension known at
+         compile-time and not larger than MATRICE_SMALL_LINALG_MAXDIM.
+ */
+template<typename _Mty, typename = void>
+struct _Is_small_square : MATRICE_STD(false_type) {};
+template<typename _Mty>
+struct _Is_small_square<_Mty, MATRICE_STD(void_t)<
+	decltype(_Mty::rows_at_compiletime), decltype(_Mty::cols_at_compiletime)>>
+	: MATRICE_STD(bool_constant)<(
+	static_cast<long long>(_Mty::rows_at_compiletime) == static_cast<long long>(_Mty::cols_at_compiletime) &&
+	static_cast<long long>(_Mty::rows_at_compiletime) > 0 &&
+	static_cast<long long>(_Mty::rows_at_compiletime) <= MATRICE_SMALL_LINALG_MAXDIM)> {};
+template<typename _Mty>
+inline constexpr auto is_small_square_v = _Is_small_square<_Mty>::value;
+
+/// <summary>
+/// \brief Linear algebra kernels for an _N x _N row-major matrix with _N
+/// known at compile-time. All loops are unrolled, so the kernels replace the
+/// generic '_Linear_xxx_kernel' for small fixed systems, such as the IC-GN
+/// Hessian, rotations and projections. The status conventions follow the
+/// generic kernels declared in "_linear_kernel.hpp".
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+/// <typeparam name="_N">Dimension of the matrix</typeparam>
+template<typename _Ty, size_t _N> struct _Small_linear_kernel {
+	static_assert(_N > 0 && _N <= MATRICE_SMALL_LINALG_MAXDIM,
+		"_N of _Small_linear_kernel<_Ty, _N> is out of range.");
+	using value_type = _Ty;
+	static constexpr size_t dimension = _N;
+
+	/**
+	 *\brief In-place Cholesky decomposition 'A = L*L^T'. The upper triangle
+	         of 'A' is read, L is written to the lower triangle and the strict
+	         upper triangle is zeroed.
+	 *\return 1 for success, or '-r' if the 'r'-th (1-based) pivot is not positive.
+	 */
+	static MATRICE_GLOBAL_INL int spd(value_type* A) noexcept {
+		int _Status = 1;
+		_Static_for<0, _N>([&](auto _J) {
+			constexpr auto j = decltype(_J)::value;
+			if (_Status != 1) return;
+			auto _Sum = A[j * _N + j];
+			_Static_for<0, j>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Sum -= A[j * _N + k] * A[j * _N + k];
+			});
+			if (!(_Sum > value_type(0))) {
+				_Status = -int(j + 1);
+				return;
+			}
+			const auto _Ljj = MATRICE_STD(sqrt)(_Sum);
+			const auto _Inv = value_type(1) / _Ljj;
+			A[j * _N + j] = _Ljj;
+			_Static_for<j + 1, _N>([&](auto _I) {
+				constexpr auto i = decltype(_I)::value;
+				auto _Val = A[j * _N + i];
+				_Static_for<0, j>([&](auto _K) {
+					constexpr auto k = decltype(_K)::value;
+					_Val -= A[i * _N + k] * A[j * _N + k];
+				});
+				A[i * _N + j] = _Val * _Inv;
+			});
+		});
+		if (_Status == 1) {
+			_Static_for<1, _N>([&](auto _I) {
+				constexpr auto i = decltype(_I)::value;
+				_Static_for<0, i>([&](auto _J) {
+					A[decltype(_J)::value * _N + i] = value_type(0);
+				});
+			});
+		}
+		return _Status;
+	}
+
+	/**
+	 *\brief Solve 'L*L^T*x = b' with the Cholesky factor from 'spd()'. 'x'
+	         holds 'b' on input and is overwritten with the solution.
+	 *\param [stride] Distance between adjacent entries of 'x'.
+	 */
+	static MATRICE_GLOBAL_INL void spd_bwd(const value_type* L, value_type* x, size_t stride = 1) noexcept {
+		value_type _Y[_N];
+		_Static_for<0, _N>([&](auto _I) {
+			constexpr auto i = decltype(_I)::value;
+			auto _Val = x[i * stride];
+			_Static_for<0, i>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Val -= L[i * _N + k] * _Y[k];
+			});
+			_Y[i] = _Val / L[i * _N + i];
+		});
+		_Static_for<0, _N>([&](auto _R) {
+			constexpr auto i = _N - 1 - decltype(_R)::value;
+			auto _Val = _Y[i];
+			_Static_for<i + 1, _N>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Val -= L[k * _N + i] * _Y[k];
+			});
+			_Y[i] = _Val / L[i * _N + i];
+			x[i * stride] = _Y[i];
+		});
+	}
+
+	/**
+	 *\brief Compute the inverse '(L*L^T)^{-1}' from the Cholesky factor 'L'.
+	 */
+	static MATRICE_GLOBAL_INL void ispd(const value_type* L, value_type* Inv) noexcept {
+		// \W = L^{-1}, lower triangular
+		value_type _W[_N * _N] = {};
+		_Static_for<0, _N>([&](auto _I) {
+			constexpr auto i = decltype(_I)::value;
+			const auto _Dii = value_type(1) / L[i * _N + i];
+			_W[i * _N + i] = _Dii;
+			_Static_for<0, i>([&](auto _J) {
+				constexpr auto j = decltype(_J)::value;
+				value_type _Val = 0;
+				_Static_for<j, i>([&](auto _K) {
+					constexpr auto k = decltype(_K)::value;
+					_Val -= L[i * _N + k] * _W[k * _N + j];
+				});
+				_W[i * _N + j] = _Val * _Dii;
+			});
+		});
+		// \Inv = W^T * W, symmetric
+		_Static_for<0, _N>([&](auto _I) {
+			constexpr auto i = decltype(_I)::value;
+			_Static_for<i, _N>([&](auto _J) {
+				constexpr auto j = decltype(_J)::value;
+				value_type _Val = 0;
+				_Static_for<j, _N>([&](auto _K) {
+					constexpr auto k = decltype(_K)::value;
+					_Val += _W[k * _N + i] * _W[k * _N + j];
+				});
+				Inv[i * _N + j] = Inv[j * _N + i] = _Val;
+			});
+		});
+	}
+
+	/**
+	 *\brief In-place LDL^T decomposition 'A = L*D*L^T' of a symmetric matrix,
+	         where L is unit lower triangular. The lower triangle of 'A' is
+	         read and overwritten with L, and the diagonal with D.
+	 *\return 1 for success, or '-r' if the 'r'-th (1-based) pivot vanishes.
+	 */
+	static MATRICE_GLOBAL_INL int ldlt(value_type* A) noexcept {
+		constexpr auto _Epsi = MATRICE_STD(numeric_limits)<value_type>::epsilon();
+		int _Status = 1;
+		_Static_for<0, _N>([&](auto _J) {
+			constexpr auto j = decltype(_J)::value;
+			if (_Status != 1) return;
+			// \A(j, k)*D(k) of the j-th row
+			value_type _Ld[j + 1];
+			auto _Dj = A[j * _N + j];
+			_Static_for<0, j>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Ld[k] = A[j * _N + k] * A[k * _N + k];
+				_Dj -= A[j * _N + k] * _Ld[k];
+			});
+			if (MATRICE_STD(abs)(_Dj) <= _Epsi) {
+				_Status = -int(j + 1);
+				return;
+			}
+			A[j * _N + j] = _Dj;
+			const auto _Inv = value_type(1) / _Dj;
+			_Static_for<j + 1, _N>([&](auto _I) {
+				constexpr auto i = decltype(_I)::value;
+				auto _Val = A[i * _N + j];
+				_Static_for<0, j>([&](auto _K) {
+					constexpr auto k = decltype(_K)::value;
+					_Val -= A[i * _N + k] * _Ld[k];
+				});
+				A[i * _N + j] = _Val * _Inv;
+			});
+		});
+		return _Status;
+	}
+
+	/**
+	 *\brief Solve 'L*D*L^T*x = b' with the factor from 'ldlt()'. 'x' holds
+	         'b' on input and is overwritten with the solution.
+	 */
+	static MATRICE_GLOBAL_INL void ldlt_bwd(const value_type* LD, value_type* x, size_t stride = 1) noexcept {
+		value_type _Y[_N];
+		_Static_for<0, _N>([&](auto _I) {
+			constexpr auto i = decltype(_I)::value;
+			auto _Val = x[i * stride];
+			_Static_for<0, i>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Val -= LD[i * _N + k] * _Y[k];
+			});
+			_Y[i] = _Val;
+		});
+		_Static_for<0, _N>([&](auto _R) {
+			constexpr auto i = _N - 1 - decltype(_R)::value;
+			auto _Val = _Y[i] / LD[i * _N + i];
+			_Static_for<i + 1, _N>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Val -= LD[k * _N + i] * _Y[k];
+			});
+			_Y[i] = _Val;
+			x[i * stride] = _Val;
+		});
+	}
+
+	/**
+	 *\brief In-place LU decomposition with partial pivoting 'P*A = L*U',
+	         where L is unit lower triangular. 'piv' must hold _N+1 entries,
+	         'piv[i]' is the source row of the i-th row of 'P*A' and
+	         'piv[_N]' is the parity of the permutation.
+	 *\return 0 for success, or -1 if 'A' is singular.
+	 */
+	static MATRICE_GLOBAL_INL int lud(value_type* A, int* piv) noexcept {
+		constexpr auto _Epsi = MATRICE_STD(numeric_limits)<value_type>::epsilon();
+		_Static_for<0, _N>([&](auto _I) { piv[decltype(_I)::value] = int(decltype(_I)::value); });
+		piv[_N] = 1;
+
+		int _Status = 0;
+		_Static_for<0, _N>([&](auto _J) {
+			constexpr auto j = decltype(_J)::value;
+			if (_Status != 0) return;
+			auto p = j;
+			auto _Max = MATRICE_STD(abs)(A[j * _N + j]);
+			_Static_for<j + 1, _N>([&](auto _I) {
+				constexpr auto i = decltype(_I)::value;
+				if (const auto _Val = MATRICE_STD(abs)(A[i * _N + j]); _Val > _Max) {
+					_Max = _Val, p = i;
+				}
+			});
+			if (_Max <= _Epsi * _Epsi) {
+				_Status = -1;
+				return;
+			}
+			if (p != j) {
+				_Static_for<0, _N>([&](auto _C) {
+					constexpr auto c = decltype(_C)::value;
+					MATRICE_STD(swap)(A[j * _N + c], A[p * _N + c]);
+				});
+				MATRICE_STD(swap)(piv[j], piv[p]);
+				piv[_N] = -piv[_N];
+			}
+			const auto _Inv = value_type(1) / A[j * _N + j];
+			_Static_for<j + 1, _N>([&](auto _I) {
+				constexpr auto i = decltype(_I)::value;
+				const auto _Lij = A[i * _N + j] *= _Inv;
+				_Static_for<j + 1, _N>([&](auto _C) {
+					constexpr auto c = decltype(_C)::value;
+					A[i * _N + c] -= _Lij * A[j * _N + c];
+				});
+			});
+		});
+		return _Status;
+	}
+
+	/**
+	 *\brief Solve 'A*x = b' with the factor and pivots from 'lud()'. 'x'
+	         holds 'b' on input and is overwritten with the solution.
+	 */
+	static MATRICE_GLOBAL_INL void lud_sv(const value_type* LU, value_type* x, const int* piv, size_t stride = 1) noexcept {
+		value_type _Y[_N];
+		_Static_for<0, _N>([&](auto _I) {
+			constexpr auto i = decltype(_I)::value;
+			auto _Val = x[piv[i] * stride];
+			_Static_for<0, i>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Val -= LU[i * _N + k] * _Y[k];
+			});
+			_Y[i] = _Val;
+		});
+		_Static_for<0, _N>([&](auto _R) {
+			constexpr auto i = _N - 1 - decltype(_R)::value;
+			auto _Val = _Y[i];
+			_Static_for<i + 1, _N>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Val -= LU[i * _N + k] * _Y[k];
+			});
+			_Y[i] = _Val / LU[i * _N + i];
+			x[i * stride] = _Y[i];
+		});
+	}
+
+	/**
+	 *\brief Compute the inverse of a general matrix 'A', 'Inv' may alias 'A'.
+	         Closed forms are used for _N <= 3, or else the LU decomposition.
+	 *\return 0 for success, or -1 if 'A' is singular.
+	 */
+	static MATRICE_GLOBAL_INL int inv(const value_type* A, value_type* Inv) noexcept {
+		if constexpr (_N == 1) {
+			if (A[0] == value_type(0)) return -1;
+			Inv[0] = value_type(1) / A[0];
+			return 0;
+		}
+		else if constexpr (_N == 2) {
+			const auto _Det = A[0] * A[3] - A[1] * A[2];
+			if (_Det == value_type(0)) return -1;
+			const auto _Idet = value_type(1) / _Det;
+			const value_type _Ret[4] = { A[3] * _Idet, -A[1] * _Idet, -A[2] * _Idet, A[0] * _Idet };
+			_Static_for<0, 4>([&](auto _I) { Inv[decltype(_I)::value] = _Ret[decltype(_I)::value]; });
+			return 0;
+		}
+		else if constexpr (_N == 3) {
+			value_type _Ret[9];
+			_Ret[0] = A[4] * A[8] - A[5] * A[7];
+			_Ret[1] = A[2] * A[7] - A[1] * A[8];
+			_Ret[2] = A[1] * A[5] - A[2] * A[4];
+			_Ret[3] = A[5] * A[6] - A[3] * A[8];
+			_Ret[4] = A[0] * A[8] - A[2] * A[6];
+			_Ret[5] = A[2] * A[3] - A[0] * A[5];
+			_Ret[6] = A[3] * A[7] - A[4] * A[6];
+			_Ret[7] = A[1] * A[6] - A[0] * A[7];
+			_Ret[8] = A[0] * A[4] - A[1] * A[3];
+			const auto _Det = A[0] * _Ret[0] + A[1] * _Ret[3] + A[2] * _Ret[6];
+			if (_Det == value_type(0)) return -1;
+			const auto _Idet = value_type(1) / _Det;
+			_Static_for<0, 9>([&](auto _I) { Inv[decltype(_I)::value] = _Ret[decltype(_I)::value] * _Idet; });
+			return 0;
+		}
+		else {
+			value_type _LU[_N * _N];
+			int _Piv[_N + 1];
+			_Static_for<0, _N * _N>([&](auto _I) { _LU[decltype(_I)::value] = A[decltype(_I)::value]; });
+			if (const auto _Status = lud(_LU, _Piv); _Status != 0) return _Status;
+			_Static_for<0, _N>([&](auto _C) {
+				constexpr auto c = decltype(_C)::value;
+				_Static_for<0, _N>([&](auto _R) {
+					constexpr auto r = decltype(_R)::value;
+					Inv[r * _N + c] = value_type(r == c);
+				});
+				lud_sv(_LU, Inv + c, _Piv, _N);
+			});
+			return 0;
+		}
+	}
+
+	/**
+	 *\brief Solve 'A*x = b' for a general matrix 'A', which is left intact.
+	 *\return 0 for success, or -1 if 'A' is singular.
+	 */
+	static MATRICE_GLOBAL_INL int solve(const value_type* A, value_type* x, size_t stride = 1) noexcept {
+		value_type _LU[_N * _N];
+		int _Piv[_N + 1];
+		_Static_for<0, _N * _N>([&](auto _I) { _LU[decltype(_I)::value] = A[decltype(_I)::value]; });
+		if (const auto _Status = lud(_LU, _Piv); _Status != 0) return _Status;
+		lud_sv(_LU, x, _Piv, stride);
+		return 0;
+	}
+};
+
+/// <summary>
+/// \brief Batched Cholesky kernels, which factorize and solve _W symmetric
+/// positive definite _N x _N systems at once. The operands are stored in
+/// structure-of-arrays layout with the system index running fastest, i.e.,
+/// the entry (i, j) of the l-th system is 'A[(i*_N + j)*_W + l]' and the i-th
+/// entry of its rhs is 'b[i*_W + l]'. Each step is vectorized across the
+/// systems with simd::Packet_ if SIMD is enabled.
+/// </summary>
+/// <typeparam name="_Ty">float or double</typeparam>
+/// <typeparam name="_N">Dimension of each system</typeparam>
+/// <typeparam name="_W">Number of systems</typeparam>
+template<typename _Ty, size_t _N, size_t _W> struct _Small_batch_kernel {
+	static_assert(_N > 0 && _N <= MATRICE_SMALL_LINALG_MAXDIM,
+		"_N of _Small_batch_kernel<_Ty, _N, _W> is out of range.");
+	using value_type = _Ty;
+	static constexpr size_t dimension = _N, width = _W;
+
+	/**
+	 *\brief In-place batched Cholesky decomposition. The upper triangle of
+	         each system is read, L is written to the lower triangle and the
+	         diagonal holds the reciprocals of L(i, i), so that the solves are
+	         free of divisions. Lanes with a non-positive pivot get a zero
+	         reciprocal and thus a zero solution.
+	 */
+	static MATRICE_HOST_INL void spd(value_type* A) noexcept {
+		_Static_for<0, _N>([&](auto _J) {
+			constexpr auto j = decltype(_J)::value;
+			const auto _Djj = A + (j * _N + j) * _W;
+			_Static_for<0, j>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Msub(_Djj, A + (j * _N + k) * _W, A + (j * _N + k) * _W);
+			});
+			for (size_t l = 0; l < _W; ++l) {
+				_Djj[l] = _Djj[l] > value_type(0) ?
+					value_type(1) / MATRICE_STD(sqrt)(_Djj[l]) : value_type(0);
+			}
+			_Static_for<j + 1, _N>([&](auto _I) {
+				constexpr auto i = decltype(_I)::value;
+				const auto _Lij = A + (i * _N + j) * _W;
+				const auto _Aji = A + (j * _N + i) * _W;
+				for (size_t l = 0; l < _W; ++l) _Lij[l] = _Aji[l];
+				_Static_for<0, j>([&](auto _K) {
+					constexpr auto k = decltype(_K)::value;
+					_Msub(_Lij, A + (i * _N + k) * _W, A + (j * _N + k) * _W);
+				});
+				_Mul(_Lij, _Djj);
+			});
+		});
+	}
+
+	/**
+	 *\brief Batched solve of 'L*L^T*x = b' with the factors from 'spd()'.
+	         'b' is overwritten with the solutions.
+	 */
+	static MATRICE_HOST_INL void spd_bwd(const value_type* L, value_type* b) noexcept {
+		_Static_for<0, _N>([&](auto _I) {
+			constexpr auto i = decltype(_I)::value;
+			const auto _Bi = b + i * _W;
+			_Static_for<0, i>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Msub(_Bi, L + (i * _N + k) * _W, b + k * _W);
+			});
+			_Mul(_Bi, L + (i * _N + i) * _W);
+		});
+		_Static_for<0, _N>([&](auto _R) {
+			constexpr auto i = _N - 1 - decltype(_R)::value;
+			const auto _Bi = b + i * _W;
+			_Static_for<i + 1, _N>([&](auto _K) {
+				constexpr auto k = decltype(_K)::value;
+				_Msub(_Bi, L + (k * _N + i) * _W, b + k * _W);
+			});
+			_Mul(_Bi, L + (i * _N + i) * _W);
+		});
+	}
+
+	/**
+	 *\brief Batched solve of 'A*x = b', where 'A' is overwritten with the
+	         factors and 'b' with the solutions.
+	 */
+	static MATRICE_HOST_INL void spd_solve(value_type* A, value_type* b) noexcept {
+		spd(A);
+		spd_bwd(A, b);
+	}
+
+private:
+#ifdef MATRICE_SIMD_ARCH
+	using packet_type = simd::Packet_<value_type>;
+	static constexpr size_t _Step = _W % packet_type::size == 0 ? packet_type::size : 1;
+#endif
+	// \_Acc[l] -= _A[l] * _B[l]
+	static MATRICE_HOST_FINL void _Msub(value_type* _Acc, const value_type* _A, const value_type* _B) noexcept {
+#ifdef MATRICE_SIMD_ARCH
+		if constexpr (_Step > 1) {
+			for (size_t l = 0; l < _W; l += _Step) {
+				(packet_type(_Acc + l) - packet_type(const_cast<value_type*>(_A + l)) *
+					packet_type(const_cast<value_type*>(_B + l))).unpack(_Acc + l);
+			}
+			return;
+		}
+#endif
+		for (size_t l = 0; l < _W; ++l) _Acc[l] -= _A[l] * _B[l];
+	}
+	// \_Dst[l] *= _S[l]
+	static MATRICE_HOST_FINL void _Mul(value_type* _Dst, const value_type* _S) noexcept {
+#ifdef MATRICE_SIMD_ARCH
+		if constexpr (_Step > 1) {
+			for (size_t l = 0; l < _W; l += _Step) {
+				(packet_type(_Dst + l) * packet_type(const_cast<value_type*>(_S + l))).unpack(_Dst + l);
+			}
+			return;
+		}
+#endif
+		for (size_t l = 0; l < _W; ++l) _Dst[l] *= _S[l];
+	}
+};
+_DETAIL_END
+DGE_MATRICE_END
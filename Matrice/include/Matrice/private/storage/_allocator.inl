@@ -20,6 +20,7 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include "util/_exception.h"
 #include "../_storage.hpp"
 #include "../_memory.h"
+#include "_memory_pool.h"
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -270,33 +271,23 @@ MATRICE_GLOBAL_INL decltype(auto) make_alloc_deleter(_Tag) {
 }
 
 namespace impl {
+// \heap blocks are served by 'memory_pool', which recycles them in a
+// \memory_pool::scope and falls back to the system heap otherwise.
 template<typename _Ty>
 MATRICE_HOST_INL _Ty* _Malloc(size_t size, heap_alloc_tag) {
-	MATRICE_USE_STD(_New_alignof);
-	constexpr auto _Align = _Maxval<size_t>(_New_alignof<_Ty>, MATRICE_ALIGN_BYTES);
-	return static_cast<_Ty*>(std::_Allocate<_Align>(size*sizeof(_Ty)));
+	static_assert(alignof(_Ty) <= MATRICE_ALIGN_BYTES, 
+		"Over-aligned types are not supported by the heap allocator.");
+	return static_cast<_Ty*>(memory_pool::allocate(size*sizeof(_Ty)));
 }
 
 template<typename _Ty>
 MATRICE_HOST_INL void _Free(_Ty* data, heap_alloc_tag) {
-	if (data != nullptr) {
-		auto void_ptr = reinterpret_cast<void*>(data);
-		if (void_ptr) {
-			MATRICE_USE_STD(free);
-			free(*(reinterpret_cast<void**>(void_ptr) - 1));
-			data = nullptr;
-		}
-	}
+	memory_pool::deallocate(reinterpret_cast<void*>(data));
 }
 
 template<typename _Ty> MATRICE_HOST_INL 
 void _Free(_Ty* data, size_t size, heap_alloc_tag) {
-	constexpr size_t _Big_allocation_sentinel = 0xFAFAFAFAFAFAFAFAULL;
-	MATRICE_USE_STD(_New_alignof);
-	if (data && size < _Big_allocation_sentinel) {
-		constexpr auto _Align = _Maxval<size_t>(_New_alignof<_Ty>, MATRICE_ALIGN_BYTES);
-		std::_Deallocate<_Align>(data, size);
-	}
+	memory_pool::deallocate(reinterpret_cast<void*>(data));
 }
 
 MATRICE_HOST_INL decltype(auto) _Deleter(stack_alloc_tag) noexcept {
@@ -0,0 +1,209 @@
+/**************************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+#pragma once
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include "util/_macros.h"
+#include "../_memory.h"
+
+DGE_MATRICE_BEGIN
+/// <summary>
+/// \brief Allocation counters of the calling thread.
+/// </summary>
+struct memory_stats {
+	size_t requests = 0;      // heap blocks requested by containers
+	size_t hits = 0;          // requests served by the pool
+	size_t system_allocs = 0; // requests served by the system heap
+	size_t system_frees = 0;  // blocks returned to the system heap
+	size_t cached_bytes = 0;  // bytes held by the pool
+};
+
+/// <summary>
+/// \brief Thread-local size-class pool for the heap blocks of dynamic
+/// matrices. Every heap block carries a small header, so a block can be
+/// released no matter it comes from the pool or from the system heap.
+/// Pooling is off by default, and it is turned on for the calling thread
+/// by a 'memory_pool::scope' object:
+///		{ memory_pool::scope _Pooled; /* temporaries are recycled here */ }
+/// While pooling is on, a released block is cached in its size class and
+/// reused by the next request of the same class. Cached blocks are kept
+/// until release() is called or the thread exits.
+/// </summary>
+class memory_pool {
+	using _Myt = memory_pool;
+	// \capacity of class c is 2^(c + _Minbits) bytes
+	static constexpr size_t _Minbits = 6, _Nclasses = 21;
+	static constexpr uint32_t _System = ~uint32_t(0);
+	static constexpr size_t _Align = MATRICE_ALIGN_BYTES;
+	struct _Header {
+		void* raw;
+		uint32_t cls;
+	};
+	static_assert(sizeof(_Header) <= _Align, "Header must fit in the alignment.");
+
+	struct _Cache {
+		MATRICE_STD(vector)<void*> lists[_Nclasses];
+		memory_stats stats;
+		size_t depth = 0;
+		// \upper bound of the cached bytes
+		size_t limit = size_t(1) << 28;
+		~_Cache() { _Myt::_Trim(*this); _Mydead() = true; }
+	};
+	// \set once the cache of the calling thread is destroyed, it is trivially 
+	// destructible, so it can be read by static objects freed at exit.
+	static MATRICE_HOST_INL bool& _Mydead() noexcept {
+		static thread_local bool _Dead = false;
+		return (_Dead);
+	}
+	static MATRICE_HOST_INL _Cache* _Mycache() noexcept {
+		if (_Mydead()) return nullptr;
+		static thread_local _Cache _Inst;
+		return (&_Inst);
+	}
+
+public:
+	/// <summary>
+	/// \brief RAII context which turns on pooling for the calling thread.
+	/// </summary>
+	class scope {
+	public:
+		scope() noexcept { if (const auto _Cache = _Mycache()) ++_Cache->depth; }
+		~scope() noexcept { if (const auto _Cache = _Mycache()) --_Cache->depth; }
+		scope(const scope&) = delete;
+		scope& operator=(const scope&) = delete;
+	};
+
+	/**
+	 *\brief Check if pooling is on for the calling thread.
+	 */
+	static MATRICE_HOST_INL bool enabled() noexcept {
+		const auto _Cache = _Mycache();
+		return _Cache && _Cache->depth > 0;
+	}
+
+	/**
+	 *\brief Get or reset the allocation counters of the calling thread.
+	 */
+	static MATRICE_HOST_INL memory_stats stats() noexcept {
+		const auto _Cache = _Mycache();
+		return _Cache ? _Cache->stats : memory_stats{};
+	}
+	static MATRICE_HOST_INL void reset_stats() noexcept {
+		const auto _Cache = _Mycache();
+		if (!_Cache) return;
+		auto& _Stats = _Cache->stats;
+		const auto _Cached = _Stats.cached_bytes;
+		_Stats = memory_stats{};
+		_Stats.cached_bytes = _Cached;
+	}
+
+	/**
+	 *\brief Set the upper bound of the bytes cached by the calling thread.
+	 */
+	static MATRICE_HOST_INL void set_limit(size_t _Bytes) noexcept {
+		if (const auto _Cache = _Mycache()) _Cache->limit = _Bytes;
+	}
+
+	/**
+	 *\brief Return all cached blocks of the calling thread to the system.
+	 */
+	static MATRICE_HOST_INL void release() noexcept {
+		if (const auto _Cache = _Mycache()) _Trim(*_Cache);
+	}
+
+	/**
+	 *\brief Allocate '_Bytes' bytes aligned to MATRICE_ALIGN_BYTES.
+	 */
+	static MATRICE_HOST_INL void* allocate(size_t _Bytes) {
+		const auto _Cache = _Mycache();
+		auto _Cls = _System;
+		if (_Cache) {
+			++_Cache->stats.requests;
+			if (_Cache->depth > 0) {
+				_Cls = _Class_of(_Bytes);
+				if (_Cls != _System) {
+					auto& _List = _Cache->lists[_Cls];
+					if (!_List.empty()) {
+						const auto _Ptr = _List.back();
+						_List.pop_back();
+						++_Cache->stats.hits;
+						_Cache->stats.cached_bytes -= _Capacity(_Cls);
+						return _Ptr;
+					}
+					_Bytes = _Capacity(_Cls);
+				}
+			}
+		}
+
+		const auto _Raw = MATRICE_STD(malloc)(_Bytes + (_Align << 1));
+		if (!_Raw) throw MATRICE_STD(bad_alloc)();
+		if (_Cache) ++_Cache->stats.system_allocs;
+		const auto _Addr = (reinterpret_cast<uintptr_t>(_Raw) + (_Align << 1) - 1) & ~uintptr_t(_Align - 1);
+		const auto _Ptr = reinterpret_cast<void*>(_Addr);
+		*_Header_of(_Ptr) = _Header{ _Raw, _Cls };
+		return _Ptr;
+	}
+
+	/**
+	 *\brief Release a block from allocate(...), which is cached if pooling
+	          is on for the calling thread. It goes to the system heap if the
+	          cache cannot grow, or is destroyed at the thread exit.
+	 */
+	static MATRICE_HOST_INL void deallocate(void* _Ptr) noexcept {
+		if (!_Ptr) return;
+		const auto _Cache = _Mycache();
+		const auto _Hdr = *_Header_of(_Ptr);
+		if (_Cache && _Hdr.cls != _System && _Cache->depth > 0 &&
+			_Cache->stats.cached_bytes + _Capacity(_Hdr.cls) <= _Cache->limit) {
+			try {
+				_Cache->lists[_Hdr.cls].push_back(_Ptr);
+				_Cache->stats.cached_bytes += _Capacity(_Hdr.cls);
+				return;
+			}
+			catch (...) {}
+		}
+		if (_Cache) ++_Cache->stats.system_frees;
+		MATRICE_STD(free)(_Hdr.raw);
+	}
+
+private:
+	static MATRICE_HOST_INL _Header* _Header_of(void* _Ptr) noexcept {
+		return reinterpret_cast<_Header*>(reinterpret_cast<char*>(_Ptr) - _Align);
+	}
+	static MATRICE_HOST_INL constexpr size_t _Capacity(size_t _Cls) noexcept {
+		return size_t(1) << (_Cls + _Minbits);
+	}
+	static MATRICE_HOST_INL uint32_t _Class_of(size_t _Bytes) noexcept {
+		uint32_t _Cls = 0;
+		while (_Cls < _Nclasses && _Capacity(_Cls) < _Bytes) ++_Cls;
+		return _Cls < _Nclasses ? _Cls : _System;
+	}
+	static MATRICE_HOST_INL void _Trim(_Cache& _Cache) noexcept {
+		for (auto& _List : _Cache.lists) {
+			for (const auto _Ptr : _List) {
+				MATRICE_STD(free)(_Header_of(_Ptr)->raw);
+				++_Cache.stats.system_frees;
+			}
+			_List.clear();
+		}
+		_Cache.stats.cached_bytes = 0;
+	}
+};
+DGE_MATRICE_END
@@ -0,0 +1,310 @@
+/*******************************************************************************
+* Copyright 2018-2021 IVM (R) DGELOM
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <exception>
+#include <future>
+#include <functional>
+#include <type_traits>
+#include <condition_variable>
+
+namespace dgelom {
+namespace impl {
+
+/* Work-stealing task pool:
+ *  - submit(f)                  - enqueues f() to the local queue of the
+ *                                 calling worker, or round-robin otherwise
+ *  - wait()                     - blocks until all submitted tasks finished;
+ *                                 workers help to drain the queues instead
+ *                                 of blocking
+ *  - parallel_for(n, grain, f)  - splits [0, n) into chunks of 'grain' and
+ *                                 calls f(i, ithr) for each index, where
+ *                                 ithr is the index of the executing worker
+ *                                 in [0, size())
+ *  - async(f)                   - enqueues f() and returns a std::future
+ *                                 of its result
+ * A _Task_group collects tasks that can be waited for on their own.
+ * Each worker pops its own queue from the back (LIFO) and steals from the
+ * front (FIFO) of the others, so irregular tasks are balanced dynamically.
+ */
+class _Task_pool {
+	using _Myt = _Task_pool;
+	friend class _Task_group;
+public:
+	using task_type = std::function<void()>;
+
+	explicit _Task_pool(size_t _Nthr = 0) {
+		if (_Nthr == 0) _Nthr = std::thread::hardware_concurrency();
+		if (_Nthr == 0) _Nthr = 1;
+		_Myqueues.reset(new _Queue[_Nthr]);
+		_Mysize = _Nthr;
+		_Mythreads.reserve(_Nthr);
+		for (size_t _Idx = 0; _Idx < _Nthr; ++_Idx) {
+			_Mythreads.emplace_back([this, _Idx] { _Run(_Idx); });
+		}
+	}
+	_Task_pool(const _Myt&) = delete;
+	_Task_pool(_Myt&&) = delete;
+	~_Task_pool() {
+		{
+			std::lock_guard<std::mutex> _Lock(_Mymtx);
+			_Mystop = true;
+		}
+		_Mycv.notify_all();
+		for (auto& _Thr : _Mythreads) {
+			if (_Thr.joinable()) _Thr.join();
+		}
+	}
+
+	/**
+	 *\brief Number of worker threads.
+	 */
+	size_t size() const noexcept { return _Mysize; }
+
+	/**
+	 *\brief Index of the calling worker in this pool, or size() if the
+	          caller is not a worker of this pool.
+	 */
+	size_t this_worker() const noexcept {
+		return _Myowner == this ? _Myworker : _Mysize;
+	}
+
+	/**
+	 *\brief Enqueue a task.
+	 */
+	template<typename _Fn>
+	void submit(_Fn&& _Task) {
+		++_Mypending;
+		auto _Idx = this_worker();
+		if (_Idx == _Mysize) _Idx = _Mynext++ % _Mysize;
+		{
+			std::lock_guard<std::mutex> _Lock(_Myqueues[_Idx]._Mtx);
+			_Myqueues[_Idx]._Tasks.emplace_back(std::forward<_Fn>(_Task));
+		}
+		++_Myqueued;
+		{
+			std::lock_guard<std::mutex> _Lock(_Mymtx);
+		}
+		_Mycv.notify_one();
+	}
+
+	/**
+	 *\brief Enqueue a task and get the future of its result. Note that a 
+	         worker blocked on a future does not execute other tasks, use a
+	         _Task_group for nested waits instead.
+	 */
+	template<typename _Fn>
+	auto async(_Fn&& _Func) {
+		using result_type = std::invoke_result_t<std::decay_t<_Fn>>;
+		auto _Task = std::make_shared<std::packaged_task<result_type()>>(std::forward<_Fn>(_Func));
+		auto _Future = _Task->get_future();
+		submit([_Task] { (*_Task)(); });
+		return _Future;
+	}
+
+	/**
+	 *\brief Wait for all submitted tasks. The first exception thrown by a
+	         task is rethrown here.
+	 */
+	void wait() {
+		_Wait_for(_Mypending);
+		_Rethrow(_Myexcept);
+	}
+
+	/**
+	 *\brief Parallel loop over [0, _N) with dynamic load balancing. It is
+	         safe to be nested, since waiting workers keep executing tasks.
+	 *\param [_N] loop count, [_Grain] chunk size (0 for auto),
+	         [_Fn] kernel with signature f(size_t i, size_t ithr).
+	 */
+	template<typename _Fn>
+	void parallel_for(size_t _N, size_t _Grain, _Fn&& _Func) {
+		if (_N == 0) return;
+		if (_Grain == 0) _Grain = (std::max)(size_t(1), _N / (_Mysize << 3));
+
+		std::atomic<size_t> _Left{ (_N + _Grain - 1) / _Grain };
+		std::exception_ptr _Except;
+		for (size_t _Begin = 0; _Begin < _N; _Begin += _Grain) {
+			const auto _End = (std::min)(_Begin + _Grain, _N);
+			submit([&, _Begin, _End] {
+				try {
+					const auto _Ithr = this_worker();
+					for (auto _Idx = _Begin; _Idx < _End; ++_Idx)
+						_Func(_Idx, _Ithr);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> _Lock(_Mymtx);
+					if (!_Except) _Except = std::current_exception();
+				}
+				if (--_Left == 0) {
+					std::lock_guard<std::mutex> _Lock(_Mymtx);
+					_Mydone.notify_all();
+				}
+			});
+		}
+		_Wait_for(_Left);
+		_Rethrow(_Except);
+	}
+
+private:
+	struct _Queue {
+		std::mutex _Mtx;
+		std::deque<task_type> _Tasks;
+	};
+
+	bool _Pop(size_t _Idx, task_type& _Task) {
+		auto& _Q = _Myqueues[_Idx];
+		std::lock_guard<std::mutex> _Lock(_Q._Mtx);
+		if (_Q._Tasks.empty()) return false;
+		_Task = std::move(_Q._Tasks.back());
+		_Q._Tasks.pop_back();
+		--_Myqueued;
+		return true;
+	}
+	bool _Steal(size_t _Idx, task_type& _Task) {
+		for (size_t _Off = 1; _Off < _Mysize; ++_Off) {
+			auto& _Q = _Myqueues[(_Idx + _Off) % _Mysize];
+			std::unique_lock<std::mutex> _Lock(_Q._Mtx, std::try_to_lock);
+			if (!_Lock || _Q._Tasks.empty()) continue;
+			_Task = std::move(_Q._Tasks.front());
+			_Q._Tasks.pop_front();
+			--_Myqueued;
+			return true;
+		}
+		return false;
+	}
+	void _Wait_for(const std::atomic<size_t>& _Count) {
+		if (const auto _Idx = this_worker(); _Idx != _Mysize) {
+			task_type _Task;
+			while (_Count.load() != 0) {
+				if (_Pop(_Idx, _Task) || _Steal(_Idx, _Task))
+					_Exec(_Task);
+				else
+					std::this_thread::yield();
+			}
+		}
+		else {
+			std::unique_lock<std::mutex> _Lock(_Mymtx);
+			_Mydone.wait(_Lock, [&_Count] { return _Count.load() == 0; });
+		}
+	}
+	void _Rethrow(std::exception_ptr& _Except) {
+		if (_Except) {
+			auto _Tmp = _Except;
+			_Except = nullptr;
+			std::rethrow_exception(_Tmp);
+		}
+	}
+	void _Exec(task_type& _Task) {
+		try {
+			_Task();
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> _Lock(_Mymtx);
+			if (!_Myexcept) _Myexcept = std::current_exception();
+		}
+		_Task = nullptr;
+		if (--_Mypending == 0) {
+			std::lock_guard<std::mutex> _Lock(_Mymtx);
+			_Mydone.notify_all();
+		}
+	}
+	void _Run(size_t _Idx) {
+		_Myowner = this, _Myworker = _Idx;
+		task_type _Task;
+		for (;;) {
+			if (_Pop(_Idx, _Task) || _Steal(_Idx, _Task)) {
+				_Exec(_Task);
+				continue;
+			}
+			std::unique_lock<std::mutex> _Lock(_Mymtx);
+			_Mycv.wait(_Lock, [this] {
+				return _Mystop || _Myqueued.load() != 0;
+			});
+			if (_Mystop && _Myqueued.load() == 0) return;
+		}
+	}
+
+	size_t _Mysize = 0;
+	std::unique_ptr<_Queue[]> _Myqueues;
+	std::vector<std::thread> _Mythreads;
+	std::mutex _Mymtx;
+	std::condition_variable _Mycv, _Mydone;
+	std::atomic<size_t> _Mypending{ 0 }, _Myqueued{ 0 }, _Mynext{ 0 };
+	std::exception_ptr _Myexcept;
+	bool _Mystop = false;
+
+	inline static thread_local const _Myt* _Myowner = nullptr;
+	inline static thread_local size_t _Myworker = 0;
+};
+
+/* Task group on a _Task_pool:
+ *  - run(f)                     - enqueues f() as a task of the group
+ *  - wait()                     - waits for the tasks of this group only,
+ *                                 and rethrows the first exception of them;
+ *                                 a waiting worker keeps executing tasks,
+ *                                 so groups can be nested
+ */
+class _Task_group {
+	using _Myt = _Task_group;
+public:
+	explicit _Task_group(_Task_pool& _Pool) noexcept : _Mypool(_Pool) {}
+	_Task_group(const _Myt&) = delete;
+	~_Task_group() {
+		_Mypool._Wait_for(_Myleft);
+	}
+
+	template<typename _Fn>
+	void run(_Fn&& _Func) {
+		++_Myleft;
+		// the group may be destroyed by a waiter as soon as '_Myleft' drops
+		// to 0, so only the pool is touched after the decrement.
+		_Mypool.submit([&_Pool = _Mypool, this, _Func = std::forward<_Fn>(_Func)]() mutable {
+			try {
+				_Func();
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> _Lock(_Pool._Mymtx);
+				if (!_Myexcept) _Myexcept = std::current_exception();
+			}
+			if (--_Myleft == 0) {
+				std::lock_guard<std::mutex> _Lock(_Pool._Mymtx);
+				_Pool._Mydone.notify_all();
+			}
+		});
+	}
+
+	void wait() {
+		_Mypool._Wait_for(_Myleft);
+		_Mypool._Rethrow(_Myexcept);
+	}
+
+private:
+	_Task_pool& _Mypool;
+	std::atomic<size_t> _Myleft{ 0 };
+	std::exception_ptr _Myexcept;
+};
+
+} // namespace impl
+using task_pool = impl::_Task_pool;
+using task_group = impl::_Task_group;
+} // namespace dgelom
@@ -20,6 +20,7 @@
 #define MATRICE_THR_SEQ 0
 #define MATRICE_THR_OMP 1
 #define MATRICE_THR_TBB 2
+#define MATRICE_THR_NATIVE 3
 
 /* Ideally this condition below should never happen (if the library is built
  * using regular cmake). For the 3rd-party projects that build the library
@@ -88,6 +89,36 @@ inline void _Host_thr_barrier() { assert(!"no barrier in TBB"); }
 
 #define PRAGMA_OMP(...)
 
+#elif MATRICE_THR == MATRICE_THR_NATIVE
+#include <cassert>
+#include "_task_pool.h"
+#define MATRICE_THR_SYNC 0
+
+namespace dgelom {
+namespace impl {
+/* The process-wide work-stealing pool and the team of the calling thread,
+ * which is set while the thread runs a region of parallel(...). */
+inline _Task_pool& _Native_pool() {
+	static _Task_pool _Pool;
+	return _Pool;
+}
+struct _Native_team { int size = 1, id = 0; };
+inline _Native_team& _Native_this_team() noexcept {
+	static thread_local _Native_team _Team;
+	return _Team;
+}
+} // namespace impl
+} // namespace dgelom
+
+inline int _Get_max_threads()
+{ return int(dgelom::impl::_Native_pool().size()); }
+inline int _Get_num_threads() { return dgelom::impl::_Native_this_team().size; }
+inline int _Get_thread_num() { return dgelom::impl::_Native_this_team().id; }
+inline int _In_parallel() { return _Get_num_threads() > 1; }
+inline void _Host_thr_barrier() { assert(!"no barrier in the native backend"); }
+
+#define PRAGMA_OMP(...)
+
 #endif
 
 /* MSVC still supports omp 2.0 only */
@@ -121,6 +152,7 @@ namespace utils {
 	}
 }
 
+template<typename _Fn> inline void parallel(int _Nt, _Fn&& fn);
 template<size_t _Nt, typename _Fn> inline void parallel(_Fn&& fn);
 template<typename... _Args> inline void for_nd(const int ithr, const int _Nt, const _Args&... _args);
 template<typename... _Args> inline void parallel_nd(_Args&&... args);
@@ -31,6 +31,8 @@
  *                                     calls for_nd
  *  - parallel_nd_in_omp(dims..., f) - queries current _Nt and ithr and then
  *                                     calls for_nd (mostly for convenience)
+ * With MATRICE_THR_NATIVE, parallel_nd splits the work into more chunks
+ * than threads, which are balanced dynamically by the work-stealing pool.
  */
 
 namespace dgelom { namespace impl {
@@ -114,6 +116,15 @@ inline void parallel(int _Nt, F&& f) {
 #elif MATRICE_THR == MATRICE_THR_TBB
     if (_Nt == 1) { f(0, 1); return; }
     tbb::parallel_for(0, _Nt, [&](int ithr) { f(ithr, _Nt); });
+#elif MATRICE_THR == MATRICE_THR_NATIVE
+    if (_Nt == 1) { f(0, 1); return; }
+    _Native_pool().parallel_for(size_t(_Nt), 1, [&](size_t ithr, size_t) {
+        auto& _Team = _Native_this_team();
+        const auto _Prev = _Team;
+        _Team = { _Nt, int(ithr) };
+        f(int(ithr), _Nt);
+        _Team = _Prev;
+    });
 #endif
 	 return;
 }
@@ -134,6 +145,9 @@ inline void parallel(_Fn&& fn) {
 #elif MATRICE_THR == MATRICE_THR_TBB
 	if constexpr (_Nt == 1) { fn(0, 1); return; }
 	tbb::parallel_for(0, _Nt, [&](int ithr) { fn(ithr, _Nt); });
+#elif MATRICE_THR == MATRICE_THR_NATIVE
+	if constexpr (_Nt == 1) { fn(0, 1); return; }
+	parallel(int(_Nt), fn);
 #endif
 }
 
@@ -142,7 +156,7 @@ inline void parallel(_Fn&& fn) {
 template <typename T0, typename F>
 inline void for_nd(const int ithr, const int _Nt, const T0 &D0, F&& f) {
     T0 start{0}, end{0};
-    _Gen_balance211(D0, _Nt, ithr, start, end);
+    utils::_Gen_balance211(D0, _Nt, ithr, start, end);
     for (T0 d0 = start; d0 < end; ++d0) f(d0);
 }
 
@@ -151,7 +165,7 @@ inline void for_nd(const int ithr, const int _Nt, const T0 &D0, const T1 &D1, F&
     const size_t work_amount = (size_t)D0 * D1;
     if (work_amount == 0) return;
     size_t start{0}, end{0};
-    _Gen_balance211(work_amount, _Nt, ithr, start, end);
+    utils::_Gen_balance211(work_amount, _Nt, ithr, start, end);
 
     T0 d0{0}; T1 d1{0};
     utils::_Nd_iterator_init(start, d0, D0, d1, D1);
@@ -167,7 +181,7 @@ inline void for_nd(const int ithr, const int _Nt, const T0 &D0, const T1 &D1,
     const size_t work_amount = (size_t)D0 * D1 * D2;
     if (work_amount == 0) return;
     size_t start{0}, end{0};
-    _Gen_balance211(work_amount, _Nt, ithr, start, end);
+    utils::_Gen_balance211(work_amount, _Nt, ithr, start, end);
 
     T0 d0{0}; T1 d1{0}; T2 d2{0};
     utils::_Nd_iterator_init(start, d0, D0, d1, D1, d2, D2);
@@ -183,7 +197,7 @@ inline void for_nd(const int ithr, const int _Nt, const T0 &D0, const T1 &D1,
     const size_t work_amount = (size_t)D0 * D1 * D2 * D3;
     if (work_amount == 0) return;
     size_t start{0}, end{0};
-    _Gen_balance211(work_amount, _Nt, ithr, start, end);
+    utils::_Gen_balance211(work_amount, _Nt, ithr, start, end);
 
     T0 d0{0}; T1 d1{0}; T2 d2{0}; T3 d3{0};
     utils::_Nd_iterator_init(start, d0, D0, d1, D1, d2, D2, d3, D3);
@@ -200,7 +214,7 @@ inline void for_nd(const int ithr, const int _Nt, const T0 &D0, const T1 &D1,
     const size_t work_amount = (size_t)D0 * D1 * D2 * D3 * D4;
     if (work_amount == 0) return;
     size_t start{0}, end{0};
-    _Gen_balance211(work_amount, _Nt, ithr, start, end);
+    utils::_Gen_balance211(work_amount, _Nt, ithr, start, end);
 
     T0 d0{0}; T1 d1{0}; T2 d2{0}; T3 d3{0}; T4 d4{0};
     utils::_Nd_iterator_init(start, d0, D0, d1, D1, d2, D2, d3, D3, d4, D4);
@@ -217,7 +231,7 @@ inline void for_nd(const int ithr, const int _Nt, const T0 &D0, const T1 &D1,
     const size_t work_amount = (size_t)D0 * D1 * D2 * D3 * D4 * D5;
     if (work_amount == 0) return;
     size_t start{0}, end{0};
-    _Gen_balance211(work_amount, _Nt, ithr, start, end);
+    utils::_Gen_balance211(work_amount, _Nt, ithr, start, end);
 
     T0 d0{0}; T1 d1{0}; T2 d2{0}; T3 d3{0}; T4 d4{0}; T5 d5{0};
     utils::_Nd_iterator_init(start, d0, D0, d1, D1, d2, D2, d3, D3, d4, D4,
@@ -250,6 +264,20 @@ inline void parallel_nd(Args &&...args) {
         const int ithr = !do_parallel ? 0 : _Get_thread_num();
         for_nd(ithr, _Nt, std::forward<Args>(args)...);
     }
+#elif MATRICE_THR == MATRICE_THR_NATIVE
+    const auto work_amount = _Get_work_amount(std::forward<Args>(args)...);
+    if (work_amount <= 1) { for_nd(0, 1, args...); return; }
+    // over-decompose the work into chunks balanced by work stealing,
+    // each chunk runs as a member of a team of _Nchunks as in parallel(...)
+    auto& _Pool = _Native_pool();
+    const auto _Nchunks = int((std::min)(work_amount, _Pool.size() << 3));
+    _Pool.parallel_for(size_t(_Nchunks), 1, [&](size_t _Chunk, size_t) {
+        auto& _Team = _Native_this_team();
+        const auto _Prev = _Team;
+        _Team = { _Nchunks, int(_Chunk) };
+        for_nd(int(_Chunk), _Nchunks, args...);
+        _Team = _Prev;
+    });
 #endif
 }
 #else // MATRICE_THR != MATRICE_THR_TBB
@@ -314,7 +342,7 @@ template <typename ...Args>
 inline void parallel_nd_in_omp(Args &&...args) {
 #if MATRICE_THR == MATRICE_THR_SEQ
     for_nd(0, 1, std::forward<Args>(args)...);
-#elif MATRICE_THR == MATRICE_THR_OMP
+#elif MATRICE_THR == MATRICE_THR_OMP || MATRICE_THR == MATRICE_THR_NATIVE
     for_nd(_Get_thread_num(), _Get_num_threads(),
             std::forward<Args>(args)...);
 #elif MATRICE_THR == MATRICE_THR_TBB
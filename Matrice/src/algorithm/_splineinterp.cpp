@@ -16,6 +16,7 @@ You should have received a copy of the GNU General Public License
 along with this program.If not, see <http://www.gnu.org/licenses/>.
 **************************************************************************/
 #include "algs/interpolation/_splineinterp.h"
+#include "algs/interpolation/_spline_prefilter.h"
 
 MATRICE_ALGS_BEGIN
 
@@ -86,9 +87,50 @@ template<typename _Ty> struct _It_hypar_7 : _Itpar_base<_Ty> {
 	}
 };
 
+/**
+ * \brief Cache-blocked prefilter shared by all spline kernels. The coeffs.
+ * of double images are computed in single precision if the 32-bit mode 
+ * MATRICE_SPLINE_PREFILTER_F32 is enabled.
+ */
+template<typename _Ty, size_t _Np>
+MATRICE_HOST_INL Matrix<_Ty> _Coeff_tiled(const Matrix<_Ty>& _Data, const std::array<double, _Np>& _Poles) {
+	const auto [_Height, _Width, _] = _Data.shape();
+	Matrix<_Ty> _Mycoeff(_Height, _Width);
+#if MATRICE_SPLINE_PREFILTER_F32
+	if constexpr (!is_same_v<_Ty, float>) {
+		std::vector<float> _Buff(_Height * _Width);
+		detail::_Bspline_prefilter(_Data.data(), _Buff.data(), _Height, _Width, _Poles);
+		std::copy(_Buff.begin(), _Buff.end(), _Mycoeff.data());
+		return _Mycoeff;
+	}
+#endif
+	detail::_Bspline_prefilter(_Data.data(), _Mycoeff.data(), _Height, _Width, _Poles);
+	return _Mycoeff;
+}
+
 template<typename _Ty>
 _Spline_interpolation<_Ty, bicerp_tag>::matrix_type
 _Spline_interpolation<_Ty, bicerp_tag>::_Coeff_impl() const {
+	const auto [_Z, _A, _K] = _It_hypar_3<value_type>::value();
+	return _Coeff_tiled(*_Mybase::_Mydata, std::array<double, 1>{ _Z });
+}
+template<typename _Ty>
+_Spline_interpolation<_Ty, biqerp_tag>::matrix_type
+_Spline_interpolation<_Ty, biqerp_tag>::_Coeff_impl() const {
+	const auto [_Z1, _Z2, _A1, _A2, _K1, _K2] = _It_hypar_5<value_type>::value();
+	return _Coeff_tiled(*_Mybase::_Mydata, std::array<double, 2>{ _Z1, _Z2 });
+}
+template<typename _Ty>
+_Spline_interpolation<_Ty, biserp_tag>::matrix_type
+_Spline_interpolation<_Ty, biserp_tag>::_Coeff_impl() const {
+	const auto [_Z1, _Z2, _Z3, _A1, _A2, _A3, _K1, _K2, _K3] =
+		_It_hypar_7<value_type>::value();
+	return _Coeff_tiled(*_Mybase::_Mydata, std::array<double, 3>{ _Z1, _Z2, _Z3 });
+}
+
+template<typename _Ty>
+_Spline_interpolation<_Ty, bicerp_tag>::matrix_type
+_Spline_interpolation<_Ty, bicerp_tag>::_Coeff_ref() const {
 	const auto& _Data = *_Mybase::_Mydata;
 	const auto [_Height, _Width, _] = _Data.shape();
 
@@ -129,7 +171,7 @@ _Spline_interpolation<_Ty, bicerp_tag>::_Coeff_impl() const {
 
 template<typename _Ty> 
 _Spline_interpolation<_Ty, biqerp_tag>::matrix_type
-_Spline_interpolation<_Ty, biqerp_tag>::_Coeff_impl() const {
+_Spline_interpolation<_Ty, biqerp_tag>::_Coeff_ref() const {
 	const auto& _Data = *_Mybase::_Mydata;
 	const auto[_Height, _Width, _ph] = _Data.shape();
 
@@ -189,7 +231,7 @@ _Spline_interpolation<_Ty, biqerp_tag>::_Coeff_impl() const {
 }
 template<typename _Ty> 
 _Spline_interpolation<_Ty, biserp_tag>::matrix_type
-_Spline_interpolation<_Ty, biserp_tag>::_Coeff_impl() const {
+_Spline_interpolation<_Ty, biserp_tag>::_Coeff_ref() const {
 	const auto& _Data = *_Mybase::_Mydata;
 	const auto[_Height, _Width, _ph] = _Data.shape();
 
@@ -16,32 +16,14 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with this program.If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
-#if MATRICE_MATH_KERNEL == MATRICE_USE_MKL
-#include <fftw3_mkl.h>
-#endif
 #include "algs/transform/_fft.hpp"
 
 MATRICE_ALG_BEGIN()
 _DETAIL_BEGIN
 
-template<typename _Ty>
-_Fft_descriptor<_Ty>::status_type 
-_Fft_descriptor<_Ty>::_Forward() noexcept
-{
-	return status_type();
-}
-
-template<typename _Ty>
-_Fft_descriptor<_Ty>::status_type
-_Fft_descriptor<_Ty>::_Backward() noexcept
-{
-	return status_type();
-}
-
-template<> _Fft_descriptor<float>::status_type _Fft_descriptor<float>::_Forward() noexcept;
-template<> _Fft_descriptor<float>::status_type _Fft_descriptor<float>::_Backward() noexcept;
-template<> _Fft_descriptor<double>::status_type _Fft_descriptor<double>::_Forward() noexcept;
-template<> _Fft_descriptor<double>::status_type _Fft_descriptor<double>::_Backward() noexcept;
+// \the descriptor is implemented inline on the native engine 'fft_engine'.
+template class _Fft_descriptor<float>;
+template class _Fft_descriptor<double>;
 
 _DETAIL_END
-MATRICE_ALG_END()
\ No newline at end of file
+MATRICE_ALG_END()
@@ -0,0 +1,73 @@
+/*********************************************************************
+This file is part of Matrice, an effcient and elegant C++ library.
+Copyright(C) 2018-2021, Zhilong(Dgelom) Su, all rights reserved.
+
+This program is free software : you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or (at
+your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.If not, see <http://www.gnu.org/licenses/>.
+***********************************************************************/
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "io/_binary_file.hpp"
+
+DGE_MATRICE_BEGIN namespace io { _DETAIL_BEGIN
+MATRICE_HOST_ONLY bool _Mapped_file::open(const path_t& _Path) {
+	close();
+#ifdef _WIN32
+	const auto _File = CreateFileW(_Path.wstring().c_str(), GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (_File == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER _Size;
+	if (GetFileSizeEx(_File, &_Size) && _Size.QuadPart > 0) {
+		if (const auto _Map = CreateFileMappingW(_File, nullptr, PAGE_READONLY, 0, 0, nullptr); _Map) {
+			_Mydata = MapViewOfFile(_Map, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(_Map);
+		}
+		if (_Mydata) _Mysize = size_t(_Size.QuadPart);
+	}
+	CloseHandle(_File);
+#else
+	const auto _File = ::open(_Path.c_str(), O_RDONLY);
+	if (_File < 0) return false;
+	struct stat _Stat;
+	if (fstat(_File, &_Stat) == 0 && _Stat.st_size > 0) {
+		const auto _Ptr = mmap(nullptr, size_t(_Stat.st_size), PROT_READ, MAP_SHARED, _File, 0);
+		if (_Ptr != MAP_FAILED) _Mydata = _Ptr, _Mysize = size_t(_Stat.st_size);
+	}
+	::close(_File);
+#endif
+	return _Mydata != nullptr;
+}
+
+MATRICE_HOST_ONLY void _Mapped_file::close() noexcept {
+	if (_Mydata) {
+#ifdef _WIN32
+		UnmapViewOfFile(_Mydata);
+#else
+		munmap(_Mydata, _Mysize);
+#endif
+	}
+	_Mydata = nullptr, _Mysize = 0;
+}
+_DETAIL_END } DGE_MATRICE_END
@@ -19,34 +19,227 @@ along with this program.If not, see <http://www.gnu.org/licenses/>.
 #include "io/io.hpp"
 #include "io/_tiff_wrapper.hpp"
 
+// \brief Min. number of pixels to decode the strips (tiles) of a TIFF in parallel.
+#ifndef MATRICE_TIFF_PARALLEL_THRESHOLD
+#define MATRICE_TIFF_PARALLEL_THRESHOLD (1 << 20)
+#endif
+
 DGE_MATRICE_BEGIN
 inline tiff_pointer open_tiff_file(const char* fname, const char* flag) {
 	return TIFFOpen(fname, flag);
 }
 
-MATRICE_HOST_ONLY image_instance read_tiff_file(const char* fpath) {
-	image_instance inst;
-	if (const auto ptif = open_tiff_file(fpath, "r"); ptif) {
-		TIFFGetField(ptif, TIFFTAG_IMAGELENGTH, &inst.m_rows);
-		TIFFGetField(ptif, TIFFTAG_IMAGEWIDTH, &inst.m_cols);
-		const auto scanline = TIFFScanlineSize(ptif);
-		inst.create(scanline / inst.m_cols);
-
-		auto buf = (uint8_t*)_TIFFmalloc(scanline * sizeof(uint8_t));
-		for (auto row = 0; row < inst.m_rows; ++row) {
-			TIFFReadScanline(ptif, buf, row);
-			auto pd = inst.m_data.data() + (row * inst.m_width);
-			for (auto col = 0; col < inst.m_cols; ++col) {
-				auto pb = buf + col * inst.m_nchs;
-				for (auto chn = 0; chn < inst.m_nchs; ++chn) {
-					pd[col + chn * inst.m_cols] = pb[chn];
+_DETAIL_BEGIN
+/**
+ *\brief Read the header of an opened TIFF.
+ */
+inline tiff_info _Tiff_info(tiff_pointer _Tif) {
+	tiff_info _Info;
+	TIFFGetField(_Tif, TIFFTAG_IMAGELENGTH, &_Info.rows);
+	TIFFGetField(_Tif, TIFFTAG_IMAGEWIDTH, &_Info.cols);
+	TIFFGetFieldDefaulted(_Tif, TIFFTAG_SAMPLESPERPIXEL, &_Info.nchs);
+	TIFFGetFieldDefaulted(_Tif, TIFFTAG_BITSPERSAMPLE, &_Info.bits);
+	TIFFGetFieldDefaulted(_Tif, TIFFTAG_SAMPLEFORMAT, &_Info.format);
+	_Info.tiled = TIFFIsTiled(_Tif) != 0;
+	return _Info;
+}
+
+/**
+ *\brief Convert '_Npx' pixels of '_Nchs' interleaved samples to the
+         destination, where the c-th channel is written to '_Dst+c*_Ldc'.
+ *\note  '_Scale' normalizes integer samples to [0, 1] for a floating-point
+         destination, and '_Shift' drops the low bits of the samples for a
+         narrower integer destination. The single channel loops have no
+         strides and are left to the compiler to vectorize.
+ */
+template<typename _Sty, typename _Dty>
+MATRICE_HOST_FINL void _Tiff_convert(const _Sty* _Src, size_t _Npx, size_t _Nchs,
+	_Dty* _Dst, size_t _Ldc, _Dty _Scale, int _Shift) noexcept {
+	if constexpr (is_floating_point_v<_Dty>) {
+		if (_Nchs == 1) for (size_t i = 0; i < _Npx; ++i)
+			_Dst[i] = _Dty(_Src[i]) * _Scale;
+		else for (size_t c = 0; c < _Nchs; ++c) {
+			const auto _Dc = _Dst + c * _Ldc;
+			for (size_t i = 0; i < _Npx; ++i)
+				_Dc[i] = _Dty(_Src[i * _Nchs + c]) * _Scale;
+		}
+	}
+	else {
+		if (_Nchs == 1) for (size_t i = 0; i < _Npx; ++i)
+			_Dst[i] = _Dty(_Src[i] >> _Shift);
+		else for (size_t c = 0; c < _Nchs; ++c) {
+			const auto _Dc = _Dst + c * _Ldc;
+			for (size_t i = 0; i < _Npx; ++i)
+				_Dc[i] = _Dty(_Src[i * _Nchs + c] >> _Shift);
+		}
+	}
+}
+
+/**
+ *\brief Decode a TIFF into a row-major buffer of 'rows' x 'cols*nchs',
+         where the channels of a row are stored one after another as the
+         image_instance does. The strips (tiles) are decoded in parallel,
+         each thread works on its own handle of the file since a libtiff
+         handle cannot be shared. A strip is decoded straight into the
+         destination if it needs no conversion, otherwise it's decoded into
+         a thread-local buffer and converted on the fly.
+ *\param [_Norm] if normalize integer samples for a floating-point '_Dty'.
+ */
+template<typename _Dty>
+tiff_info _Tiff_decode(const char* _Path, _Dty* _Dst, const tiff_info& _Info, bool _Norm) {
+	const size_t _Rows = _Info.rows, _Cols = _Info.cols, _Nchs = _Info.nchs;
+	const auto _Ld = _Cols * _Nchs;
+	const auto _Bytes = size_t(_Info.bits) >> 3;
+	const auto _Fmt = _Info.format;
+
+	DGELOM_CHECK(_Info.bits == 8 || _Info.bits == 16 || _Info.bits == 32,
+		"Only 8, 16 and 32 bit TIFF samples are supported.");
+	DGELOM_CHECK(_Fmt != SAMPLEFORMAT_INT && _Fmt != SAMPLEFORMAT_COMPLEXINT && _Fmt != SAMPLEFORMAT_COMPLEXIEEEFP,
+		"Only unsigned integer and floating-point TIFF samples are supported.");
+	DGELOM_CHECK(_Fmt != SAMPLEFORMAT_IEEEFP || is_floating_point_v<_Dty>,
+		"Floating-point TIFF samples require a floating-point destination.");
+	DGELOM_CHECK(_Fmt != SAMPLEFORMAT_IEEEFP || _Info.bits == 32,
+		"Only 32 bit floating-point TIFF samples are supported.");
+
+	const auto _Scale = (is_floating_point_v<_Dty> && _Norm && _Fmt != SAMPLEFORMAT_IEEEFP) ?
+		_Dty(1. / ((uint64_t(1) << _Info.bits) - 1)) : _Dty(1);
+	const auto _Shift = is_floating_point_v<_Dty> ? 0 :
+		(MATRICE_STD(max))(0, (int(_Bytes) - int(sizeof(_Dty))) * 8);
+	const auto _Direct = _Scale == _Dty(1) && _Shift == 0 && _Bytes == sizeof(_Dty) &&
+		(_Fmt == SAMPLEFORMAT_IEEEFP) == is_floating_point_v<_Dty>;
+
+	// \convert '_Npx' pixels of the sample buffer '_Buf' to '_Dst'
+	const auto _Convert = [&](const uint8_t* _Buf, size_t _Npx, size_t _Nc, _Dty* _Dp) {
+		if (_Fmt == SAMPLEFORMAT_IEEEFP) {
+			if constexpr (is_floating_point_v<_Dty>)
+				_Tiff_convert((const float*)_Buf, _Npx, _Nc, _Dp, _Cols, _Scale, 0);
+		}
+		else if (_Bytes == 1)
+			_Tiff_convert((const uint8_t*)_Buf, _Npx, _Nc, _Dp, _Cols, _Scale, _Shift);
+		else if (_Bytes == 2)
+			_Tiff_convert((const uint16_t*)_Buf, _Npx, _Nc, _Dp, _Cols, _Scale, _Shift);
+		else
+			_Tiff_convert((const uint32_t*)_Buf, _Npx, _Nc, _Dp, _Cols, _Scale, _Shift);
+	};
+
+	uint16_t _Planar = PLANARCONFIG_CONTIG;
+	uint32_t _Tw = _Info.cols, _Th = 0;
+	size_t _Nchunks = 0, _Bufsize = 0;
+	if (const auto _Tif = open_tiff_file(_Path, "r"); _Tif) {
+		TIFFGetFieldDefaulted(_Tif, TIFFTAG_PLANARCONFIG, &_Planar);
+		if (_Info.tiled) {
+			TIFFGetField(_Tif, TIFFTAG_TILEWIDTH, &_Tw);
+			TIFFGetField(_Tif, TIFFTAG_TILELENGTH, &_Th);
+			_Nchunks = TIFFNumberOfTiles(_Tif);
+			_Bufsize = TIFFTileSize(_Tif);
+		}
+		else {
+			TIFFGetFieldDefaulted(_Tif, TIFFTAG_ROWSPERSTRIP, &_Th);
+			_Th = (MATRICE_STD(min))(_Th, _Info.rows);
+			_Nchunks = TIFFNumberOfStrips(_Tif);
+			_Bufsize = TIFFStripSize(_Tif);
+		}
+		TIFFClose(_Tif);
+	}
+	if (_Nchunks == 0) return tiff_info{};
+
+	// \chunks of a plane and the number of samples per pixel in a chunk
+	const auto _Separate = _Planar == PLANARCONFIG_SEPARATE && _Nchs > 1;
+	const auto _Nc = _Separate ? size_t(1) : _Nchs;
+	const auto _Nplane = _Separate ? _Nchunks / _Nchs : _Nchunks;
+	const auto _Ntx = (_Cols + _Tw - 1) / _Tw;
+	const auto _Parallel = _Nchunks > 1 && _Rows * _Cols >= MATRICE_TIFF_PARALLEL_THRESHOLD;
+
+	index_t _Failed = 0;
+#pragma omp parallel if(_Parallel) reduction(+:_Failed)
+	{
+		const auto _Tif = open_tiff_file(_Path, "r");
+		MATRICE_STD(vector)<uint8_t> _Buf;
+		if (!_Tif) ++_Failed;
+		else _Buf.resize(_Bufsize);
+
+#pragma omp for schedule(dynamic)
+		for (index_t _Idx = 0; _Idx < index_t(_Nchunks); ++_Idx) {
+			if (!_Tif) continue;
+			const auto _Plane = size_t(_Idx) / _Nplane, _Chunk = size_t(_Idx) % _Nplane;
+			const auto _Y = _Chunk / _Ntx * _Th, _X = _Chunk % _Ntx * _Tw;
+			const auto _H = (MATRICE_STD(min))(size_t(_Th), _Rows - _Y);
+			const auto _W = (MATRICE_STD(min))(size_t(_Tw), _Cols - _X);
+			const auto _Dp = _Dst + _Y * _Ld + _Plane * _Cols + _X;
+
+			if (!_Info.tiled) {
+				const auto _Size = tmsize_t(_H * _Ld * _Bytes / _Nchs * _Nc);
+				// \zero-copy, the strip has the same layout as the destination
+				if (_Direct && _Nchs == 1) {
+					if (TIFFReadEncodedStrip(_Tif, uint32_t(_Idx), _Dp, _Size) < 0) ++_Failed;
+					continue;
+				}
+				if (TIFFReadEncodedStrip(_Tif, uint32_t(_Idx), _Buf.data(), _Size) < 0) {
+					++_Failed; continue;
+				}
+				for (size_t r = 0; r < _H; ++r)
+					_Convert(_Buf.data() + r * _Cols * _Nc * _Bytes, _Cols, _Nc, _Dp + r * _Ld);
+			}
+			else {
+				if (TIFFReadEncodedTile(_Tif, uint32_t(_Idx), _Buf.data(), tmsize_t(_Bufsize)) < 0) {
+					++_Failed; continue;
 				}
+				for (size_t r = 0; r < _H; ++r)
+					_Convert(_Buf.data() + r * _Tw * _Nc * _Bytes, _W, _Nc, _Dp + r * _Ld);
 			}
 		}
+		if (_Tif) TIFFClose(_Tif);
+	}
+	DGELOM_CHECK(_Failed == 0, "Failed to decode the TIFF file " + MATRICE_STD(string)(_Path));
+
+	return (_Info);
+}
+
+template<typename _Ty>
+tiff_info _Read_tiff_file(const char* _Path, Matrix<_Ty>& _Dst, bool _Norm) {
+	tiff_info _Info;
+	if (const auto _Tif = open_tiff_file(_Path, "r"); _Tif) {
+		_Info = _Tiff_info(_Tif);
+		TIFFClose(_Tif);
+	}
+	if (_Info.rows == 0 || _Info.cols == 0) return tiff_info{};
+
+	const auto _Width = _Info.cols * _Info.nchs;
+	if (size_t(_Dst.rows()) != _Info.rows || size_t(_Dst.cols()) != _Width)
+		_Dst.create(_Info.rows, _Width);
+	return _Tiff_decode(_Path, _Dst.data(), _Info, _Norm);
+}
+_DETAIL_END
 
-		_TIFFfree(buf);
+MATRICE_HOST_ONLY tiff_info read_tiff_info(const char* fpath) {
+	tiff_info info;
+	if (const auto ptif = open_tiff_file(fpath, "r"); ptif) {
+		info = detail::_Tiff_info(ptif);
 		TIFFClose(ptif);
 	}
+	return info;
+}
+
+MATRICE_HOST_ONLY image_instance read_tiff_file(const char* fpath) {
+	image_instance inst;
+	if (const auto info = read_tiff_info(fpath); info.rows && info.cols) {
+		inst.m_rows = info.rows, inst.m_cols = info.cols;
+		inst.create(info.nchs);
+		detail::_Tiff_decode(fpath, inst.m_data.data(), info, false);
+	}
 	return forward<decltype(inst)>(inst);
 }
-DGE_MATRICE_END
\ No newline at end of file
+
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<uint8_t>& dst) {
+	return detail::_Read_tiff_file(fpath, dst, false);
+}
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<uint16_t>& dst) {
+	return detail::_Read_tiff_file(fpath, dst, false);
+}
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<float>& dst, bool normalize) {
+	return detail::_Read_tiff_file(fpath, dst, normalize);
+}
+MATRICE_HOST_ONLY tiff_info read_tiff_file(const char* fpath, Matrix<double>& dst, bool normalize) {
+	return detail::_Read_tiff_file(fpath, dst, normalize);
+}
+DGE_MATRICE_END